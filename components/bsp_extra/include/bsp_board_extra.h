@@ -185,6 +185,17 @@ esp_err_t bsp_extra_player_play_index(file_iterator_instance_t *instance, int in
  */
 esp_err_t bsp_extra_player_play_file(const char *file_path);
 
+/**
+ * @brief Play audio held in memory, such as a sound in a memory mapped partition
+ *
+ * @param data Encoded audio, must stay valid until playback ends.
+ * @param size Size of data in bytes.
+ * @return
+ *     - ESP_OK: Successfully started playing the audio.
+ *     - ESP_FAIL: Failed to play the audio.
+ */
+esp_err_t bsp_extra_player_play_buffer(const void *data, size_t size);
+
 /**
  * @brief Register a callback function for the audio player
  *
@@ -6,6 +6,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 #include "esp_log.h"
 #include "esp_check.h"
@@ -242,6 +243,20 @@ esp_err_t bsp_extra_player_play_file(const char *file_path)
     return ESP_OK;
 }
 
+esp_err_t bsp_extra_player_play_buffer(const void *data, size_t size)
+{
+    /* The player reads through a FILE, a memory stream over the buffer spares copying it */
+    FILE *fp = fmemopen((void *)data, size, "rb");
+    ESP_RETURN_ON_FALSE(fp, ESP_FAIL, TAG, "unable to open buffer");
+
+    ESP_LOGI(TAG, "Playing %u bytes from memory", (unsigned)size);
+    ESP_RETURN_ON_ERROR(audio_player_play(fp), TAG, "audio_player_play failed");
+
+    audio_file_path[0] = '\0';
+
+    return ESP_OK;
+}
+
 void bsp_extra_player_register_callback(audio_player_cb_t cb, void *user_data)
 {
     audio_idle_callback = cb;
@@ -0,0 +1,184 @@
+#pragma once
+#ifndef ASSETPACKER_HPP
+#define ASSETPACKER_HPP
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "AssetBundle.hpp"
+
+// The packing side of main/AssetBundle.hpp, shared by asset_pack and its round-trip test: LVGL image parsing, the
+// RLE encoder and the bundle layout. Everything here works in memory, asset_pack does the file IO.
+
+struct color_format_t {
+    const char *name;
+    uint8_t value;
+    uint8_t unit; // bytes per pixel, 1 for formats below a byte or with a separate alpha plane
+};
+
+// The lv_color_format_t values of LVGL 9
+static constexpr color_format_t COLOR_FORMATS[] = {
+    {"L8", 0x06, 1},       {"I1", 0x07, 1},       {"I2", 0x08, 1},       {"I4", 0x09, 1},
+    {"I8", 0x0A, 1},       {"A8", 0x0E, 1},       {"RGB888", 0x0F, 3},   {"ARGB8888", 0x10, 4},
+    {"XRGB8888", 0x11, 4}, {"RGB565", 0x12, 2},   {"RGB565A8", 0x14, 1}, {"AL88", 0x15, 2},
+};
+
+inline auto FindFormat(uint8_t value) -> const color_format_t * {
+    for (const color_format_t &format : COLOR_FORMATS) {
+        if (format.value == value) {
+            return &format;
+        }
+    }
+    return nullptr;
+}
+
+inline auto FindFormat(const std::string &name) -> const color_format_t * {
+    for (const color_format_t &format : COLOR_FORMATS) {
+        if (name == format.name) {
+            return &format;
+        }
+    }
+    return nullptr;
+}
+
+struct pending_asset_t {
+    std::string name;
+    asset_entry_t entry{};
+    std::vector<uint8_t> data;
+};
+
+// Value of "<key> = N" in an LVGL C export, -1 if missing
+inline auto ExportNumber(const std::string &text, const char *key) -> long {
+    size_t at = text.find(key);
+    if (at == std::string::npos) {
+        return -1;
+    }
+    at = text.find('=', at);
+    return at == std::string::npos ? -1 : strtol(text.c_str() + at + 1, nullptr, 0);
+}
+
+// LVGL C export: the bytes of the *_map[] array and the .header fields of the descriptor
+inline auto ParseImageExport(const std::vector<uint8_t> &file, pending_asset_t &asset) -> bool {
+    std::string text(file.begin(), file.end());
+    size_t map = text.find("_map[]");
+    size_t open = map == std::string::npos ? map : text.find('{', map);
+    size_t close = open == std::string::npos ? open : text.find("};", open);
+    if (close == std::string::npos) {
+        return false;
+    }
+    for (size_t at = text.find("0x", open); at < close; at = text.find("0x", at)) {
+        char *end;
+        asset.data.push_back(static_cast<uint8_t>(strtoul(text.c_str() + at, &end, 16)));
+        at = static_cast<size_t>(end - text.c_str());
+    }
+
+    size_t cf = text.find("LV_COLOR_FORMAT_", close);
+    if (cf == std::string::npos) {
+        return false;
+    }
+    cf += strlen("LV_COLOR_FORMAT_");
+    const color_format_t *format = FindFormat(text.substr(cf, text.find_first_of(" ,\r\n", cf) - cf));
+    long width = ExportNumber(text.substr(close), ".header.w");
+    long height = ExportNumber(text.substr(close), ".header.h");
+    long stride = ExportNumber(text.substr(close), ".header.stride");
+    if (!format || width <= 0 || height <= 0) {
+        return false;
+    }
+    asset.entry.color_format = format->value;
+    asset.entry.unit = format->unit;
+    asset.entry.width = static_cast<uint16_t>(width);
+    asset.entry.height = static_cast<uint16_t>(height);
+    asset.entry.stride = static_cast<uint32_t>(stride > 0 ? stride : width * format->unit);
+    return true;
+}
+
+// LVGL binary image: lv_image_header_t (magic, cf, flags, w, h, stride, reserved) then the pixels
+inline auto ParseImageBinary(const std::vector<uint8_t> &file, pending_asset_t &asset) -> bool {
+    if (file.size() < 12 || file[0] != 0x19) {
+        return false;
+    }
+    const color_format_t *format = FindFormat(file[1]);
+    if (!format) {
+        return false;
+    }
+    auto u16 = [&](size_t at) { return static_cast<uint16_t>(file[at] | (file[at + 1] << 8)); };
+    asset.entry.color_format = format->value;
+    asset.entry.unit = format->unit;
+    asset.entry.width = u16(4);
+    asset.entry.height = u16(6);
+    asset.entry.stride = u16(8);
+    asset.data.assign(file.begin() + 12, file.end());
+    return true;
+}
+
+inline auto RleEncode(const std::vector<uint8_t> &raw, uint8_t unit) -> std::vector<uint8_t> {
+    std::vector<uint8_t> out;
+    size_t count = raw.size() / unit;
+    auto same = [&](size_t a, size_t b) { return memcmp(&raw[a * unit], &raw[b * unit], unit) == 0; };
+    size_t i = 0;
+    while (i < count) {
+        size_t run = 1;
+        while (i + run < count && run < 128 && same(i, i + run)) {
+            run++;
+        }
+        if (run >= 2) {
+            out.push_back(static_cast<uint8_t>(0x80 | (run - 1)));
+            out.insert(out.end(), raw.begin() + i * unit, raw.begin() + (i + 1) * unit);
+            i += run;
+            continue;
+        }
+        // Literals up to the next pair of equal elements
+        size_t literal = 1;
+        while (i + literal < count && literal < 128) {
+            if (i + literal + 1 < count && same(i + literal, i + literal + 1)) {
+                break;
+            }
+            literal++;
+        }
+        out.push_back(static_cast<uint8_t>(literal - 1));
+        out.insert(out.end(), raw.begin() + i * unit, raw.begin() + (i + literal) * unit);
+        i += literal;
+    }
+    return out;
+}
+
+// Fills in what the entry says about the stored bytes of an asset whose data is loaded: raw size, codec, size and
+// CRC. With rle an image is stored RLE packed when that makes it smaller.
+inline auto EncodeAsset(pending_asset_t &asset, bool rle) -> void {
+    asset.entry.raw_size = static_cast<uint32_t>(asset.data.size());
+    if (asset.entry.kind == AssetKind::IMAGE && rle) {
+        std::vector<uint8_t> packed = RleEncode(asset.data, asset.entry.unit);
+        if (packed.size() < asset.data.size()) {
+            asset.data = std::move(packed);
+            asset.entry.codec = AssetCodec::RLE;
+        }
+    }
+    asset.entry.size = static_cast<uint32_t>(asset.data.size());
+    asset.entry.crc = Crc32(asset.data.data(), asset.data.size());
+}
+
+// Lays the encoded assets out as a bundle, filling in their offsets and names
+inline auto PackBundle(std::vector<pending_asset_t> &assets) -> std::vector<uint8_t> {
+    std::vector<uint8_t> bundle(sizeof(asset_bundle_header_t) + assets.size() * sizeof(asset_entry_t));
+    std::vector<asset_entry_t> index;
+    for (pending_asset_t &asset : assets) {
+        bundle.resize((bundle.size() + ASSET_ALIGN - 1) / ASSET_ALIGN * ASSET_ALIGN);
+        asset.entry.offset = static_cast<uint32_t>(bundle.size());
+        asset.name.copy(asset.entry.name.data(), ASSET_NAME_SIZE - 1);
+        bundle.insert(bundle.end(), asset.data.begin(), asset.data.end());
+        index.push_back(asset.entry);
+    }
+    asset_bundle_header_t header{};
+    header.magic = ASSET_BUNDLE_MAGIC;
+    header.version = ASSET_BUNDLE_VERSION;
+    header.count = static_cast<uint16_t>(index.size());
+    header.size = static_cast<uint32_t>(bundle.size());
+    header.index_crc = Crc32(index.data(), index.size() * sizeof(asset_entry_t));
+    memcpy(bundle.data(), &header, sizeof(header));
+    memcpy(bundle.data() + sizeof(header), index.data(), index.size() * sizeof(asset_entry_t));
+    return bundle;
+}
+
+#endif
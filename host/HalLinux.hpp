@@ -0,0 +1,140 @@
+#pragma once
+#ifndef HALLINUX_HPP
+#define HALLINUX_HPP
+
+#include <chrono>
+#include <stdint.h>
+#include <thread>
+
+#if __has_include("lvgl.h")
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "lvgl.h"
+#endif
+
+namespace hal {
+
+using task_fn_t = void (*)(void *);
+
+inline auto NowUs() -> int64_t {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+inline auto SleepMs(uint32_t ms) -> void {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Nanoseconds stand in for cycles, perf gives the real counts on the host
+inline auto CycleCount() -> uint32_t {
+    using namespace std::chrono;
+    return static_cast<uint32_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+// Stack, priority and core only mean something on the device
+inline auto TaskCreate(task_fn_t fn, const char * /*name*/, uint32_t /*stack_bytes*/, void *arg,
+                       uint32_t /*priority*/, int /*core*/) -> bool {
+    std::thread(fn, arg).detach();
+    return true;
+}
+
+#if __has_include("lvgl.h")
+
+// What the headless display was asked to draw, the host stand-in for watching the panel
+struct host_display_stats_t {
+    uint32_t refreshes = 0;
+    uint32_t flushes = 0;
+    uint64_t pixels = 0;
+};
+
+namespace detail {
+
+static constexpr int32_t DISPLAY_SIZE = 720;
+static constexpr int32_t DRAW_BUF_LINES = 72;
+
+inline auto DisplayMutex() -> std::recursive_timed_mutex & {
+    static std::recursive_timed_mutex mutex;
+    return mutex;
+}
+
+inline auto DisplayStats() -> host_display_stats_t & {
+    static host_display_stats_t stats;
+    return stats;
+}
+
+inline auto HeadlessFlush(lv_display_t *display, const lv_area_t *area, uint8_t * /*px_map*/) -> void {
+    host_display_stats_t &stats = DisplayStats();
+    stats.flushes++;
+    stats.pixels += static_cast<uint64_t>(lv_area_get_width(area)) * lv_area_get_height(area);
+    if (lv_display_flush_is_last(display)) {
+        stats.refreshes++;
+    }
+    lv_display_flush_ready(display);
+}
+
+inline auto TickMs() -> uint32_t {
+    return static_cast<uint32_t>(NowUs() / 1000);
+}
+
+// Same job as the esp_lvgl_port task on the device
+inline auto LvglTask(void * /*arg*/) -> void {
+    while (true) {
+        uint32_t wait_ms = 5;
+        {
+            std::lock_guard<std::recursive_timed_mutex> lock(DisplayMutex());
+            wait_ms = lv_timer_handler();
+        }
+        SleepMs(wait_ms < 1 ? 1 : (wait_ms > 30 ? 30 : wait_ms));
+    }
+}
+
+} // namespace detail
+
+// background: the screen starts out showing this image instead of black
+inline auto DisplayInit(const lv_image_dsc_t *background = nullptr) -> void {
+    std::lock_guard<std::recursive_timed_mutex> lock(detail::DisplayMutex());
+    lv_init();
+    lv_tick_set_cb(detail::TickMs);
+#if LV_USE_SDL
+    lv_sdl_window_create(detail::DISPLAY_SIZE, detail::DISPLAY_SIZE);
+#else
+    static std::vector<uint8_t> draw_buf(detail::DISPLAY_SIZE * detail::DRAW_BUF_LINES *
+                                         LV_COLOR_FORMAT_GET_SIZE(LV_COLOR_FORMAT_RGB565));
+    lv_display_t *display = lv_display_create(detail::DISPLAY_SIZE, detail::DISPLAY_SIZE);
+    lv_display_set_color_format(display, LV_COLOR_FORMAT_RGB565);
+    lv_display_set_buffers(display, draw_buf.data(), nullptr, draw_buf.size(), LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(display, detail::HeadlessFlush);
+#endif
+    lv_obj_remove_flag(lv_screen_active(), LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_size(lv_screen_active(), detail::DISPLAY_SIZE, detail::DISPLAY_SIZE);
+    lv_obj_set_style_bg_color(lv_screen_active(), lv_color_hex(0x000000), 0);
+    if (background) {
+        lv_obj_set_style_bg_image_src(lv_screen_active(), background, 0);
+    }
+    TaskCreate(detail::LvglTask, "LVGL", 0, nullptr, 0, 0);
+}
+
+inline auto DisplayLock(uint32_t timeout_ms) -> bool {
+    if (timeout_ms == 0) {
+        detail::DisplayMutex().lock();
+        return true;
+    }
+    return detail::DisplayMutex().try_lock_for(std::chrono::milliseconds(timeout_ms));
+}
+
+inline auto DisplayUnlock() -> void {
+    detail::DisplayMutex().unlock();
+}
+
+// Take the display lock while reading
+inline auto DisplayStats() -> host_display_stats_t {
+    return detail::DisplayStats();
+}
+
+#endif
+
+} // namespace hal
+
+#endif
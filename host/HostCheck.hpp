@@ -0,0 +1,44 @@
+#pragma once
+#ifndef HOSTCHECK_HPP
+#define HOSTCHECK_HPP
+
+#include <stdio.h>
+
+// Checks for the host tests (ctest in the host build). A failed check prints where and what and the test carries
+// on, main returns host_check::Result() so ctest sees the failure.
+namespace host_check {
+
+inline auto Failures() -> int & {
+    static int failures = 0;
+    return failures;
+}
+
+inline auto Fail(const char *file, int line, const char *what) -> void {
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    Failures()++;
+}
+
+inline auto Equal(const char *file, int line, const char *what, long long actual, long long expected) -> void {
+    if (actual != expected) {
+        fprintf(stderr, "%s:%d: check failed: %s, got %lld, expected %lld\n", file, line, what, actual, expected);
+        Failures()++;
+    }
+}
+
+inline auto Result(const char *name) -> int {
+    if (Failures()) {
+        fprintf(stderr, "%s: %d checks failed\n", name, Failures());
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+} // namespace host_check
+
+#define CHECK(expr) ((expr) ? (void)0 : host_check::Fail(__FILE__, __LINE__, #expr))
+#define CHECK_EQ(actual, expected)                                                                                  \
+    host_check::Equal(__FILE__, __LINE__, #actual " == " #expected, static_cast<long long>(actual),                 \
+                      static_cast<long long>(expected))
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef HOSTTRACE_HPP
+#define HOSTTRACE_HPP
+
+#include <memory>
+#include <string.h>
+
+#include "TraceSource.hpp"
+
+// Opens a trace by file name: *.bin is a storage partition image written by FlightRecorder, anything else is
+// read as a candump log
+class HostTrace {
+  private:
+    std::unique_ptr<FlightLogFile> image;
+    std::unique_ptr<TraceSource> source;
+
+  public:
+    explicit HostTrace(const char *path) {
+        size_t len = strlen(path);
+        if (len > 4 && strcmp(path + len - 4, ".bin") == 0) {
+            image = std::make_unique<FlightLogFile>(path);
+            if (image->BlockCount()) {
+                source = std::make_unique<FlightLogSource>(*image);
+            }
+        } else {
+            auto candump = std::make_unique<CandumpSource>(path);
+            if (candump->IsOpen()) {
+                source = std::move(candump);
+            }
+        }
+    }
+
+    // nullptr when the file could not be opened
+    [[nodiscard]] auto Source() const -> TraceSource * {
+        return source.get();
+    }
+};
+
+#endif
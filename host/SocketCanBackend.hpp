@@ -0,0 +1,104 @@
+#pragma once
+#ifndef SOCKETCANBACKEND_HPP
+#define SOCKETCANBACKEND_HPP
+
+#include <errno.h>
+// struct can_filter of the kernel header would clash with the can_filter namespace of CanFilter.hpp, filtering
+// stays in CanReceiver so the kernel one is never used here
+#define can_filter linux_can_filter
+#include <linux/can.h>
+#undef can_filter
+#include <net/if.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+
+#include "CanRxBackend.hpp"
+#include "Hal.hpp"
+
+// Live frames from a SocketCAN interface (vcan0 with canplayer, or a USB adapter) as one receive bus
+class SocketCanBackend : public CanRxBackend {
+  private:
+    int fd = -1;
+    uint8_t bus;
+    can_rx_ring_t ring;
+
+    auto ReadPending() -> void {
+        struct can_frame raw {};
+        while (read(fd, &raw, sizeof(raw)) == static_cast<ssize_t>(sizeof(raw))) {
+            can_frame_t *slot = ring.Reserve();
+            if (!slot) {
+                continue;
+            }
+            slot->timestamp_us = hal::NowUs();
+            slot->extd = raw.can_id & CAN_EFF_FLAG;
+            slot->rtr = raw.can_id & CAN_RTR_FLAG;
+            slot->identifier = raw.can_id & (slot->extd ? CAN_EFF_MASK : CAN_SFF_MASK);
+            slot->dlc = raw.len > 8 ? 8 : raw.len;
+            slot->bus = bus;
+            memcpy(slot->data, raw.data, sizeof(slot->data));
+            ring.Commit();
+        }
+    }
+
+  public:
+    SocketCanBackend(const char *interface, uint8_t bus) : bus(bus) {
+        fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK, CAN_RAW);
+        if (fd < 0) {
+            ESP_LOGE("CAN FATAL", "Failed to open a CAN socket: %s", strerror(errno));
+            return;
+        }
+        struct ifreq request {};
+        strncpy(request.ifr_name, interface, IFNAMSIZ - 1);
+        struct sockaddr_can address {};
+        address.can_family = AF_CAN;
+        if (ioctl(fd, SIOCGIFINDEX, &request) < 0) {
+            ESP_LOGE("CAN FATAL", "No CAN interface %s: %s", interface, strerror(errno));
+            close(fd);
+            fd = -1;
+            return;
+        }
+        address.can_ifindex = request.ifr_ifindex;
+        if (bind(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0) {
+            ESP_LOGE("CAN FATAL", "Failed to bind %s: %s", interface, strerror(errno));
+            close(fd);
+            fd = -1;
+        }
+    }
+    ~SocketCanBackend() override {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    SocketCanBackend(const SocketCanBackend &) = delete;
+    auto operator=(const SocketCanBackend &) -> SocketCanBackend & = delete;
+
+    [[nodiscard]] auto IsOpen() const -> bool {
+        return fd >= 0;
+    }
+
+    auto WaitForFrames(uint32_t timeout_ms) -> bool override {
+        if (fd < 0) {
+            hal::SleepMs(timeout_ms);
+            return false;
+        }
+        ReadPending();
+        if (ring.Size() == 0) {
+            struct pollfd waiter = {.fd = fd, .events = POLLIN, .revents = 0};
+            if (poll(&waiter, 1, static_cast<int>(timeout_ms)) > 0) {
+                ReadPending();
+            }
+        }
+        return ring.Size() != 0;
+    }
+
+    auto Ring() -> can_rx_ring_t & override {
+        return ring;
+    }
+};
+
+#endif
@@ -0,0 +1,212 @@
+// Asset bundles from asset_pack's side to the dash's: images parsed from LVGL exports, RLE packed, laid out by
+// PackBundle, then attached, looked up, verified and decoded with main/AssetBundle.hpp the way AssetStore does.
+// The RLE code is checked at its run and literal limits and on every element size, and damage has to be caught.
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "AssetBundle.hpp"
+#include "AssetPacker.hpp"
+#include "HostCheck.hpp"
+
+static auto Decode(const std::vector<uint8_t> &packed, uint8_t unit, size_t raw_size, std::vector<uint8_t> &raw)
+    -> bool {
+    raw.assign(raw_size, 0);
+    return RleDecode(packed.data(), packed.size(), unit, raw.data(), raw.size());
+}
+
+static auto CheckRleRoundTrip(const std::vector<uint8_t> &raw, uint8_t unit) -> void {
+    std::vector<uint8_t> packed = RleEncode(raw, unit);
+    std::vector<uint8_t> decoded;
+    CHECK(Decode(packed, unit, raw.size(), decoded));
+    CHECK(decoded == raw);
+}
+
+// Runs and literals around the 128 element limit of a control byte, then random data with runs in it
+static auto CheckRle() -> void {
+    for (uint8_t unit = 1; unit <= 4; unit++) {
+        for (size_t length : {1, 2, 127, 128, 129, 256, 257}) {
+            std::vector<uint8_t> run(length * unit, 0x5A);
+            CheckRleRoundTrip(run, unit);
+            std::vector<uint8_t> literal(length * unit);
+            for (size_t i = 0; i < literal.size(); i++) {
+                literal[i] = static_cast<uint8_t>(i / unit * 7 + i % unit);
+            }
+            CheckRleRoundTrip(literal, unit);
+        }
+    }
+    CHECK_EQ(RleEncode(std::vector<uint8_t>(128 * 2, 0), 2).size(), 1 + 2);
+    CHECK_EQ(RleEncode(std::vector<uint8_t>(129 * 2, 0), 2).size(), 2 * (1 + 2));
+
+    std::mt19937 random(24);
+    for (int i = 0; i < 500; i++) {
+        uint8_t unit = static_cast<uint8_t>(1 + random() % 4);
+        std::vector<uint8_t> raw;
+        while (raw.size() < 600 * unit) {
+            uint32_t element = random() % 4 ? random() % 3 : random();
+            size_t repeat = random() % 3 ? 1 : random() % 300;
+            for (size_t r = 0; r < repeat; r++) {
+                for (uint8_t b = 0; b < unit; b++) {
+                    raw.push_back(static_cast<uint8_t>(element >> (b * 8)));
+                }
+            }
+        }
+        CheckRleRoundTrip(raw, unit);
+    }
+
+    // Streams that do not decode to exactly the raw size
+    std::vector<uint8_t> raw(300 * 2, 0x11);
+    std::vector<uint8_t> packed = RleEncode(raw, 2);
+    std::vector<uint8_t> decoded;
+    CHECK(!Decode(packed, 2, raw.size() - 2, decoded));
+    CHECK(!Decode(packed, 2, raw.size() + 2, decoded));
+    packed.pop_back();
+    CHECK(!Decode(packed, 2, raw.size(), decoded));
+    std::vector<uint8_t> cut_literal{0x03, 1, 2, 3};
+    CHECK(!Decode(cut_literal, 1, 4, decoded));
+}
+
+// A 40x24 RGB565 image as LVGL's image converter writes it: bands of color with a noisy stripe
+static auto ImageExport(std::vector<uint8_t> &pixels) -> std::string {
+    static constexpr int WIDTH = 40;
+    static constexpr int HEIGHT = 24;
+    std::string text = "#include \"lvgl.h\"\n\nconst LV_ATTRIBUTE_MEM_ALIGN uint8_t dash_bg_map[] = {\n";
+    std::mt19937 random(7);
+    char hex[8];
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            uint16_t color = y < 8 ? 0x0000 : (y < 12 ? static_cast<uint16_t>(random()) : 0xF800);
+            for (uint8_t byte : {static_cast<uint8_t>(color), static_cast<uint8_t>(color >> 8)}) {
+                pixels.push_back(byte);
+                snprintf(hex, sizeof(hex), "0x%02x,", byte);
+                text += hex;
+            }
+        }
+        text += "\n";
+    }
+    text += "};\n\nconst lv_image_dsc_t dash_bg = {\n  .header.cf = LV_COLOR_FORMAT_RGB565,\n"
+            "  .header.magic = LV_IMAGE_HEADER_MAGIC,\n  .header.w = 40,\n  .header.h = 24,\n"
+            "  .header.stride = 80,\n  .data_size = sizeof(dash_bg_map),\n  .data = dash_bg_map,\n};\n";
+    return text;
+}
+
+// An LVGL binary image of noise, which RLE would only grow
+static auto ImageBinary(std::vector<uint8_t> &pixels) -> std::vector<uint8_t> {
+    std::vector<uint8_t> file{0x19, 0x10, 0, 0, 16, 0, 8, 0, 64, 0, 0, 0};
+    std::mt19937 random(8);
+    for (int i = 0; i < 16 * 8 * 4; i++) {
+        pixels.push_back(static_cast<uint8_t>(random()));
+    }
+    file.insert(file.end(), pixels.begin(), pixels.end());
+    return file;
+}
+
+static auto Blob(const char *name, AssetKind kind, size_t size) -> pending_asset_t {
+    pending_asset_t asset;
+    asset.name = name;
+    asset.entry.kind = kind;
+    asset.entry.unit = 1;
+    for (size_t i = 0; i < size; i++) {
+        asset.data.push_back(static_cast<uint8_t>(i * 31 + size));
+    }
+    return asset;
+}
+
+static auto CheckBundle() -> void {
+    std::vector<pending_asset_t> assets(2);
+    std::vector<uint8_t> dash_pixels;
+    std::string text = ImageExport(dash_pixels);
+    assets[0].name = "dash_bg";
+    assets[0].entry.kind = AssetKind::IMAGE;
+    CHECK(ParseImageExport(std::vector<uint8_t>(text.begin(), text.end()), assets[0]));
+    std::vector<uint8_t> noise_pixels;
+    assets[1].name = "noise";
+    assets[1].entry.kind = AssetKind::IMAGE;
+    CHECK(ParseImageBinary(ImageBinary(noise_pixels), assets[1]));
+    assets.push_back(Blob("chime", AssetKind::SOUND, 1000));
+    assets.push_back(Blob("a_name_of_19_chars_", AssetKind::FONT, 3));
+    for (pending_asset_t &asset : assets) {
+        EncodeAsset(asset, true);
+    }
+    CHECK(assets[0].entry.codec == AssetCodec::RLE);
+    CHECK(assets[1].entry.codec == AssetCodec::RAW);
+    CHECK(assets[2].entry.codec == AssetCodec::RAW);
+    std::vector<uint8_t> image = PackBundle(assets);
+
+    AssetBundle bundle;
+    CHECK(bundle.Attach(image.data(), image.size()));
+    CHECK_EQ(bundle.Count(), 4);
+    CHECK_EQ(bundle.Size(), image.size());
+    CHECK(bundle.Find("dash") == nullptr);
+    CHECK(bundle.Find("missing") == nullptr);
+
+    const asset_entry_t *dash = bundle.Find("dash_bg");
+    CHECK(dash != nullptr);
+    if (dash) {
+        CHECK(dash->kind == AssetKind::IMAGE);
+        CHECK_EQ(dash->color_format, 0x12);
+        CHECK_EQ(dash->unit, 2);
+        CHECK_EQ(dash->width, 40);
+        CHECK_EQ(dash->height, 24);
+        CHECK_EQ(dash->stride, 80);
+        CHECK_EQ(dash->raw_size, dash_pixels.size());
+        CHECK(dash->size < dash->raw_size);
+        CHECK(bundle.Verify(*dash));
+        // What AssetStore::Image does with an RLE image
+        std::vector<uint8_t> decoded(dash->raw_size);
+        CHECK(RleDecode(bundle.Data(*dash), dash->size, dash->unit, decoded.data(), decoded.size()));
+        CHECK(decoded == dash_pixels);
+    }
+    const asset_entry_t *noise = bundle.Find("noise");
+    CHECK(noise != nullptr);
+    if (noise) {
+        CHECK_EQ(noise->color_format, 0x10);
+        CHECK_EQ(noise->unit, 4);
+        CHECK(std::vector<uint8_t>(bundle.Data(*noise), bundle.Data(*noise) + noise->size) == noise_pixels);
+    }
+    for (size_t i = 0; i < bundle.Count(); i++) {
+        const asset_entry_t &entry = bundle.Entry(i);
+        CHECK_EQ(entry.offset % ASSET_ALIGN, 0);
+        CHECK(bundle.Verify(entry));
+        CHECK(std::vector<uint8_t>(bundle.Data(entry), bundle.Data(entry) + entry.size) == assets[i].data);
+        CHECK(bundle.Find(assets[i].name.c_str()) == &entry);
+    }
+    // The id follows the contents
+    uint32_t id = bundle.Id();
+    assets[2].data[0] ^= 1;
+    EncodeAsset(assets[2], false);
+    std::vector<uint8_t> changed = PackBundle(assets);
+    AssetBundle other;
+    CHECK(other.Attach(changed.data(), changed.size()));
+    CHECK(other.Id() != id);
+
+    // Damage in the index or the header fails Attach, damage in an asset fails its Verify
+    std::vector<uint8_t> damaged = image;
+    damaged[sizeof(asset_bundle_header_t) + 5] ^= 0x20;
+    CHECK(!bundle.Attach(damaged.data(), damaged.size()));
+    CHECK(!bundle.Attached());
+    CHECK(!bundle.Attach(image.data(), image.size() - 1));
+    CHECK(!bundle.Attach(image.data(), sizeof(asset_bundle_header_t) - 1));
+    damaged = image;
+    damaged[0] ^= 1;
+    CHECK(!bundle.Attach(damaged.data(), damaged.size()));
+    damaged = image;
+    CHECK(bundle.Attach(damaged.data(), damaged.size()));
+    const asset_entry_t *chime = bundle.Find("chime");
+    CHECK(chime != nullptr);
+    if (chime) {
+        damaged[chime->offset + chime->size / 2] ^= 0x80;
+        CHECK(!bundle.Verify(*chime));
+        CHECK(bundle.Verify(*bundle.Find("dash_bg")));
+    }
+    printf("bundle of %zu bytes, dash_bg %lu bytes packed from %lu\n", image.size(),
+           static_cast<unsigned long>(dash ? dash->size : 0), static_cast<unsigned long>(dash_pixels.size()));
+}
+
+int main() {
+    CheckRle();
+    CheckBundle();
+    return host_check::Result("asset_bundle_test");
+}
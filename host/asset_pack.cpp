@@ -0,0 +1,165 @@
+// Packs images, fonts and sounds into the asset bundle the dash maps from its assets partition (main/AssetBundle.hpp),
+// and lists or checks an existing bundle.
+//   asset_pack -o assets.bin [--rle] --image dash_bg=MiniDash_v1_2.c [--font NAME=FILE] [--sound NAME=FILE] ...
+//   asset_pack --list assets.bin
+// Images are LVGL 9 exports, C arrays (.c) or binary images (.bin). --rle packs the images after it when that makes
+// them smaller. Fonts are lv_font_conv binary fonts, sounds anything the audio player decodes, --blob any file.
+// Flash with: parttool.py write_partition --partition-name assets --input assets.bin
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "AssetBundle.hpp"
+#include "AssetPacker.hpp"
+
+static auto ReadFile(const char *path, std::vector<uint8_t> &out) -> bool {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    uint8_t buffer[65536];
+    size_t got;
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        out.insert(out.end(), buffer, buffer + got);
+    }
+    fclose(file);
+    return true;
+}
+
+static auto LoadAsset(AssetKind kind, const char *spec, bool rle, pending_asset_t &asset) -> bool {
+    const char *equals = strchr(spec, '=');
+    if (!equals || equals == spec || static_cast<size_t>(equals - spec) >= ASSET_NAME_SIZE) {
+        fprintf(stderr, "%s: expected NAME=FILE with a name under %zu characters\n", spec, ASSET_NAME_SIZE);
+        return false;
+    }
+    asset.name.assign(spec, equals);
+    const char *path = equals + 1;
+    std::vector<uint8_t> file;
+    if (!ReadFile(path, file)) {
+        fprintf(stderr, "can not read %s\n", path);
+        return false;
+    }
+    asset.entry.kind = kind;
+    asset.entry.codec = AssetCodec::RAW;
+    asset.entry.unit = 1;
+    if (kind != AssetKind::IMAGE) {
+        asset.data = std::move(file);
+    } else {
+        size_t length = strlen(path);
+        bool c_export = length > 2 && strcmp(path + length - 2, ".c") == 0;
+        if (!(c_export ? ParseImageExport(file, asset) : ParseImageBinary(file, asset))) {
+            fprintf(stderr, "%s: not an LVGL 9 image export\n", path);
+            return false;
+        }
+        if (asset.data.size() < static_cast<size_t>(asset.entry.stride) * asset.entry.height) {
+            fprintf(stderr, "%s: %zu bytes of pixels, the header says %lu\n", path, asset.data.size(),
+                    static_cast<unsigned long>(asset.entry.stride) * asset.entry.height);
+            return false;
+        }
+    }
+    EncodeAsset(asset, rle);
+    return true;
+}
+
+static auto Pack(const char *out_path, std::vector<pending_asset_t> &assets) -> bool {
+    std::vector<uint8_t> bundle = PackBundle(assets);
+    FILE *file = fopen(out_path, "wb");
+    if (!file || fwrite(bundle.data(), 1, bundle.size(), file) != bundle.size()) {
+        fprintf(stderr, "can not write %s\n", out_path);
+        if (file) {
+            fclose(file);
+        }
+        return false;
+    }
+    fclose(file);
+    AssetBundle packed;
+    packed.Attach(bundle.data(), bundle.size());
+    printf("%s: %zu assets, %zu bytes, bundle %08lx\n", out_path, packed.Count(), bundle.size(),
+           static_cast<unsigned long>(packed.Id()));
+    return true;
+}
+
+static constexpr const char *KIND_NAMES[] = {"blob", "image", "font", "sound"};
+
+// Checks every CRC and decodes the packed images. Returns false on any damage.
+static auto List(const char *path) -> bool {
+    std::vector<uint8_t> file;
+    AssetBundle bundle;
+    if (!ReadFile(path, file) || !bundle.Attach(file.data(), file.size())) {
+        fprintf(stderr, "%s: not an asset bundle of version %u\n", path, ASSET_BUNDLE_VERSION);
+        return false;
+    }
+    bool ok = true;
+    printf("bundle %08lx, %zu bytes\n", static_cast<unsigned long>(bundle.Id()), static_cast<size_t>(bundle.Size()));
+    printf("%-20s %-6s %10s %10s %6s %s\n", "name", "kind", "offset", "stored", "codec", "image");
+    for (size_t i = 0; i < bundle.Count(); i++) {
+        const asset_entry_t &entry = bundle.Entry(i);
+        bool intact = bundle.Verify(entry);
+        if (intact && entry.codec == AssetCodec::RLE) {
+            std::vector<uint8_t> raw(entry.raw_size);
+            intact = RleDecode(bundle.Data(entry), entry.size, entry.unit, raw.data(), raw.size());
+        }
+        char image[64] = "";
+        if (entry.kind == AssetKind::IMAGE) {
+            const color_format_t *format = FindFormat(entry.color_format);
+            snprintf(image, sizeof(image), "%ux%u %s", entry.width, entry.height, format ? format->name : "?");
+        }
+        printf("%-20s %-6s %10lu %10lu %6s %s%s\n", entry.name.data(),
+               KIND_NAMES[static_cast<uint8_t>(entry.kind) & 3], static_cast<unsigned long>(entry.offset),
+               static_cast<unsigned long>(entry.size), entry.codec == AssetCodec::RLE ? "rle" : "raw", image,
+               intact ? "" : " DAMAGED");
+        ok = ok && intact;
+    }
+    return ok;
+}
+
+static auto Usage() -> int {
+    fprintf(stderr, "usage: asset_pack -o OUT [--rle] [--image|--font|--sound|--blob NAME=FILE]...\n"
+                    "       asset_pack --list BUNDLE\n");
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = nullptr;
+    bool rle = false;
+    std::vector<pending_asset_t> assets;
+    for (int i = 1; i < argc; i++) {
+        AssetKind kind;
+        if (strcmp(argv[i], "--list") == 0 && i + 1 < argc) {
+            return List(argv[i + 1]) ? 0 : 1;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+            continue;
+        } else if (strcmp(argv[i], "--rle") == 0) {
+            rle = true;
+            continue;
+        } else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc) {
+            kind = AssetKind::IMAGE;
+        } else if (strcmp(argv[i], "--font") == 0 && i + 1 < argc) {
+            kind = AssetKind::FONT;
+        } else if (strcmp(argv[i], "--sound") == 0 && i + 1 < argc) {
+            kind = AssetKind::SOUND;
+        } else if (strcmp(argv[i], "--blob") == 0 && i + 1 < argc) {
+            kind = AssetKind::BLOB;
+        } else {
+            return Usage();
+        }
+        pending_asset_t asset;
+        if (!LoadAsset(kind, argv[++i], rle, asset)) {
+            return 1;
+        }
+        bool duplicate = std::any_of(assets.begin(), assets.end(),
+                                     [&](const pending_asset_t &other) { return other.name == asset.name; });
+        if (duplicate) {
+            fprintf(stderr, "%s is in the bundle twice\n", asset.name.c_str());
+            return 1;
+        }
+        assets.push_back(std::move(asset));
+    }
+    if (!out_path || assets.empty() || assets.size() > UINT16_MAX) {
+        return Usage();
+    }
+    return Pack(out_path, assets) ? 0 : 1;
+}
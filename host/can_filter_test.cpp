@@ -0,0 +1,127 @@
+// Acceptance filter of the real signal table, checked at compile time: a change to CAN_SIGNALS that moves the
+// filter fails the build here first, with the numbers can_replay and the device log print. The receiver's software
+// filter is checked on a backend without a hardware filter, like replay and SocketCAN.
+#include <array>
+#include <stdint.h>
+
+#include "CanFilter.hpp"
+#include "CanReceiver.hpp"
+#include "CanSignals.hpp"
+#include "HostCheck.hpp"
+
+using namespace can_filter;
+
+static constexpr can_filter_t BUS0 = BusRxFilter(0);
+
+// 0x0AA alone in one half, 0x1A0 and 0x1D0 in the other
+static_assert(!BUS0.single_filter);
+static_assert(BUS0.acceptance_code == 0x15403000);
+static_assert(BUS0.acceptance_mask == 0x000F0E0F);
+static_assert(BUS0.accepted_ids == 9);
+static_assert(CountPassed(BUS0) == BUS0.accepted_ids);
+static_assert(!BUS0.exact);
+
+static constexpr std::array<uint32_t, 9> BUS0_PASSED{0x0AA, 0x180, 0x190, 0x1A0, 0x1B0, 0x1C0, 0x1D0, 0x1E0, 0x1F0};
+
+constexpr auto PassesExactly(const can_filter_t &filter, const std::array<uint32_t, 9> &ids) -> bool {
+    size_t next = 0;
+    for (uint32_t id = 0; id <= ID_BITS; id++) {
+        bool listed = next < ids.size() && ids[next] == id;
+        if (Passes(filter, id) != listed) {
+            return false;
+        }
+        next += listed ? 1 : 0;
+    }
+    return next == ids.size();
+}
+static_assert(PassesExactly(BUS0, BUS0_PASSED));
+
+// Every bus filter passes every data frame its signals come in, and no remote frame
+constexpr auto FiltersCoverSignals() -> bool {
+    for (const can_signal_t &signal : CAN_SIGNALS) {
+        can_filter_t filter = BusRxFilter(signal.bus);
+        if (!Passes(filter, signal.identifier) || Passes(filter, signal.identifier, true)) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(FiltersCoverSignals());
+static_assert(CountPassed(BUS0, true) == 0);
+
+// The ID and compared bits handed to the onchip driver's mask filter pass the same IDs as the register layout
+constexpr auto IdMatchesAgree(const can_filter_t &filter) -> bool {
+    id_match_t first = IdMatch(filter);
+    id_match_t second = IdMatch(filter, true);
+    for (uint32_t id = 0; id <= ID_BITS; id++) {
+        bool passes = ((id ^ first.id) & first.compared) == 0;
+        if (!filter.single_filter) {
+            passes = passes || ((id ^ second.id) & second.compared) == 0;
+        }
+        if (passes != Passes(filter, id)) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(IdMatchesAgree(BUS0));
+static_assert(IdMatchesAgree(ComputeAcceptanceFilter(std::array<uint32_t, 3>{0x100, 0x101, 0x102})));
+static_assert(IdMatchesAgree(can_filter_t{}));
+
+static auto FrameOf(uint32_t identifier) -> can_frame_t {
+    can_frame_t frame{};
+    frame.identifier = identifier;
+    frame.timestamp_us = identifier;
+    frame.dlc = 8;
+    return frame;
+}
+
+// Every standard ID once on bus 0, nothing filtered on the way
+class AllIdsBackend : public CanRxBackend {
+  private:
+    can_rx_ring_t ring;
+    uint32_t next_id = 0;
+
+  public:
+    auto WaitForFrames(uint32_t /*timeout_ms*/) -> bool override {
+        while (next_id < CAN_STD_ID_COUNT && ring.Push(FrameOf(next_id))) {
+            next_id++;
+        }
+        return ring.Size() > 0;
+    }
+    auto Ring() -> can_rx_ring_t & override {
+        return ring;
+    }
+    [[nodiscard]] auto Done() -> bool {
+        return next_id == CAN_STD_ID_COUNT && ring.Size() == 0;
+    }
+};
+
+static auto CheckSoftwareFilter() -> void {
+    AllIdsBackend backend;
+    can_rx_backends_t backends{};
+    backends[0] = &backend;
+    CanReceiver receiver(backends);
+    uint32_t handled = 0;
+    bool only_consumed = true;
+    while (!backend.Done()) {
+        receiver.ReceiveBatch([&](const can_frame_t &frame) {
+            only_consumed = only_consumed && CanDecoder::Consumes(0, frame.identifier);
+            handled++;
+        });
+    }
+    CHECK(only_consumed);
+    CHECK_EQ(handled, CanDecoder::BusIds(0).count);
+    CHECK_EQ(receiver.GetRxStats().sw_rejected, CAN_STD_ID_COUNT - CanDecoder::BusIds(0).count);
+}
+
+int main() {
+    // What the post-filter keeps of what the hardware passes
+    uint32_t consumed = 0;
+    for (uint32_t id : BUS0_PASSED) {
+        consumed += CanDecoder::Consumes(0, id) ? 1 : 0;
+    }
+    CHECK_EQ(consumed, CanDecoder::BusIds(0).count);
+    CheckSoftwareFilter();
+    return host_check::Result("can_filter_test");
+}
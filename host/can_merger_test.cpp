@@ -0,0 +1,188 @@
+// CanMerger over several rings fed with synthetic traffic: interleaved buses come out in timestamp order, frames
+// that arrive after a newer one was emitted count as out of order, and a drain stops at the frames pending when it
+// started. Three buses regardless of CAN_BUS_COUNT.
+#include <array>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "CanMerger.hpp"
+#include "HostCheck.hpp"
+
+static constexpr size_t BUSES = 3;
+using TestMerger = BasicCanMerger<BUSES>;
+
+// Ring filled directly by the test
+class QueueBackend : public CanRxBackend {
+  private:
+    can_rx_ring_t ring;
+
+  public:
+    auto WaitForFrames(uint32_t /*timeout_ms*/) -> bool override {
+        return ring.Size() > 0;
+    }
+    auto Ring() -> can_rx_ring_t & override {
+        return ring;
+    }
+    auto Push(uint8_t bus, int64_t timestamp_us, uint32_t sequence = 0) -> void {
+        can_frame_t frame{};
+        frame.identifier = 0x100 + bus;
+        frame.bus = bus;
+        frame.dlc = 4;
+        frame.timestamp_us = timestamp_us;
+        frame.data[0] = static_cast<uint8_t>(sequence);
+        frame.data[1] = static_cast<uint8_t>(sequence >> 8);
+        frame.data[2] = static_cast<uint8_t>(sequence >> 16);
+        frame.data[3] = static_cast<uint8_t>(sequence >> 24);
+        CHECK(ring.Push(frame));
+    }
+};
+
+static auto SequenceOf(const can_frame_t &frame) -> uint32_t {
+    return frame.data[0] | frame.data[1] << 8 | frame.data[2] << 16 | static_cast<uint32_t>(frame.data[3]) << 24;
+}
+
+struct test_buses_t {
+    std::array<QueueBackend, BUSES> backends;
+    TestMerger merger{{&backends[0], &backends[1], &backends[2]}};
+};
+
+// Two buses with alternating timestamps, pending at once, come out merged
+static auto CheckInterleaved() -> void {
+    test_buses_t buses;
+    for (int64_t i = 0; i < 100; i++) {
+        buses.backends[0].Push(0, i * 10);
+        buses.backends[1].Push(1, i * 10 + 5);
+    }
+    CHECK(buses.merger.WaitForFrames(0));
+    int64_t last = -1;
+    uint32_t count = buses.merger.Drain([&](const can_frame_t &frame) {
+        CHECK(frame.timestamp_us > last);
+        CHECK_EQ(frame.bus, frame.timestamp_us % 10 == 5 ? 1 : 0);
+        last = frame.timestamp_us;
+    });
+    CHECK_EQ(count, 200);
+    CHECK_EQ(last, 995);
+    CHECK_EQ(buses.merger.GetStats().frames[0], 100);
+    CHECK_EQ(buses.merger.GetStats().frames[1], 100);
+    CHECK_EQ(buses.merger.GetStats().frames[2], 0);
+    CHECK_EQ(buses.merger.GetStats().out_of_order, 0);
+    CHECK(!buses.merger.WaitForFrames(0));
+}
+
+// A frame older than one already emitted is still delivered, counts as out of order and does not move the merge
+// clock back
+static auto CheckLateFrame() -> void {
+    test_buses_t buses;
+    buses.backends[0].Push(0, 100);
+    buses.backends[0].Push(0, 200);
+    buses.backends[0].Push(0, 300);
+    CHECK_EQ(buses.merger.Drain([](const can_frame_t &) {}), 3);
+
+    buses.backends[1].Push(1, 150);
+    buses.backends[0].Push(0, 400);
+    std::vector<int64_t> order;
+    auto record = [&](const can_frame_t &frame) { order.push_back(frame.timestamp_us); };
+    CHECK_EQ(buses.merger.Drain(record), 2);
+    CHECK(order == std::vector<int64_t>({150, 400}));
+    CHECK_EQ(buses.merger.GetStats().out_of_order, 1);
+
+    buses.backends[2].Push(2, 350);
+    buses.backends[1].Push(1, 400);
+    buses.backends[0].Push(0, 410);
+    order.clear();
+    CHECK_EQ(buses.merger.Drain(record), 3);
+    CHECK(order == std::vector<int64_t>({350, 400, 410}));
+    // Equal to the newest emitted is in order
+    CHECK_EQ(buses.merger.GetStats().out_of_order, 2);
+}
+
+// Frames arriving while a drain runs wait for the next one
+static auto CheckBudget() -> void {
+    test_buses_t buses;
+    for (int64_t i = 0; i < 4; i++) {
+        buses.backends[0].Push(0, i * 10);
+    }
+    int64_t next = 1000;
+    uint32_t count = buses.merger.Drain([&](const can_frame_t &) {
+        buses.backends[1].Push(1, next++);
+    });
+    CHECK_EQ(count, 4);
+    CHECK_EQ(buses.backends[1].Ring().Size(), 4);
+    CHECK_EQ(buses.merger.Drain([](const can_frame_t &) {}), 4);
+    CHECK_EQ(buses.merger.GetStats().out_of_order, 0);
+}
+
+// Three buses at their own frame rates on a shared clock. Each pump hands its frames to the ring in bursts at
+// random times, like tasks woken late, and the consumer drains at random times, so a burst may reach the merger
+// after newer frames of another bus went out. Every frame comes out once, in order per bus and in timestamp order
+// within a drain, and out_of_order matches the frames emitted after a newer one.
+static auto CheckRandomBursts() -> void {
+    static constexpr std::array<int64_t, BUSES> FRAME_PERIOD_US{110, 230, 470};
+    test_buses_t buses;
+    std::mt19937 random(12345);
+    std::array<std::vector<int64_t>, BUSES> pending{};
+    std::array<int64_t, BUSES> next_frame_us{};
+    std::array<uint32_t, BUSES> sent{};
+    std::array<uint32_t, BUSES> received{};
+    int64_t newest = -1;
+    uint32_t expected_out_of_order = 0;
+    uint32_t total = 0;
+    int64_t drain_last = -1;
+    auto consume = [&](const can_frame_t &frame) {
+        CHECK(frame.timestamp_us >= drain_last);
+        drain_last = frame.timestamp_us;
+        CHECK_EQ(SequenceOf(frame), received[frame.bus]);
+        received[frame.bus]++;
+        if (frame.timestamp_us < newest) {
+            expected_out_of_order++;
+        } else {
+            newest = frame.timestamp_us;
+        }
+        total++;
+    };
+
+    for (int64_t now_us = 0; now_us < 20000000; now_us += 100) {
+        for (uint8_t bus = 0; bus < BUSES; bus++) {
+            while (next_frame_us[bus] <= now_us) {
+                pending[bus].push_back(next_frame_us[bus]);
+                next_frame_us[bus] += FRAME_PERIOD_US[bus] + static_cast<int64_t>(random() % 40);
+            }
+            if (random() % 3 == 0) {
+                for (int64_t timestamp_us : pending[bus]) {
+                    buses.backends[bus].Push(bus, timestamp_us, sent[bus]++);
+                }
+                pending[bus].clear();
+            }
+        }
+        if (random() % 2) {
+            drain_last = -1;
+            buses.merger.Drain(consume);
+        }
+    }
+    for (uint8_t bus = 0; bus < BUSES; bus++) {
+        for (int64_t timestamp_us : pending[bus]) {
+            buses.backends[bus].Push(bus, timestamp_us, sent[bus]++);
+        }
+    }
+    drain_last = -1;
+    buses.merger.Drain(consume);
+
+    for (size_t bus = 0; bus < BUSES; bus++) {
+        CHECK_EQ(received[bus], sent[bus]);
+        CHECK_EQ(buses.merger.GetStats().frames[bus], sent[bus]);
+    }
+    CHECK_EQ(buses.merger.Dropped(), 0);
+    CHECK(expected_out_of_order > 0);
+    CHECK_EQ(buses.merger.GetStats().out_of_order, expected_out_of_order);
+    printf("random bursts: %u frames, %u out of order\n", total, expected_out_of_order);
+}
+
+int main() {
+    CheckInterleaved();
+    CheckLateFrame();
+    CheckBudget();
+    CheckRandomBursts();
+    return host_check::Result("can_merger_test");
+}
@@ -0,0 +1,139 @@
+// Runs CanRecovery against a simulated controller on a virtual clock and reports how long each bus-off takes to
+// recover, for the cases the device can run into: the recovered alert arrives, it gets lost, or the controller
+// refuses the first recovery request.
+//   can_recovery_sim [--bitrate N] [--runs N]
+// Exits 1 when a bus-off is not recovered, or the alert path is slower than the recovery sequence plus a margin.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CanRecovery.hpp"
+
+static constexpr int64_t TICK_US = 100;          // how often the simulated CAN task looks at alerts
+static constexpr int64_t GIVE_UP_US = 1000000;
+static constexpr int64_t ALERT_PATH_MARGIN_US = 1000;
+
+// Legacy TWAI behaviour: recovery needs bus off, takes 128 x 11 recessive bits, then leaves the controller stopped
+// and raises the recovered alert
+class SimController : public CanController {
+  private:
+    const int64_t &now_us;
+    int64_t recovery_bits_us;
+    CanControllerState state = CanControllerState::ERROR_ACTIVE;
+    int64_t recovered_at_us = 0;
+    uint32_t pending_alerts = 0;
+
+  public:
+    bool drop_recovered_alert = false;
+    uint32_t refuse_recoveries = 0;
+
+    SimController(const int64_t &now_us, uint32_t bitrate)
+        : now_us(now_us), recovery_bits_us(128LL * 11 * 1000000 / bitrate) {}
+
+    auto InitiateRecovery() -> bool override {
+        if (state != CanControllerState::BUS_OFF || refuse_recoveries) {
+            refuse_recoveries -= refuse_recoveries ? 1 : 0;
+            return false;
+        }
+        state = CanControllerState::RECOVERING;
+        recovered_at_us = now_us + recovery_bits_us;
+        return true;
+    }
+    auto Start() -> bool override {
+        if (state != CanControllerState::STOPPED) {
+            return false;
+        }
+        state = CanControllerState::ERROR_ACTIVE;
+        return true;
+    }
+    auto State() -> CanControllerState override {
+        return state;
+    }
+
+    auto GoBusOff() -> void {
+        state = CanControllerState::BUS_OFF;
+        pending_alerts |= CAN_ALERT_ERROR_PASSIVE | CAN_ALERT_BUS_OFF;
+    }
+    // Advances the controller to now and hands over the alerts raised meanwhile
+    auto TakeAlerts() -> uint32_t {
+        if (state == CanControllerState::RECOVERING && now_us >= recovered_at_us) {
+            state = CanControllerState::STOPPED;
+            pending_alerts |= drop_recovered_alert ? 0 : CAN_ALERT_BUS_RECOVERED;
+        }
+        uint32_t alerts = pending_alerts;
+        pending_alerts = 0;
+        return alerts;
+    }
+    [[nodiscard]] auto RecoveryBitsUs() const -> int64_t {
+        return recovery_bits_us;
+    }
+};
+
+struct sim_case_t {
+    const char *name;
+    bool drop_recovered_alert;
+    uint32_t refuse_recoveries;
+};
+
+static constexpr sim_case_t CASES[] = {
+    {"alert", false, 0},
+    {"lost alert", true, 0},
+    {"refused once", false, 1},
+};
+
+int main(int argc, char **argv) {
+    uint32_t bitrate = 500000;
+    uint32_t runs = 100;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bitrate") == 0 && i + 1 < argc) {
+            bitrate = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else {
+            fprintf(stderr, "usage: can_recovery_sim [--bitrate N] [--runs N]\n");
+            return 2;
+        }
+    }
+
+    bool failed = false;
+    printf("%-14s %6s %10s %14s %14s %8s\n", "case", "runs", "recovered", "last us", "max us", "retries");
+    for (const sim_case_t &test : CASES) {
+        int64_t now = 1;
+        SimController controller(now, bitrate);
+        controller.drop_recovered_alert = test.drop_recovered_alert;
+        CanRecovery recovery(controller, test.name);
+        for (uint32_t run = 0; run < runs; run++) {
+            controller.refuse_recoveries = test.refuse_recoveries;
+            controller.GoBusOff();
+            int64_t bus_off = now;
+            while (now - bus_off < GIVE_UP_US) {
+                recovery.HandleAlerts(controller.TakeAlerts(), now);
+                recovery.Poll(now);
+                if (!recovery.Recovering() && controller.State() == CanControllerState::ERROR_ACTIVE) {
+                    break;
+                }
+                now += TICK_US;
+            }
+            // Some bus time between bus-offs
+            now += 10000;
+        }
+
+        const can_recovery_stats_t &stats = recovery.GetStats();
+        printf("%-14s %6lu %10lu %14lu %14lu %8lu\n", test.name, static_cast<unsigned long>(runs),
+               static_cast<unsigned long>(stats.recoveries), static_cast<unsigned long>(stats.last_recovery_us),
+               static_cast<unsigned long>(stats.max_recovery_us), static_cast<unsigned long>(stats.retries));
+        if (stats.recoveries != runs) {
+            fprintf(stderr, "%s: %lu of %lu bus-offs not recovered\n", test.name,
+                    static_cast<unsigned long>(runs - stats.recoveries), static_cast<unsigned long>(runs));
+            failed = true;
+        }
+        if (!test.drop_recovered_alert && !test.refuse_recoveries &&
+            stats.max_recovery_us > controller.RecoveryBitsUs() + ALERT_PATH_MARGIN_US) {
+            fprintf(stderr, "%s: recovery took %lu us, the sequence is %lld us\n", test.name,
+                    static_cast<unsigned long>(stats.max_recovery_us),
+                    static_cast<long long>(controller.RecoveryBitsUs()));
+            failed = true;
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,134 @@
+// CanRing under synthetic bursts: slot wraparound, drop counting on a full ring and ordering with a producer and a
+// consumer thread, plus the throughput of that run.
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#include "CanRing.hpp"
+#include "CanRxBackend.hpp"
+#include "Hal.hpp"
+#include "HostCheck.hpp"
+
+static constexpr uint32_t THREADED_FRAMES = 2000000;
+static constexpr uint32_t BURST = 48;
+// The consumer stalls this long every STALL_EVERY frames, the producer overruns the ring meanwhile
+static constexpr uint32_t STALL_EVERY = 16384;
+static constexpr uint32_t STALL_US = 200;
+
+static auto Numbered(uint32_t sequence) -> can_frame_t {
+    can_frame_t frame{};
+    frame.identifier = sequence & 0x7FF;
+    frame.dlc = 4;
+    memcpy(frame.data, &sequence, sizeof(sequence));
+    return frame;
+}
+
+static auto SequenceOf(const can_frame_t &frame) -> uint32_t {
+    uint32_t sequence;
+    memcpy(&sequence, frame.data, sizeof(sequence));
+    return sequence;
+}
+
+// Many laps of a small ring with uneven batches, frames come out in order and none go missing
+static auto CheckWraparound() -> void {
+    CanRing<8> ring;
+    uint32_t pushed = 0;
+    uint32_t expected = 0;
+    for (uint32_t round = 0; round < 1000; round++) {
+        uint32_t burst = round % 8 + 1;
+        for (uint32_t i = 0; i < burst; i++) {
+            CHECK(ring.Push(Numbered(pushed++)));
+        }
+        uint32_t drained = ring.Drain([&](const can_frame_t &frame) {
+            CHECK_EQ(SequenceOf(frame), expected);
+            expected++;
+        }, round % 3 + 1);
+        CHECK(drained <= burst);
+        while (const can_frame_t *frame = ring.Front()) {
+            CHECK_EQ(SequenceOf(*frame), expected);
+            expected++;
+            ring.Pop();
+        }
+    }
+    CHECK_EQ(expected, pushed);
+    CHECK_EQ(ring.Dropped(), 0);
+    CHECK_EQ(ring.Size(), 0);
+}
+
+// A full ring refuses frames and counts each one, what it holds is the oldest
+static auto CheckFullRing() -> void {
+    CanRing<16> ring;
+    for (uint32_t i = 0; i < 16 + 5; i++) {
+        CHECK_EQ(ring.Push(Numbered(i)), i < 16);
+    }
+    CHECK_EQ(ring.Dropped(), 5);
+    CHECK_EQ(ring.Size(), 16);
+    CHECK(ring.Reserve() == nullptr);
+    CHECK_EQ(ring.Dropped(), 6);
+    uint32_t expected = 0;
+    ring.Drain([&](const can_frame_t &frame) { CHECK_EQ(SequenceOf(frame), expected++); });
+    CHECK_EQ(expected, 16);
+    CHECK_EQ(ring.HighWater(), 16);
+    CHECK(ring.Push(Numbered(99)));
+    CHECK_EQ(ring.Size(), 1);
+}
+
+// Producer bursts while the consumer keeps stalling: everything that got in comes out once and in order, and the
+// gaps in the sequence add up to the drop count
+static auto CheckThreaded() -> void {
+    static can_rx_ring_t ring;
+    std::atomic<bool> done{false};
+    int64_t start = hal::NowUs();
+    std::thread producer([&] {
+        for (uint32_t sequence = 0; sequence < THREADED_FRAMES; sequence++) {
+            ring.Push(Numbered(sequence));
+            if (sequence % BURST == BURST - 1) {
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+
+    uint32_t received = 0;
+    uint32_t gaps = 0;
+    uint32_t disorder = 0;
+    int64_t next = 0;
+    auto consume = [&](const can_frame_t &frame) {
+        int64_t sequence = SequenceOf(frame);
+        if (sequence < next) {
+            disorder++;
+        } else {
+            gaps += static_cast<uint32_t>(sequence - next);
+        }
+        next = sequence + 1;
+        if (++received % STALL_EVERY == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(STALL_US));
+        }
+    };
+    while (!done || ring.Size()) {
+        if (!ring.Drain(consume, 32)) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    int64_t elapsed_us = hal::NowUs() - start;
+
+    gaps += static_cast<uint32_t>(THREADED_FRAMES - next);
+    CHECK_EQ(disorder, 0);
+    CHECK_EQ(received + ring.Dropped(), THREADED_FRAMES);
+    CHECK_EQ(gaps, ring.Dropped());
+    CHECK(ring.Dropped() > 0);
+    printf("threaded: %u frames, %u received, %u dropped, high water %u of %zu, %.1f Mframes/s\n", THREADED_FRAMES,
+           received, ring.Dropped(), ring.HighWater(), can_rx_ring_t::Capacity(),
+           elapsed_us > 0 ? static_cast<double>(THREADED_FRAMES) / static_cast<double>(elapsed_us) : 0.0);
+}
+
+int main() {
+    CheckWraparound();
+    CheckFullRing();
+    CheckThreaded();
+    return host_check::Result("can_ring_test");
+}
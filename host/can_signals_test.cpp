@@ -0,0 +1,53 @@
+// CAN_SIGNALS against the hand-written decoding it replaced: every byte combination the RPM, SPEED, FUEL and TEMP
+// fields can hold decodes to what the old HandleRPM/HandleSpeed/HandleFuel/HandleTemp computed, and frames the
+// table does not know decode to nothing.
+#include <stdint.h>
+#include <stdio.h>
+
+#include "CanSignals.hpp"
+#include "HostCheck.hpp"
+
+// The old per-signal math, without its narrow return types
+static auto OldRpm(uint8_t data5, uint8_t data6) -> int32_t {
+    uint16_t raw_value = data6 * 255;
+    return ((raw_value / 2) / 4) + data5;
+}
+static auto OldSpeed(uint8_t data0, uint8_t data1) -> int32_t {
+    uint16_t raw_value = (data1 & 0x0F) * 255;
+    uint32_t scaled = (raw_value * 621 + 5000) / 1000;
+    return static_cast<int32_t>(scaled) + data0;
+}
+
+static auto Decoded(uint32_t identifier, const uint8_t (&data)[8], Signal signal) -> int32_t {
+    decoded_signals_t out;
+    CHECK(CanDecoder::Decode(0, identifier, data, 8, out));
+    CHECK(out.Has(signal));
+    return out.Get(signal);
+}
+
+int main() {
+    uint32_t checked = 0;
+    for (uint32_t high = 0; high < 256; high++) {
+        for (uint32_t low = 0; low < 256; low++) {
+            uint8_t torq3[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, static_cast<uint8_t>(low), static_cast<uint8_t>(high)};
+            CHECK_EQ(Decoded(TORQ3, torq3, Signal::RPM), OldRpm(low, high));
+            // The upper nibble of data[1] is not part of the speed
+            uint8_t speed[8] = {static_cast<uint8_t>(low), static_cast<uint8_t>(high), 0xFF, 0xFF};
+            CHECK_EQ(Decoded(SPEED, speed, Signal::SPEED), OldSpeed(low, high));
+            checked += 2;
+        }
+        uint8_t engdata[8] = {static_cast<uint8_t>(high), 0xFF, 0xFF, static_cast<uint8_t>(high)};
+        CHECK_EQ(Decoded(ENGDATA, engdata, Signal::FUEL), static_cast<int32_t>(high * 100 / 255));
+        CHECK_EQ(Decoded(ENGDATA, engdata, Signal::TEMP), static_cast<int32_t>(high) - 48);
+        checked += 2;
+    }
+
+    // FUELMLS has no confirmed layout, ODO and FUEL_RANGE are not decoded from it
+    uint8_t fuelmls[8] = {0x12, 0x34, 0x56, 0, 0, 0, 0x78, 0x9A};
+    decoded_signals_t out;
+    CHECK(!CanDecoder::Decode(0, FUELMLS, fuelmls, 8, out));
+    CHECK_EQ(out.updated, 0);
+    CHECK(!CanDecoder::Consumes(0, FUELMLS));
+    printf("%u decoded values match the old decoding\n", checked);
+    return host_check::Result("can_signals_test");
+}
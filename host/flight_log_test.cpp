@@ -0,0 +1,342 @@
+// FlightLog encode/decode round trips: varint and zigzag edge values, every record field of mixed traffic, the block
+// dictionary running full, and a ring of blocks read back through FlightLogSource with a torn block after the
+// newest one.
+#include <array>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "FlightLog.hpp"
+#include "HostCheck.hpp"
+#include "TraceSource.hpp"
+
+using namespace flight_log;
+
+using block_t = std::array<uint8_t, BLOCK_SIZE>;
+
+// Storage partition in memory, erased flash reads as 0xFF
+class MemoryBlockStore : public FlightBlockStore {
+  public:
+    std::vector<block_t> blocks;
+
+    explicit MemoryBlockStore(uint32_t count) : blocks(count) {
+        for (block_t &block : blocks) {
+            block.fill(0xFF);
+        }
+    }
+    auto BlockCount() -> uint32_t override {
+        return static_cast<uint32_t>(blocks.size());
+    }
+    auto ReadBlock(uint32_t index, uint8_t *out, size_t len) -> bool override {
+        if (index >= blocks.size() || len > BLOCK_SIZE) {
+            return false;
+        }
+        memcpy(out, blocks[index].data(), len);
+        return true;
+    }
+};
+
+static auto SameFrame(const can_frame_t &actual, const can_frame_t &expected) -> bool {
+    uint8_t data_len = expected.rtr ? 0 : (expected.dlc > 8 ? 8 : expected.dlc);
+    return actual.timestamp_us == expected.timestamp_us && actual.identifier == expected.identifier &&
+           actual.dlc == expected.dlc && actual.bus == expected.bus && actual.extd == expected.extd &&
+           actual.rtr == expected.rtr && memcmp(actual.data, expected.data, data_len) == 0;
+}
+
+// Mixed traffic: a few standard IDs on both buses whose data changes a byte or two at a time, extended IDs (small
+// ones included, they stay literal), remote frames and timestamps that jump forward, back and by seconds
+class TrafficGenerator {
+  private:
+    std::mt19937 random;
+    std::array<can_frame_t, 12> periodic{};
+    int64_t now_us = 1700000000000000;
+
+  public:
+    explicit TrafficGenerator(uint32_t seed) : random(seed) {
+        for (size_t i = 0; i < periodic.size(); i++) {
+            periodic[i].identifier = static_cast<uint32_t>(0x0AA + 0x61 * i) & 0x7FF;
+            periodic[i].bus = i % 3 == 0 ? 1 : 0;
+            periodic[i].dlc = static_cast<uint8_t>(i % 9);
+        }
+        // Same ID on both buses, two dictionary entries
+        periodic[1].identifier = periodic[0].identifier;
+    }
+
+    auto Next() -> can_frame_t {
+        uint32_t kind = random() % 16;
+        switch (random() % 8) {
+        case 0:
+            now_us -= random() % 500; // reordered by the merger window
+            break;
+        case 1:
+            now_us += static_cast<int64_t>(random() % 5000000);
+            break;
+        default:
+            now_us += random() % 1000;
+            break;
+        }
+
+        can_frame_t frame{};
+        if (kind < 11) {
+            can_frame_t &source = periodic[random() % periodic.size()];
+            for (uint32_t changes = random() % 3; changes; changes--) {
+                source.data[random() % 8] = static_cast<uint8_t>(random());
+            }
+            frame = source;
+            uint8_t data_len = frame.dlc;
+            memset(frame.data + data_len, 0, sizeof(frame.data) - data_len);
+        } else if (kind < 14) {
+            frame.extd = true;
+            frame.identifier = kind == 13 ? random() % 0x800 : random() & 0x1FFFFFFF;
+            frame.bus = random() % 2;
+            frame.dlc = static_cast<uint8_t>(random() % 9);
+            for (uint8_t i = 0; i < frame.dlc; i++) {
+                frame.data[i] = static_cast<uint8_t>(random());
+            }
+        } else {
+            frame.rtr = true;
+            frame.extd = kind == 15;
+            frame.identifier = kind == 15 ? random() & 0x1FFFFFFF : random() % 0x800;
+            frame.bus = random() % 2;
+            frame.dlc = static_cast<uint8_t>(random() % 9);
+        }
+        frame.timestamp_us = now_us;
+        return frame;
+    }
+};
+
+static auto CheckVarints() -> void {
+    static constexpr int64_t SIGNED[] = {0, 1, -1, 63, -64, 64, -65, 1000000, -1000000, INT64_MAX, INT64_MIN};
+    for (int64_t value : SIGNED) {
+        CHECK_EQ(UnZigZag(ZigZag(value)), value);
+    }
+    CHECK_EQ(ZigZag(0), 0);
+    CHECK_EQ(ZigZag(-1), 1);
+    CHECK_EQ(ZigZag(1), 2);
+    CHECK(ZigZag(INT64_MIN) == UINT64_MAX);
+
+    static constexpr uint64_t UNSIGNED[] = {0, 1, 0x7F, 0x80, 0x3FFF, 0x4000, 0x1FFFFFFF, UINT64_MAX};
+    static constexpr size_t LENGTHS[] = {1, 1, 1, 2, 2, 3, 5, 10};
+    for (size_t i = 0; i < sizeof(UNSIGNED) / sizeof(UNSIGNED[0]); i++) {
+        uint8_t buffer[10];
+        size_t n = PutVarint(buffer, UNSIGNED[i]);
+        CHECK_EQ(n, LENGTHS[i]);
+        uint64_t decoded = 0;
+        CHECK_EQ(GetVarint(buffer, buffer + n, decoded), n);
+        CHECK(decoded == UNSIGNED[i]);
+        // Cut short it does not decode
+        CHECK_EQ(GetVarint(buffer, buffer + n - 1, decoded), 0);
+    }
+}
+
+// Fills blocks with generated traffic and decodes each one, every field of every frame comes back
+static auto CheckRoundTrip() -> void {
+    TrafficGenerator traffic(7);
+    BlockEncoder encoder;
+    block_t block{};
+    uint32_t frames = 0;
+    size_t bytes = 0;
+
+    for (uint32_t sequence = 0; sequence < 200; sequence++) {
+        std::vector<can_frame_t> sent;
+        encoder.Begin(block.data(), sequence);
+        while (true) {
+            can_frame_t frame = traffic.Next();
+            size_t used = encoder.Used();
+            if (!encoder.Append(frame)) {
+                // A record that does not fit leaves the block as it was
+                CHECK_EQ(encoder.Used(), used);
+                CHECK(used + MAX_RECORD_SIZE > BLOCK_SIZE);
+                break;
+            }
+            sent.push_back(frame);
+        }
+        size_t used = encoder.Finish();
+
+        flight_block_header_t header;
+        CHECK(ReadHeader(block.data(), header));
+        CHECK_EQ(header.sequence, sequence);
+        CHECK_EQ(header.frame_count, sent.size());
+        CHECK_EQ(header.payload_bytes, used - HEADER_SIZE);
+        CHECK_EQ(header.base_timestamp_us, sent.front().timestamp_us);
+
+        size_t decoded = 0;
+        CHECK(DecodeBlock(block.data(), [&](const can_frame_t &frame) {
+            if (decoded < sent.size() && !SameFrame(frame, sent[decoded])) {
+                fprintf(stderr, "block %u frame %zu: got %03lx bus %u dlc %u at %lld\n", sequence, decoded,
+                        static_cast<unsigned long>(frame.identifier), frame.bus, frame.dlc,
+                        static_cast<long long>(frame.timestamp_us));
+                host_check::Fail(__FILE__, __LINE__, "decoded frame matches");
+            }
+            decoded++;
+        }));
+        CHECK_EQ(decoded, sent.size());
+        frames += static_cast<uint32_t>(sent.size());
+        bytes += used;
+    }
+    printf("round trip: %u frames in 200 blocks, %.2f bytes/frame\n", frames,
+           static_cast<double>(bytes) / static_cast<double>(frames));
+}
+
+// More standard IDs than the dictionary holds: the first DICT_SIZE become entries and shrink to slot plus changed
+// mask, the rest stay literal
+static auto CheckDictionaryOverflow() -> void {
+    static constexpr uint32_t IDS = DICT_SIZE + 45;
+    BlockEncoder encoder;
+    block_t block{};
+    encoder.Begin(block.data(), 1);
+    std::vector<can_frame_t> sent;
+    int64_t now_us = 0;
+    auto append = [&](uint32_t id, uint8_t value) -> size_t {
+        can_frame_t frame{};
+        frame.identifier = id;
+        frame.dlc = 2;
+        frame.data[0] = value;
+        frame.data[1] = 0x5A;
+        frame.timestamp_us = now_us += 50;
+        size_t used = encoder.Used();
+        CHECK(encoder.Append(frame));
+        sent.push_back(frame);
+        return encoder.Used() - used;
+    };
+
+    for (uint32_t id = 0; id < IDS; id++) {
+        append(id, 1);
+    }
+    for (uint32_t id = 0; id < IDS; id++) {
+        uint8_t value = id % 2 ? 2 : 1;
+        size_t record = append(id, value);
+        if (id < DICT_SIZE) {
+            // flags, one byte delta, slot, changed mask, the changed byte
+            CHECK_EQ(record, value == 1 ? 4 : 5);
+        } else {
+            // flags, one byte delta, two byte ID, both data bytes
+            CHECK_EQ(record, 6);
+        }
+    }
+    encoder.Finish();
+
+    size_t decoded = 0;
+    CHECK(DecodeBlock(block.data(), [&](const can_frame_t &frame) {
+        CHECK(decoded < sent.size() && SameFrame(frame, sent[decoded]));
+        decoded++;
+    }));
+    CHECK_EQ(decoded, sent.size());
+}
+
+// A record cut off by payload_bytes ends the block as corrupt, the frames before it still decode
+static auto CheckTruncatedPayload() -> void {
+    TrafficGenerator traffic(11);
+    BlockEncoder encoder;
+    block_t block{};
+    encoder.Begin(block.data(), 5);
+    for (int i = 0; i < 50; i++) {
+        CHECK(encoder.Append(traffic.Next()));
+    }
+    encoder.Finish();
+    flight_block_header_t header;
+    CHECK(ReadHeader(block.data(), header));
+    header.payload_bytes -= 3;
+    memcpy(block.data(), &header, HEADER_SIZE);
+
+    BlockDecoder decoder;
+    CHECK(decoder.Begin(block.data()));
+    can_frame_t frame;
+    uint32_t count = 0;
+    while (decoder.Next(frame)) {
+        count++;
+    }
+    CHECK(decoder.Corrupt());
+    CHECK_EQ(count, 49);
+}
+
+// Writes blocks the way FlightRecorder does into a ring of sectors, the sequence wrapping past UINT32_MAX. The
+// sector after the newest block was being written when power went: its payload is there and its header erased or
+// half programmed. FlightLogSource skips it and reads every other block oldest first.
+static auto CheckRing() -> void {
+    static constexpr uint32_t SECTORS = 8;
+    static constexpr uint32_t BLOCKS_WRITTEN = 24;
+    static constexpr uint32_t FIRST_SEQUENCE = UINT32_MAX - 9;
+    TrafficGenerator traffic(23);
+    MemoryBlockStore store(SECTORS);
+    BlockEncoder encoder;
+    std::vector<std::vector<can_frame_t>> written(BLOCKS_WRITTEN);
+
+    for (uint32_t i = 0; i < BLOCKS_WRITTEN; i++) {
+        block_t block{};
+        encoder.Begin(block.data(), FIRST_SEQUENCE + i);
+        for (uint32_t count = 20 + i * 3; count; count--) {
+            can_frame_t frame = traffic.Next();
+            CHECK(encoder.Append(frame));
+            written[i].push_back(frame);
+        }
+        size_t used = encoder.Finish();
+        block_t &sector = store.blocks[i % SECTORS];
+        sector.fill(0xFF);
+        memcpy(sector.data(), block.data(), used);
+    }
+    // The last block written is the torn one, it landed in the last sector
+    static_assert(BLOCKS_WRITTEN % SECTORS == 0);
+    const uint32_t torn = (BLOCKS_WRITTEN - 1) % SECTORS;
+    auto read_all = [&](uint32_t expected_first) {
+        FlightLogSource source(store);
+        can_frame_t frame;
+        uint32_t block = expected_first;
+        size_t index = 0;
+        uint32_t frames = 0;
+        while (source.Next(frame)) {
+            if (index == written[block].size()) {
+                block++;
+                index = 0;
+            }
+            CHECK(block < BLOCKS_WRITTEN - 1 && SameFrame(frame, written[block][index]));
+            index++;
+            frames++;
+        }
+        CHECK_EQ(block, BLOCKS_WRITTEN - 2);
+        CHECK_EQ(index, written[block].size());
+        CHECK_EQ(source.CorruptBlocks(), 0);
+        return frames;
+    };
+
+    store.blocks[torn].fill(0xFF);
+    block_t payload_only{};
+    encoder.Begin(payload_only.data(), FIRST_SEQUENCE + BLOCKS_WRITTEN - 1);
+    for (const can_frame_t &frame : written.back()) {
+        CHECK(encoder.Append(frame));
+    }
+    size_t used = encoder.Finish();
+    memcpy(store.blocks[torn].data() + HEADER_SIZE, payload_only.data() + HEADER_SIZE, used - HEADER_SIZE);
+    // Erased header: the oldest readable block is the one after the torn sector, 7 blocks back from the newest
+    uint32_t erased_frames = read_all(BLOCKS_WRITTEN - SECTORS);
+
+    // Half programmed header: magic and sequence written, the rest still erased
+    memcpy(store.blocks[torn].data(), payload_only.data(), 8);
+    CHECK_EQ(read_all(BLOCKS_WRITTEN - SECTORS), erased_frames);
+
+    // Rewind reads the same frames again
+    FlightLogSource source(store);
+    can_frame_t frame;
+    uint32_t first = 0;
+    while (source.Next(frame)) {
+        first++;
+    }
+    CHECK(source.Rewind());
+    uint32_t second = 0;
+    while (source.Next(frame)) {
+        second++;
+    }
+    CHECK_EQ(first, erased_frames);
+    CHECK_EQ(second, erased_frames);
+}
+
+int main() {
+    CheckVarints();
+    CheckRoundTrip();
+    CheckDictionaryOverflow();
+    CheckTruncatedPayload();
+    CheckRing();
+    return host_check::Result("flight_log_test");
+}
@@ -0,0 +1,171 @@
+// Renders the RPM gauge through every GaugeRenderer on the headless display and reports per-frame damage and draw
+// time, the host side of choosing arc_config::renderer. Then does the same for the RPM readout, lv_label against
+// NumericReadout, counting heap allocations made by the update calls.
+//   gauge_bench [--frames N]
+// The sweep is a slow rev up and down with small per-frame steps, the pattern the RPM gauge sees while driving.
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DamageMeter.hpp"
+#include "GaugeArc.hpp"
+#include "Hal.hpp"
+#include "NumericReadout.hpp"
+#include "gaugeMath.hpp"
+#include "hexCodes.hpp"
+
+struct renderer_case_t {
+    GaugeRenderer renderer;
+    const char *name;
+};
+
+static constexpr renderer_case_t CASES[] = {
+    {GaugeRenderer::STOCK, "lv_arc"},
+    {GaugeRenderer::ARC, "arc"},
+    {GaugeRenderer::SPRITE, "sprite"},
+};
+
+// LVGL allocates through the C library on the host, so counting here sees lv_malloc and lv_realloc too
+static std::atomic<bool> count_allocations{false};
+static std::atomic<uint64_t> allocations{0};
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) noexcept {
+    if (count_allocations) {
+        allocations++;
+    }
+    return __libc_malloc(size);
+}
+void *calloc(size_t count, size_t size) noexcept {
+    if (count_allocations) {
+        allocations++;
+    }
+    return __libc_calloc(count, size);
+}
+void *realloc(void *ptr, size_t size) noexcept {
+    if (count_allocations) {
+        allocations++;
+    }
+    return __libc_realloc(ptr, size);
+}
+}
+
+static auto SweepRpm(uint32_t frame) -> int32_t {
+    double phase = static_cast<double>(frame) / 600.0;
+    return static_cast<int32_t>(3750 - 2950 * cos(phase * 2 * M_PI));
+}
+
+static auto NowNs() -> int64_t {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static auto PrintReadoutRow(const char *name, uint32_t updates, int64_t update_ns, const damage_stats_t &stats)
+    -> void {
+    printf("%-8s %8lu %12.2f %10llu %12llu\n", name, static_cast<unsigned long>(updates),
+           static_cast<double>(allocations) / updates, static_cast<unsigned long long>(update_ns / updates),
+           static_cast<unsigned long long>(stats.frames ? stats.render_us / stats.frames : 0));
+}
+
+int main(int argc, char **argv) {
+    uint32_t frames = 2000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else {
+            fprintf(stderr, "usage: gauge_bench [--frames N]\n");
+            return 1;
+        }
+    }
+
+    hal::DisplayInit();
+    // Refreshes are driven from here, the LVGL thread stays parked on the lock
+    hal::DisplayLock(0);
+    DamageMeter damage;
+    damage.Attach(lv_display_get_default());
+
+    gauge_arc_config_t config;
+    config.size = RPM_ARC_SIZE;
+    config.rotation = RPM_ARC_ROTATION;
+    config.span = RPM_ARC_ANGLE;
+    config.width = ARC_WIDTH;
+    config.color = GAUGE_COLOR;
+    config.min = RPM_ARC_MIN;
+    config.max = RPM_ARC_MAX;
+
+    printf("%-8s %8s %10s %12s %12s\n", "renderer", "frames", "px/frame", "avg draw us", "max draw us");
+    for (const renderer_case_t &test : CASES) {
+        config.renderer = test.renderer;
+        GaugeArc gauge(lv_screen_active(), config);
+        lv_refr_now(nullptr);
+        damage.ResetStats();
+
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            gauge.SetValue(SweepRpm(frame));
+            lv_refr_now(nullptr);
+        }
+
+        const damage_stats_t &stats = damage.GetStats();
+        printf("%-8s %8lu %10llu %12llu %12lu\n", test.name, static_cast<unsigned long>(stats.frames),
+               static_cast<unsigned long long>(stats.frames ? stats.pixels / stats.frames : 0),
+               static_cast<unsigned long long>(stats.frames ? stats.render_us / stats.frames : 0),
+               static_cast<unsigned long>(stats.max_render_us));
+        // The sprite buffers stay allocated, this process ends after the last case anyway
+        lv_obj_delete(gauge.Obj());
+        lv_refr_now(nullptr);
+    }
+
+    printf("\n%-8s %8s %12s %10s %12s\n", "readout", "updates", "allocs/upd", "update ns", "avg draw us");
+    {
+        lv_obj_t *label = lv_label_create(lv_screen_active());
+        lv_obj_align(label, LV_ALIGN_CENTER, LABEL_OFFSET_X, RPM_LABEL_OFFSET_Y);
+        lv_refr_now(nullptr);
+        damage.ResetStats();
+        allocations = 0;
+        int64_t update_ns = 0;
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            int64_t start = NowNs();
+            count_allocations = true;
+            lv_label_set_text_fmt(label, "RPM: %i", static_cast<int>(SweepRpm(frame)));
+            count_allocations = false;
+            update_ns += NowNs() - start;
+            lv_refr_now(nullptr);
+        }
+        PrintReadoutRow("lv_label", frames, update_ns, damage.GetStats());
+        lv_obj_delete(label);
+        lv_refr_now(nullptr);
+    }
+    {
+        NumericReadout readout(lv_screen_active(), "RPM: ", 4, LABEL_OFFSET_X, RPM_LABEL_OFFSET_Y);
+        lv_refr_now(nullptr);
+        damage.ResetStats();
+        allocations = 0;
+        int64_t update_ns = 0;
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            int64_t start = NowNs();
+            count_allocations = true;
+            readout.SetValue(SweepRpm(frame));
+            count_allocations = false;
+            update_ns += NowNs() - start;
+            lv_refr_now(nullptr);
+        }
+        PrintReadoutRow("readout", frames, update_ns, damage.GetStats());
+        if (allocations) {
+            fprintf(stderr, "NumericReadout::SetValue allocated %llu times\n",
+                    static_cast<unsigned long long>(allocations.load()));
+            std::quick_exit(1);
+        }
+        lv_obj_delete(readout.Obj());
+    }
+    hal::DisplayUnlock();
+    fflush(stdout);
+    std::quick_exit(0);
+}
@@ -0,0 +1,215 @@
+#pragma once
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+// ESP_LOGx for the host build. The format is checked against the arguments at compile time, as -Wformat does on the
+// device. The one leniency is the l length: it takes 32-bit integers as well, because uint32_t is unsigned long on
+// the device and unsigned int here, and those arguments are converted to long before they reach printf. Everything
+// else has to match the host types, %zu for size_t and %lld for int64_t, and is passed as it is.
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <type_traits>
+#include <utility>
+
+#include "HalLinux.hpp"
+
+namespace host_log {
+
+enum class ArgKind : uint8_t {
+    INTEGER,
+    SIZE, // size_t and ptrdiff_t
+    FLOATING,
+    STRING,
+    POINTER,
+    OTHER,
+};
+
+struct arg_type_t {
+    ArgKind kind;
+    uint8_t size;
+};
+
+template <typename T>
+consteval auto DescribeArg() -> arg_type_t {
+    if constexpr (std::is_same_v<T, size_t> || std::is_same_v<T, ptrdiff_t>) {
+        return {ArgKind::SIZE, sizeof(T)};
+    } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        return {ArgKind::INTEGER, sizeof(T)};
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return {ArgKind::FLOATING, sizeof(T)};
+    } else if constexpr (std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char>) {
+        return {ArgKind::STRING, sizeof(T)};
+    } else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>) {
+        return {ArgKind::POINTER, sizeof(T)};
+    } else {
+        return {ArgKind::OTHER, sizeof(T)};
+    }
+}
+
+// Not constexpr, so a consteval check that reaches one of these fails to compile with its name in the error
+inline auto FormatHasTooFewArguments() -> void {}
+inline auto FormatHasTooManyArguments() -> void {}
+inline auto FormatArgumentDoesNotMatchConversion() -> void {}
+inline auto FormatConversionNotSupported() -> void {}
+
+consteval auto IntegerMatches(arg_type_t arg, char length) -> bool {
+    switch (length) {
+    case 'l':
+        return (arg.kind == ArgKind::INTEGER || arg.kind == ArgKind::SIZE) && (arg.size == 4 || arg.size == 8);
+    case 'q':
+        return (arg.kind == ArgKind::INTEGER || arg.kind == ArgKind::SIZE) && arg.size == 8;
+    case 'z':
+    case 't':
+        return arg.kind == ArgKind::SIZE;
+    default:
+        return arg.kind == ArgKind::INTEGER && arg.size <= 4;
+    }
+}
+
+consteval auto ConversionMatches(arg_type_t arg, char length, char conversion) -> bool {
+    switch (conversion) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    case 'c':
+        return IntegerMatches(arg, length);
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        return arg.kind == ArgKind::FLOATING && length == 0;
+    case 's':
+        return arg.kind == ArgKind::STRING && length == 0;
+    case 'p':
+        return (arg.kind == ArgKind::POINTER || arg.kind == ArgKind::STRING) && length == 0;
+    default:
+        FormatConversionNotSupported();
+        return false;
+    }
+}
+
+// Checks the argument of one conversion and records its length, '*' is the int of a * width or precision
+consteval auto TakeArgument(const arg_type_t *args, char *lengths, size_t count, size_t &next, char length,
+                            char conversion) -> void {
+    if (next == count) {
+        FormatHasTooFewArguments();
+    }
+    lengths[next] = length;
+    arg_type_t arg = args[next++];
+    bool matches = conversion == '*' ? arg.kind == ArgKind::INTEGER && arg.size <= 4
+                                     : ConversionMatches(arg, length, conversion);
+    if (!matches) {
+        FormatArgumentDoesNotMatchConversion();
+    }
+}
+
+// Length of the conversion each argument goes to, 0 for none
+template <size_t COUNT>
+struct arg_lengths_t {
+    char length[COUNT + 1];
+};
+
+// Walks the conversions of format and checks each against the next argument, ll and j are folded into 'q'
+template <typename... Args>
+consteval auto CheckFormat(const char *format) -> arg_lengths_t<sizeof...(Args)> {
+    constexpr size_t count = sizeof...(Args);
+    constexpr arg_type_t args[count + 1] = {DescribeArg<Args>()..., {ArgKind::OTHER, 0}};
+    arg_lengths_t<count> lengths{};
+    size_t next = 0;
+
+    for (const char *p = format; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        p++;
+        if (*p == '%') {
+            continue;
+        }
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') {
+            p++;
+        }
+        if (*p == '*') {
+            TakeArgument(args, lengths.length, count, next, 0, '*');
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                TakeArgument(args, lengths.length, count, next, 0, '*');
+                p++;
+            }
+            while (*p >= '0' && *p <= '9') {
+                p++;
+            }
+        }
+        char length = 0;
+        if (*p == 'h') {
+            length = 'h';
+            p += p[1] == 'h' ? 2 : 1;
+        } else if (*p == 'l') {
+            length = p[1] == 'l' ? 'q' : 'l';
+            p += p[1] == 'l' ? 2 : 1;
+        } else if (*p == 'z' || *p == 't' || *p == 'j') {
+            length = *p == 'j' ? 'q' : *p;
+            p++;
+        }
+        if (!*p) {
+            FormatConversionNotSupported();
+            return lengths;
+        }
+        TakeArgument(args, lengths.length, count, next, length, *p);
+    }
+    if (next != count) {
+        FormatHasTooManyArguments();
+    }
+    return lengths;
+}
+
+// An argument as the conversion it goes to reads it: a 32-bit integer for the l length as long, int64_t (long here)
+// for ll as the long long of the same width, scoped enums as their underlying type, everything else unchanged
+template <char LENGTH, typename T>
+auto Pass(T value) {
+    if constexpr (std::is_enum_v<T>) {
+        return static_cast<std::underlying_type_t<T>>(value);
+    } else if constexpr (LENGTH == 'l' && std::is_integral_v<T> && sizeof(T) < sizeof(long)) {
+        return static_cast<std::conditional_t<std::is_signed_v<T>, long, unsigned long>>(value);
+    } else if constexpr (LENGTH == 'q' && std::is_integral_v<T>) {
+        return static_cast<std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>>(value);
+    } else {
+        return value;
+    }
+}
+
+// format() returns the format string, a lambda so it stays a constant expression in here and printf's own format
+// check sees it as well
+template <typename Format, typename... Args>
+auto Write(char level, const char *tag, Format format, Args... args) -> void {
+    static constexpr const char *FORMAT = Format{}();
+    [[maybe_unused]] static constexpr arg_lengths_t<sizeof...(Args)> LENGTHS = CheckFormat<Args...>(FORMAT);
+    (void)format;
+    fprintf(stderr, "%c (%lld) %s: ", level, static_cast<long long>(hal::NowUs() / 1000), tag);
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        fprintf(stderr, FORMAT, Pass<LENGTHS.length[I]>(args)...);
+    }(std::index_sequence_for<Args...>{});
+    fputc('\n', stderr);
+}
+
+} // namespace host_log
+
+#define ESP_LOGE(tag, format, ...) host_log::Write('E', tag, [] { return format; } __VA_OPT__(, ) __VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) host_log::Write('W', tag, [] { return format; } __VA_OPT__(, ) __VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) host_log::Write('I', tag, [] { return format; } __VA_OPT__(, ) __VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) host_log::Write('D', tag, [] { return format; } __VA_OPT__(, ) __VA_ARGS__)
+
+#endif
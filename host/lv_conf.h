@@ -0,0 +1,52 @@
+// LVGL configuration of the host build, kept in step with the CONFIG_LV_* values in sdkconfig
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#define LV_COLOR_DEPTH 16
+
+// The device gives LVGL a fixed arena (main/LvglHeap.hpp), here it stays on the C library so gauge_bench counts it
+#define LV_USE_STDLIB_MALLOC LV_STDLIB_CLIB
+#define LV_USE_STDLIB_STRING LV_STDLIB_CLIB
+#define LV_USE_STDLIB_SPRINTF LV_STDLIB_CLIB
+
+#define LV_DEF_REFR_PERIOD 15
+#define LV_DPI_DEF 130
+
+// The HAL's display lock serializes LVGL the way esp_lvgl_port does on the device
+#define LV_USE_OS LV_OS_NONE
+
+#define LV_DRAW_LAYER_SIMPLE_BUF_SIZE (24 * 1024)
+#define LV_DRAW_SW_COMPLEX 1
+#define LV_DRAW_SW_SHADOW_CACHE_SIZE 0
+#define LV_DRAW_SW_CIRCLE_CACHE_SIZE 4
+
+#define LV_CACHE_DEF_SIZE 0
+#define LV_IMAGE_HEADER_CACHE_DEF_CNT 0
+#define LV_GRADIENT_MAX_STOPS 2
+
+#define LV_USE_ASSERT_NULL 1
+#define LV_USE_ASSERT_MALLOC 1
+
+#define LV_FONT_MONTSERRAT_12 1
+#define LV_FONT_MONTSERRAT_14 1
+#define LV_FONT_MONTSERRAT_16 1
+#define LV_FONT_MONTSERRAT_18 1
+#define LV_FONT_MONTSERRAT_20 1
+#define LV_FONT_MONTSERRAT_22 1
+#define LV_FONT_MONTSERRAT_24 1
+#define LV_FONT_MONTSERRAT_26 1
+#define LV_FONT_DEFAULT &lv_font_montserrat_14
+#define LV_USE_FONT_COMPRESSED 1
+
+// MainDisplay::CacheBackground
+#define LV_USE_SNAPSHOT 1
+
+#ifndef LV_USE_SDL
+#define LV_USE_SDL 0
+#endif
+#if LV_USE_SDL
+#define LV_SDL_INCLUDE_PATH <SDL2/SDL.h>
+#define LV_SDL_RENDER_MODE LV_DISPLAY_RENDER_MODE_PARTIAL
+#endif
+
+#endif
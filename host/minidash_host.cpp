@@ -0,0 +1,130 @@
+// Host run of the dashboard: the same CAN task / UI task split as on the device, with LVGL rendering headless
+// (or into an SDL window with MINIDASH_HOST_SDL) and frames from a trace or a SocketCAN interface.
+//   minidash_host [--speed N] [--loop] [--seconds S] <trace.log | partition.bin>
+//   minidash_host --socketcan vcan0
+// Run it under perf record to profile MainDisplay and the decoders. The latency histograms are dumped at exit, the
+// same table the device prints with the "latency" console command.
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CanReceiver.hpp"
+#include "DashboardUi.hpp"
+#include "FrameCache.hpp"
+#include "Hal.hpp"
+#include "BootProfile.hpp"
+#include "HostTrace.hpp"
+#include "Latency.hpp"
+#include "ReplayBackend.hpp"
+#include "SocketCanBackend.hpp"
+#include "WarmStart.hpp"
+
+LV_IMG_DECLARE(MiniDash_v1_2);
+
+static constexpr int64_t STATS_PERIOD_US = 10000000;
+
+static FrameCache frame_cache;
+static LatencyTable latency;
+static std::atomic<bool> trace_done{false};
+static warm_region_t warm_region;
+
+struct can_task_args_t {
+    CanRxBackend *backend;
+    ReplayBackend *replay;
+};
+
+static void can_task(void *task_param) {
+    auto *args = static_cast<can_task_args_t *>(task_param);
+    can_rx_backends_t backends{};
+    backends[0] = args->backend;
+    CanReceiver receiver(backends);
+    while (!args->replay || !args->replay->Finished() || args->replay->Ring().Size()) {
+        receiver.ReceiveBatch([](const can_frame_t &frame) {
+            frame_cache.Store(frame);
+            latency.Record(LatencyStage::STORED, hal::NowUs() - frame.timestamp_us);
+        });
+    }
+    trace_done = true;
+}
+
+int main(int argc, char **argv) {
+    float speed = 1;
+    bool loop = false;
+    int64_t run_us = 0;
+    const char *path = nullptr;
+    const char *interface = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--loop") == 0) {
+            loop = true;
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            run_us = static_cast<int64_t>(strtod(argv[++i], nullptr) * 1e6);
+        } else if (strcmp(argv[i], "--socketcan") == 0 && i + 1 < argc) {
+            interface = argv[++i];
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            path = nullptr;
+            interface = nullptr;
+            break;
+        }
+    }
+    if (!path && !interface) {
+        fprintf(stderr, "usage: minidash_host [--speed N] [--loop] [--seconds S] <trace.log | partition.bin>\n"
+                        "       minidash_host [--seconds S] --socketcan <interface>\n");
+        return 2;
+    }
+
+    std::unique_ptr<HostTrace> trace;
+    std::unique_ptr<ReplayBackend> replay;
+    std::unique_ptr<SocketCanBackend> socket_can;
+    can_task_args_t can_args{};
+    if (interface) {
+        socket_can = std::make_unique<SocketCanBackend>(interface, 0);
+        can_args.backend = socket_can.get();
+    } else {
+        trace = std::make_unique<HostTrace>(path);
+        if (!trace->Source()) {
+            fprintf(stderr, "can not read %s\n", path);
+            return 1;
+        }
+        replay = std::make_unique<ReplayBackend>(*trace->Source(), speed, loop);
+        can_args.backend = replay.get();
+        can_args.replay = replay.get();
+    }
+
+    // A process start is always a cold boot, timed from here
+    BootProfile boot(hal::NowUs());
+    WarmStart warm_start(warm_region, false);
+    hal::DisplayInit();
+    boot.Mark(BootPhase::LVGL_UP);
+    DashboardUi ui(frame_cache, latency, warm_start, boot);
+    ui.Setup(&MiniDash_v1_2);
+    hal::TaskCreate(can_task, "CAN TASK", 0, &can_args, 5, 0);
+
+    int64_t start = hal::NowUs();
+    int64_t last_stats = start;
+    while (!trace_done && (run_us == 0 || hal::NowUs() - start < run_us)) {
+        if (hal::NowUs() - last_stats >= STATS_PERIOD_US) {
+            last_stats = hal::NowUs();
+            ui.LogStats();
+        }
+        hal::SleepMs(100);
+    }
+    // Let the last values reach a refresh
+    hal::SleepMs(50);
+
+    hal::DisplayLock(0);
+    hal::host_display_stats_t display = hal::DisplayStats();
+    hal::DisplayUnlock();
+    ui.LogStats();
+    ESP_LOGI("UI", "refreshes: %lu flushes: %lu pixels: %llu", display.refreshes, display.flushes, display.pixels);
+    latency.Dump("LATENCY");
+    // The LVGL and CAN threads never return, leave without running static destructors under them
+    fflush(stdout);
+    std::quick_exit(0);
+}
@@ -0,0 +1,162 @@
+// The LVGL-free side of NumericReadout (DigitCells): the atlas index of every cell against printf's right-aligned
+// formatting, the cells a value change redraws and where they sit, and no heap allocation in Set. gauge_bench
+// covers the LVGL side when LVGL is available.
+#include <new>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DigitCells.hpp"
+#include "HostCheck.hpp"
+
+static size_t allocations = 0;
+
+auto operator new(size_t size) -> void * {
+    allocations++;
+    if (void *p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+auto operator delete(void *p) noexcept -> void {
+    free(p);
+}
+auto operator delete(void *p, size_t /*size*/) noexcept -> void {
+    free(p);
+}
+
+static constexpr int32_t PREFIX_WIDTH = 47;
+static constexpr int32_t CELL_WIDTH = 13;
+static constexpr int32_t CELL_HEIGHT = 21;
+
+// Value as the readout should show it, one char per cell with ' ' for a blank
+struct shown_text_t {
+    char text[DigitCells::MAX_DIGITS + 1];
+};
+
+static auto Expected(uint8_t digits, int32_t value, int32_t max_value) -> shown_text_t {
+    shown_text_t shown{};
+    value = value < 0 ? 0 : (value > max_value ? max_value : value);
+    char padded[12];
+    int len = snprintf(padded, sizeof(padded), "%6d", static_cast<int>(value));
+    memcpy(shown.text, padded + len - digits, digits);
+    return shown;
+}
+
+static auto Shown(const DigitCells &cells) -> shown_text_t {
+    shown_text_t shown{};
+    for (uint8_t cell = 0; cell < cells.Count(); cell++) {
+        uint8_t digit = cells.Digit(cell);
+        shown.text[cell] = digit == DigitCells::BLANK ? ' ' : (digit < 10 ? static_cast<char>('0' + digit) : '?');
+    }
+    return shown;
+}
+
+// Sets value and checks the cells and the redraw mask against the text before and after
+static auto CheckSet(DigitCells &cells, int32_t value) -> void {
+    shown_text_t before = Shown(cells);
+    shown_text_t expected = Expected(cells.Count(), value, cells.MaxValue());
+    uint32_t changed = cells.Set(value);
+    shown_text_t after = Shown(cells);
+    for (uint8_t cell = 0; cell < cells.Count(); cell++) {
+        CHECK_EQ(after.text[cell], expected.text[cell]);
+        CHECK_EQ((changed >> cell) & 1, before.text[cell] != after.text[cell]);
+    }
+    CHECK_EQ(changed >> cells.Count(), 0);
+}
+
+static auto CheckInitialAndClamp() -> void {
+    DigitCells cells(4);
+    CHECK_EQ(cells.Count(), 4);
+    CHECK_EQ(cells.MaxValue(), 9999);
+    for (uint8_t cell = 0; cell < 4; cell++) {
+        CHECK_EQ(cells.Digit(cell), DigitCells::BLANK);
+    }
+    // Zero shows one digit, the blanks it leaves were already blank
+    CHECK_EQ(cells.Set(0), 1U << 3);
+    CHECK_EQ(cells.Set(0), 0);
+    CHECK_EQ(cells.Set(-250), 0);
+    CHECK_EQ(cells.Set(12345), 0xF);
+    CHECK_EQ(cells.Digit(0), 9);
+    CHECK_EQ(cells.Set(INT32_MAX), 0);
+    // 9999 -> 9990 redraws the last cell only
+    CHECK_EQ(cells.Set(9990), 1U << 3);
+    // 9990 -> 990 blanks the first cell and keeps the rest
+    CHECK_EQ(cells.Set(990), 1U << 0);
+
+    DigitCells capped(9);
+    CHECK_EQ(capped.Count(), DigitCells::MAX_DIGITS);
+    CHECK_EQ(capped.MaxValue(), 999999);
+    DigitCells single(1);
+    CheckSet(single, 7);
+    CheckSet(single, -1);
+    CheckSet(single, 42);
+}
+
+// Every value of a four cell readout in order and in reverse, then random jumps on every width
+static auto CheckAllValues() -> void {
+    DigitCells cells(4);
+    for (int32_t value = 0; value <= 9999; value++) {
+        CheckSet(cells, value);
+    }
+    for (int32_t value = 9999; value >= 0; value--) {
+        CheckSet(cells, value);
+    }
+
+    std::mt19937 random(99);
+    for (uint8_t digits = 1; digits <= DigitCells::MAX_DIGITS; digits++) {
+        DigitCells jumping(digits);
+        for (int i = 0; i < 20000; i++) {
+            int32_t value = static_cast<int32_t>(random() % 2200000) - 100000;
+            CheckSet(jumping, i % 3 ? value : value % 100);
+        }
+    }
+}
+
+// Cells tile the readout right after the prefix without gaps or overlap
+static auto CheckCellRects() -> void {
+    static constexpr int32_t X = 300;
+    static constexpr int32_t Y = 410;
+    static_assert(DigitCells::CellRect(X, Y, PREFIX_WIDTH, CELL_WIDTH, CELL_HEIGHT, 0).x1 == X + PREFIX_WIDTH);
+    for (uint8_t cell = 0; cell < DigitCells::MAX_DIGITS; cell++) {
+        cell_rect_t rect = DigitCells::CellRect(X, Y, PREFIX_WIDTH, CELL_WIDTH, CELL_HEIGHT, cell);
+        CHECK_EQ(rect.x2 - rect.x1 + 1, CELL_WIDTH);
+        CHECK_EQ(rect.y1, Y);
+        CHECK_EQ(rect.y2 - rect.y1 + 1, CELL_HEIGHT);
+        if (cell) {
+            cell_rect_t left = DigitCells::CellRect(X, Y, PREFIX_WIDTH, CELL_WIDTH, CELL_HEIGHT, cell - 1);
+            CHECK_EQ(rect.x1, left.x2 + 1);
+        }
+    }
+    cell_rect_t last = DigitCells::CellRect(X, Y, PREFIX_WIDTH, CELL_WIDTH, CELL_HEIGHT, DigitCells::MAX_DIGITS - 1);
+    CHECK_EQ(last.x2, X + PREFIX_WIDTH + DigitCells::MAX_DIGITS * CELL_WIDTH - 1);
+}
+
+// An RPM sweep like gauge_bench's readout run, Set must not touch the heap
+static auto CheckNoAllocations() -> void {
+    DigitCells cells(4);
+    uint32_t redrawn = 0;
+    size_t before = allocations;
+    for (int32_t frame = 0; frame < 100000; frame++) {
+        int32_t rpm = frame % 2000 < 1000 ? frame % 1000 * 8 : 8000 - frame % 1000 * 8;
+        uint32_t changed = cells.Set(rpm);
+        while (changed) {
+            redrawn++;
+            changed &= changed - 1;
+        }
+    }
+    CHECK_EQ(allocations - before, 0);
+    // A step of 8 rpm mostly changes the last one or two cells, a whole-readout redraw would be 400000
+    CHECK(redrawn < 100000 * 2);
+    printf("sweep: %u cells redrawn in 100000 updates, %zu allocations\n", redrawn, allocations - before);
+}
+
+int main() {
+    CheckInitialAndClamp();
+    CheckAllValues();
+    CheckCellRects();
+    CheckNoAllocations();
+    return host_check::Result("numeric_readout_test");
+}
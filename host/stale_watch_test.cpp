@@ -0,0 +1,167 @@
+// StaleWatch, the gauge greying of DashboardUi: restored values age from the restore, and a trace replayed in real
+// time through ReplayBackend, FrameCache and SignalReader keeps every gauge live until it stops, after which each
+// one goes stale within its *_STALE_MS deadline plus one check period. The poll and check cadence is the one of
+// DashboardUi's timers.
+#include <array>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "FrameCache.hpp"
+#include "Hal.hpp"
+#include "HostCheck.hpp"
+#include "ReplayBackend.hpp"
+#include "StaleWatch.hpp"
+#include "TraceSource.hpp"
+#include "VehicleState.hpp"
+
+static constexpr uint32_t POLL_MS = 15; // LV_DEF_REFR_PERIOD of host/lv_conf.h
+static constexpr uint32_t DISPLAYED = SignalBit(Signal::RPM) | SignalBit(Signal::SPEED) | SignalBit(Signal::FUEL) |
+                                      SignalBit(Signal::TEMP);
+// Scheduling noise of a loaded host on top of the check period
+static constexpr int64_t SLACK_US = 60000;
+
+class VectorSource : public TraceSource {
+  private:
+    std::vector<can_frame_t> frames;
+    size_t next = 0;
+
+  public:
+    explicit VectorSource(std::vector<can_frame_t> trace) : frames(std::move(trace)) {}
+    auto Next(can_frame_t &frame) -> bool override {
+        if (next == frames.size()) {
+            return false;
+        }
+        frame = frames[next++];
+        return true;
+    }
+    auto Rewind() -> bool override {
+        next = 0;
+        return true;
+    }
+};
+
+static auto Frame(int64_t timestamp_us, uint32_t identifier) -> can_frame_t {
+    can_frame_t frame{};
+    frame.timestamp_us = timestamp_us;
+    frame.identifier = identifier;
+    frame.dlc = 8;
+    frame.data[0] = 0x80;
+    frame.data[5] = 0x40;
+    return frame;
+}
+
+// The dash's frames at their usual rates for duration_ms
+static auto DashTrace(int64_t duration_ms) -> std::vector<can_frame_t> {
+    std::vector<can_frame_t> trace;
+    for (int64_t ms = 0; ms < duration_ms; ms += 10) {
+        int64_t at = 1000000 + ms * 1000;
+        trace.push_back(Frame(at, TORQ3));
+        if (ms % 20 == 0) {
+            trace.push_back(Frame(at + 100, SPEED));
+        }
+        if (ms % 100 == 0) {
+            trace.push_back(Frame(at + 200, ENGDATA));
+            trace.push_back(Frame(at + 300, FUELMLS));
+        }
+    }
+    return trace;
+}
+
+static auto CheckRestored() -> void {
+    StaleWatch watch(GAUGE_STALE_AFTER_MS);
+    vehicle_state_t state{};
+    static constexpr int64_t RESTORED_US = 3000000;
+    uint32_t restored = SignalBit(Signal::RPM) | SignalBit(Signal::FUEL);
+
+    // Nothing received or restored is stale from the start, signals without a deadline never are
+    CHECK_EQ(watch.Check(state, restored, RESTORED_US, RESTORED_US),
+             SignalBit(Signal::SPEED) | SignalBit(Signal::TEMP));
+    CHECK_EQ(watch.Check(state, restored, RESTORED_US, RESTORED_US + RPM_STALE_MS * 1000LL), 0);
+    CHECK_EQ(watch.Check(state, restored, RESTORED_US, RESTORED_US + RPM_STALE_MS * 1000LL + 1),
+             SignalBit(Signal::RPM));
+
+    // A live value replaces the restored one
+    state.rx_time_us[static_cast<size_t>(Signal::RPM)] = RESTORED_US + 600000;
+    state.rx_time_us[static_cast<size_t>(Signal::SPEED)] = RESTORED_US + 600000;
+    int64_t now = RESTORED_US + 700000;
+    CHECK_EQ(watch.Check(state, restored, RESTORED_US, now), SignalBit(Signal::RPM) | SignalBit(Signal::SPEED));
+    CHECK_EQ(watch.Stale(), SignalBit(Signal::TEMP));
+    now = RESTORED_US + FUEL_STALE_MS * 1000LL + 1;
+    CHECK_EQ(watch.Check(state, restored, RESTORED_US, now),
+             SignalBit(Signal::FUEL) | SignalBit(Signal::RPM) | SignalBit(Signal::SPEED));
+    CHECK_EQ(watch.Stale(), DISPLAYED);
+}
+
+// Replays 400 ms of traffic in real time, then the bus goes silent
+static auto CheckTraceStops() -> void {
+    VectorSource source(DashTrace(400));
+    ReplayBackend replay(source, 1.0f, false);
+    FrameCache cache;
+    SignalReader reader(cache, DISPLAYED);
+    StaleWatch watch(GAUGE_STALE_AFTER_MS);
+
+    std::array<int64_t, SIGNAL_COUNT> stale_at{};
+    uint32_t went_live = 0;
+    uint32_t stale_while_playing = 0;
+    int64_t start = hal::NowUs();
+    int64_t next_poll = start;
+    int64_t next_check = start;
+    int64_t deadline = start + 4000000;
+
+    while (hal::NowUs() < deadline) {
+        int64_t now = hal::NowUs();
+        if (now >= next_poll) {
+            next_poll += POLL_MS * 1000;
+            if (replay.WaitForFrames(0)) {
+                replay.Ring().Drain([&](const can_frame_t &frame) { cache.Store(frame); });
+            }
+            reader.Poll();
+        }
+        if (now >= next_check) {
+            next_check += STALE_CHECK_MS * 1000;
+            uint32_t flipped = watch.Check(reader.State(), 0, 0, now);
+            went_live |= ~watch.Stale() & DISPLAYED;
+            for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+                if (!(flipped & (1U << i)) || !reader.State().rx_time_us[i]) {
+                    continue;
+                }
+                if (!(watch.Stale() & (1U << i))) {
+                    continue;
+                }
+                if (!replay.Finished()) {
+                    stale_while_playing |= 1U << i;
+                } else {
+                    stale_at[i] = now;
+                }
+            }
+            if (replay.Finished() && watch.Stale() == DISPLAYED) {
+                break;
+            }
+        }
+        hal::SleepMs(1);
+    }
+
+    CHECK_EQ(went_live, DISPLAYED);
+    CHECK_EQ(stale_while_playing, 0);
+    CHECK(replay.Finished());
+    CHECK_EQ(watch.Stale(), DISPLAYED);
+    for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+        if (!(DISPLAYED & (1U << i))) {
+            continue;
+        }
+        int64_t silent_us = stale_at[i] - reader.State().rx_time_us[i];
+        int64_t deadline_us = GAUGE_STALE_AFTER_MS[i] * 1000LL;
+        CHECK(stale_at[i] != 0);
+        CHECK(silent_us > deadline_us);
+        CHECK(silent_us <= deadline_us + STALE_CHECK_MS * 1000LL + SLACK_US);
+        printf("%s stale %lld ms after its last frame, deadline %ld ms\n", SIGNAL_NAMES[i],
+               static_cast<long long>(silent_us / 1000), static_cast<long>(GAUGE_STALE_AFTER_MS[i]));
+    }
+}
+
+int main() {
+    CheckRestored();
+    CheckTraceStops();
+    return host_check::Result("stale_watch_test");
+}
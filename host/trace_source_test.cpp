@@ -0,0 +1,240 @@
+// Trace sources: candump lines of both formats (standard, extended and remote frames, lines that have to be
+// skipped), and a FlightRecorder partition image replayed through ReplayBackend into the FrameCache and decoded.
+#include <array>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "FrameCache.hpp"
+#include "HostCheck.hpp"
+#include "HostTrace.hpp"
+#include "ReplayBackend.hpp"
+#include "TraceSource.hpp"
+#include "VehicleState.hpp"
+
+// Temporary file removed again at the end of the test, suffix is kept so HostTrace picks the format by name
+class TempFile {
+  private:
+    char path[64]{};
+
+  public:
+    TempFile(const char *suffix, const void *contents, size_t len) {
+        snprintf(path, sizeof(path), "/tmp/minidash_traceXXXXXX%s", suffix);
+        int fd = mkstemps(path, static_cast<int>(strlen(suffix)));
+        CHECK(fd >= 0);
+        if (fd >= 0) {
+            CHECK_EQ(write(fd, contents, len), static_cast<ssize_t>(len));
+            close(fd);
+        }
+    }
+    ~TempFile() {
+        unlink(path);
+    }
+    TempFile(const TempFile &) = delete;
+    auto operator=(const TempFile &) -> TempFile & = delete;
+
+    [[nodiscard]] auto Path() const -> const char * {
+        return path;
+    }
+};
+
+struct expected_frame_t {
+    int64_t timestamp_us;
+    uint32_t identifier;
+    uint8_t bus;
+    bool extd;
+    bool rtr;
+    uint8_t dlc;
+    std::array<uint8_t, 8> data;
+};
+
+static constexpr const char CANDUMP[] = "this line is not a frame\n"
+                                        "(1436509052.249713) can0 0AA#1122334455667788\n"
+                                        "(1436509052.250000) can0 18FEF100#0102\n"
+                                        "(1436509052.250100) can0 00000123#\n"
+                                        "# comment\n"
+                                        "\n"
+                                        "(1436509052.250200) can0 123#R\n"
+                                        "(1436509052.250300) can0 7DF#R8\n"
+                                        "(1436509052.250400) can0 1A0##1112233\n"
+                                        "(1436509052.25 can0 1A0#11\n"
+                                        " (1436509052.260000)  can1  1D0   [8]  11 22 33 44 55 66 77 88\n"
+                                        "  can1  330   [2]  AB CD\n"
+                                        "  can0  1A0   [4]  remote request\n"
+                                        "  can0  1A0   [9]  11 22 33 44 55 66 77 88 99\n"
+                                        "  can0  1A0   [3]  11 22\n"
+                                        "  can0  [8]  11 22 33 44 55 66 77 88\n"
+                                        "(1436509052.270000) can2 0AA#00\n"
+                                        "(1.5) can0 0AA#\n";
+static constexpr uint32_t CANDUMP_SKIPPED = 7;
+
+static const std::array<expected_frame_t, 9> CANDUMP_FRAMES{{
+    {1436509052249713, 0x0AA, 0, false, false, 8, {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88}},
+    {1436509052250000, 0x18FEF100, 0, true, false, 2, {0x01, 0x02}},
+    {1436509052250100, 0x123, 0, true, false, 0, {}},
+    {1436509052250200, 0x123, 0, false, true, 0, {}},
+    {1436509052250300, 0x7DF, 0, false, true, 8, {}},
+    {1436509052260000, 0x1D0, 1, false, false, 8, {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88}},
+    // Screen format without a timestamp keeps the one before
+    {1436509052260000, 0x330, 1, false, false, 2, {0xAB, 0xCD}},
+    {1436509052260000, 0x1A0, 0, false, true, 4, {}},
+    {1500000, 0x0AA, 0, false, false, 0, {}},
+}};
+
+static auto Matches(const can_frame_t &frame, const expected_frame_t &expected) -> bool {
+    return frame.timestamp_us == expected.timestamp_us && frame.identifier == expected.identifier &&
+           frame.bus == expected.bus && frame.extd == expected.extd && frame.rtr == expected.rtr &&
+           frame.dlc == expected.dlc && memcmp(frame.data, expected.data.data(), 8) == 0;
+}
+
+// The malformed first line and the skipped can2 line (a third interface) do not take a bus number
+static auto CheckCandump() -> void {
+    TempFile file(".log", CANDUMP, sizeof(CANDUMP) - 1);
+    HostTrace trace(file.Path());
+    CHECK(trace.Source() != nullptr);
+    if (!trace.Source()) {
+        return;
+    }
+    auto *candump = static_cast<CandumpSource *>(trace.Source());
+
+    for (int pass = 0; pass < 2; pass++) {
+        can_frame_t frame;
+        size_t count = 0;
+        while (candump->Next(frame)) {
+            if (count < CANDUMP_FRAMES.size() && !Matches(frame, CANDUMP_FRAMES[count])) {
+                fprintf(stderr, "pass %d frame %zu: got %lx bus %u dlc %u at %lld\n", pass, count,
+                        static_cast<unsigned long>(frame.identifier), frame.bus, frame.dlc,
+                        static_cast<long long>(frame.timestamp_us));
+                host_check::Fail(__FILE__, __LINE__, "candump frame matches");
+            }
+            count++;
+        }
+        CHECK_EQ(count, CANDUMP_FRAMES.size());
+        CHECK_EQ(candump->SkippedLines(), CANDUMP_SKIPPED * (pass + 1));
+        CHECK(candump->Rewind());
+    }
+
+    CandumpSource missing("/nonexistent/trace.log");
+    can_frame_t frame;
+    CHECK(!missing.IsOpen());
+    CHECK(!missing.Next(frame));
+    CHECK(!missing.Rewind());
+}
+
+// Frame of the RPM signal: raw value at bit 40, quarter rpm
+static auto RpmFrame(int64_t timestamp_us, uint32_t rpm) -> can_frame_t {
+    can_frame_t frame{};
+    frame.timestamp_us = timestamp_us;
+    frame.identifier = TORQ3;
+    frame.dlc = 8;
+    // rpm = data[6] * 255 / 8 + data[5], the high byte as large as it can be
+    uint32_t high = rpm * 8 / 255;
+    frame.data[6] = static_cast<uint8_t>(high);
+    frame.data[5] = static_cast<uint8_t>(rpm - high * 255 / 8);
+    return frame;
+}
+
+// Frame of the temperature and fuel signals
+static auto EngineFrame(int64_t timestamp_us, int32_t temp_c, uint8_t fuel_raw) -> can_frame_t {
+    can_frame_t frame{};
+    frame.timestamp_us = timestamp_us;
+    frame.identifier = ENGDATA;
+    frame.dlc = 8;
+    frame.data[0] = static_cast<uint8_t>(temp_c + 48);
+    frame.data[3] = fuel_raw;
+    return frame;
+}
+
+// Three blocks of a partition image, the last sector erased. Replayed at full speed every frame reaches the cache
+// in order, stamped with the replay time, and the last values decode.
+static auto CheckFlightLogReplay() -> void {
+    static constexpr uint32_t SECTORS = 4;
+    static constexpr uint32_t RPM_FRAMES = 1500;
+    std::vector<uint8_t> image(SECTORS * flight_log::BLOCK_SIZE, 0xFF);
+    flight_log::BlockEncoder encoder;
+    uint32_t sector = 0;
+    uint32_t engine_frames = 0;
+    uint32_t other_frames = 0;
+    encoder.Begin(image.data(), 100);
+    auto append = [&](const can_frame_t &frame) {
+        if (!encoder.Append(frame)) {
+            encoder.Finish();
+            sector++;
+            encoder.Begin(image.data() + sector * flight_log::BLOCK_SIZE, 100 + sector);
+            CHECK(encoder.Append(frame));
+        }
+    };
+    int64_t now_us = 5000000;
+    for (uint32_t i = 0; i < RPM_FRAMES; i++) {
+        now_us += 1000;
+        append(RpmFrame(now_us, 800 + i * 4));
+        if (i % 10 == 0) {
+            append(EngineFrame(now_us + 300, 60 + static_cast<int32_t>(i / 100), static_cast<uint8_t>(255 - i / 10)));
+            engine_frames++;
+        }
+        if (i % 7 == 0) {
+            // Not in the signal table, an extended frame never reaches the cache
+            can_frame_t frame{};
+            frame.timestamp_us = now_us + 500;
+            frame.identifier = i % 2 ? 0x5F0 : 0x18DAF110;
+            frame.extd = i % 2 == 0;
+            frame.dlc = 1;
+            append(frame);
+            other_frames++;
+        }
+    }
+    encoder.Finish();
+    CHECK_EQ(sector, 2);
+
+    TempFile file(".bin", image.data(), image.size());
+    HostTrace trace(file.Path());
+    CHECK(trace.Source() != nullptr);
+    if (!trace.Source()) {
+        return;
+    }
+
+    FrameCache cache;
+    SignalReader reader(cache);
+    ReplayBackend replay(*trace.Source(), 0, false);
+    uint32_t delivered = 0;
+    int64_t last_stamp = 0;
+    int64_t start = hal::NowUs();
+    while (replay.WaitForFrames(0)) {
+        replay.Ring().Drain([&](const can_frame_t &frame) {
+            CHECK(frame.timestamp_us >= last_stamp && frame.timestamp_us >= start);
+            last_stamp = frame.timestamp_us;
+            cache.Store(frame);
+            delivered++;
+        });
+        reader.Poll();
+    }
+    CHECK(replay.Finished());
+    CHECK_EQ(delivered, RPM_FRAMES + engine_frames + other_frames);
+    CHECK_EQ(replay.GetStats().frames, delivered);
+    CHECK_EQ(static_cast<FlightLogSource *>(trace.Source())->CorruptBlocks(), 0);
+
+    CHECK_EQ(cache.Generation(CanKey(0, TORQ3)), RPM_FRAMES);
+    CHECK_EQ(cache.Generation(CanKey(0, ENGDATA)), engine_frames);
+    CHECK_EQ(cache.Generation(CanKey(0, 0x5F0)), other_frames / 2);
+    CHECK_EQ(cache.Generation(CanKey(0, SPEED)), 0);
+    can_slot_t slot;
+    cache.Read(CanKey(0, TORQ3), slot);
+    CHECK_EQ(slot.dlc, 8);
+    CHECK(slot.rx_time_us >= start && slot.rx_time_us <= last_stamp);
+
+    reader.Poll();
+    const vehicle_state_t &state = reader.State();
+    CHECK_EQ(state.Get(Signal::RPM), 800 + (RPM_FRAMES - 1) * 4);
+    CHECK_EQ(state.Get(Signal::TEMP), 60 + static_cast<int32_t>((RPM_FRAMES - 10) / 100));
+    CHECK_EQ(state.Get(Signal::FUEL), (255 - (RPM_FRAMES - 10) / 10) * 100 / 255);
+    CHECK_EQ(state.Generation(Signal::SPEED), 0);
+}
+
+int main() {
+    CheckCandump();
+    CheckFlightLogReplay();
+    return host_check::Result("trace_source_test");
+}
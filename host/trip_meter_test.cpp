@@ -0,0 +1,145 @@
+// TripMeter on hand-made signal updates: distance integrated across SPEED frames and not across a gap longer than
+// SPEED_STALE_MS, fuel used from falls of FUEL with refuels and a restore in between, and the ODO pin.
+#include <stdint.h>
+#include <stdio.h>
+
+#include "HostCheck.hpp"
+#include "TripMeter.hpp"
+
+// Drives a TripMeter the way TripStore does, one signal update per call
+class MeterFeed {
+  private:
+    vehicle_state_t state{};
+
+  public:
+    TripMeter meter;
+
+    auto Set(Signal signal, int32_t value, int64_t rx_us) -> void {
+        vehicle_state_t previous = state;
+        size_t i = static_cast<size_t>(signal);
+        state.value[i] = value;
+        state.rx_time_us[i] = rx_us;
+        state.generation[i]++;
+        meter.Update(state, previous);
+    }
+};
+
+// Distance of mph held for us, in um
+static constexpr auto DistanceUm(int32_t mph, int64_t us) -> uint64_t {
+    return static_cast<uint64_t>(mph) * UM_PER_S_PER_MPH * static_cast<uint64_t>(us) / 1000000;
+}
+
+static auto CheckSpeed() -> void {
+    MeterFeed feed;
+    static constexpr int64_t PERIOD_US = 20000;
+    int64_t at = 1000000;
+
+    // The first frame only starts the integration
+    feed.Set(Signal::SPEED, 60, at);
+    CHECK_EQ(feed.meter.Totals().odometer_um, 0);
+    CHECK_EQ(feed.meter.LastSpeedUs(), at);
+    for (int i = 0; i < 50; i++) {
+        at += PERIOD_US;
+        feed.Set(Signal::SPEED, 60, at);
+    }
+    CHECK_EQ(feed.meter.Totals().odometer_um, DistanceUm(60, 50 * PERIOD_US));
+    CHECK_EQ(feed.meter.Totals().trip_um, DistanceUm(60, 50 * PERIOD_US));
+
+    // A gap of exactly the deadline still counts at the last speed
+    uint64_t before = feed.meter.Totals().odometer_um;
+    at += SPEED_STALE_MS * 1000LL;
+    feed.Set(Signal::SPEED, 30, at);
+    CHECK_EQ(feed.meter.Totals().odometer_um - before, DistanceUm(60, SPEED_STALE_MS * 1000LL));
+
+    // Ten minutes of silence after 30 mph adds nothing, the next frames integrate from the one after the gap
+    before = feed.meter.Totals().odometer_um;
+    at += 600LL * 1000000;
+    feed.Set(Signal::SPEED, 45, at);
+    CHECK_EQ(feed.meter.Totals().odometer_um, before);
+    CHECK_EQ(feed.meter.LastSpeedUs(), at);
+    at += PERIOD_US;
+    feed.Set(Signal::SPEED, 45, at);
+    CHECK_EQ(feed.meter.Totals().odometer_um - before, DistanceUm(45, PERIOD_US));
+
+    // Stopped and reversing clocks add nothing
+    feed.Set(Signal::SPEED, 0, at + PERIOD_US);
+    before = feed.meter.Totals().odometer_um;
+    feed.Set(Signal::SPEED, 0, at + 2 * PERIOD_US);
+    feed.Set(Signal::SPEED, 50, at + PERIOD_US);
+    CHECK_EQ(feed.meter.Totals().odometer_um, before);
+
+    // Fractions of a um carry over: a million 1 us steps at 1 mph are exactly one second of it
+    MeterFeed slow;
+    slow.Set(Signal::SPEED, 1, 1);
+    for (int64_t us = 2; us <= 1000001; us++) {
+        slow.Set(Signal::SPEED, 1, us);
+    }
+    CHECK_EQ(slow.meter.Totals().odometer_um, UM_PER_S_PER_MPH);
+}
+
+static auto CheckFuel() -> void {
+    static constexpr uint32_t ML_PER_PERCENT = TANK_CAPACITY_ML / 100;
+    MeterFeed feed;
+    int64_t at = 1000000;
+
+    // The first level is the baseline, sloshing above the low mark is not counted twice
+    feed.Set(Signal::FUEL, 60, at += 100000);
+    CHECK_EQ(feed.meter.Totals().fuel_used_ml, 0);
+    feed.Set(Signal::FUEL, 58, at += 100000);
+    feed.Set(Signal::FUEL, 61, at += 100000);
+    feed.Set(Signal::FUEL, 57, at += 100000);
+    CHECK_EQ(feed.meter.Totals().fuel_used_ml, 3 * ML_PER_PERCENT);
+
+    // A rise of more than REFUEL_PERCENT is a refuel: the new level is the baseline
+    feed.Set(Signal::FUEL, 90, at += 100000);
+    feed.Set(Signal::FUEL, 88, at += 100000);
+    CHECK_EQ(feed.meter.Totals().fuel_used_ml, 5 * ML_PER_PERCENT);
+    CHECK_EQ(feed.meter.Totals().trip_fuel_ml, 5 * ML_PER_PERCENT);
+    feed.meter.ResetTrip();
+    CHECK_EQ(feed.meter.Totals().trip_fuel_ml, 0);
+    CHECK_EQ(feed.meter.Totals().trip_um, 0);
+
+    // Refuelled with the dash off: after a restore the first level is a new baseline, so the refuel is neither
+    // counted as fuel used nor does the fall to it from the last stored level count
+    trip_record_t stored = feed.meter.Totals();
+    MeterFeed restarted;
+    restarted.meter.Restore(stored);
+    restarted.Set(Signal::FUEL, 20, 5000000);
+    CHECK_EQ(restarted.meter.Totals().fuel_used_ml, stored.fuel_used_ml);
+    restarted.Set(Signal::FUEL, 19, 5100000);
+    CHECK_EQ(restarted.meter.Totals().fuel_used_ml, stored.fuel_used_ml + ML_PER_PERCENT);
+    CHECK_EQ(restarted.meter.Totals().trip_fuel_ml, ML_PER_PERCENT);
+}
+
+static auto CheckOdometerPin() -> void {
+    MeterFeed feed;
+    trip_record_t stored{};
+    stored.odometer_um = 12345 * UM_PER_KM + 500000000;
+    feed.meter.Restore(stored);
+
+    // Inside the reported kilometre the integrated value stands
+    feed.Set(Signal::ODO, 12345, 1000000);
+    CHECK_EQ(feed.meter.Totals().odometer_um, 12345 * UM_PER_KM + 500000000);
+    // Behind the car: raised to the start of its kilometre
+    feed.Set(Signal::ODO, 12350, 2000000);
+    CHECK_EQ(feed.meter.Totals().odometer_um, 12350 * UM_PER_KM);
+    // Ahead of it: held just short of the next one
+    feed.Set(Signal::SPEED, 100, 3000000);
+    feed.Set(Signal::SPEED, 100, 3000000 + SPEED_STALE_MS * 1000LL);
+    CHECK(feed.meter.Totals().odometer_um > 12350 * UM_PER_KM);
+    feed.Set(Signal::ODO, 12349, 4000000);
+    CHECK_EQ(feed.meter.Totals().odometer_um, 12350 * UM_PER_KM - 1);
+    // No reading yet is not kilometre zero
+    feed.Set(Signal::ODO, 0, 5000000);
+    CHECK_EQ(feed.meter.Totals().odometer_um, 12350 * UM_PER_KM - 1);
+    // The trip distance is not pinned
+    CHECK_EQ(feed.meter.Totals().trip_um, DistanceUm(100, SPEED_STALE_MS * 1000LL));
+}
+
+int main() {
+    CheckSpeed();
+    CheckFuel();
+    CheckOdometerPin();
+    printf("trip meter: speed gap, refuel and odometer pin checked\n");
+    return host_check::Result("trip_meter_test");
+}
@@ -0,0 +1,156 @@
+#pragma once
+#ifndef ASSETBUNDLE_HPP
+#define ASSETBUNDLE_HPP
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Crc32.hpp"
+
+// Packed asset bundle, written by host/asset_pack and read in place from the assets partition:
+//   asset_bundle_header_t | asset_entry_t x count | data, each asset at an ASSET_ALIGN multiple from the start
+// LVGL reads unpacked images straight from the mapped partition, RLE ones are decoded once.
+
+static constexpr uint32_t ASSET_BUNDLE_MAGIC = 0x3141444D; // "MDA1"
+static constexpr uint16_t ASSET_BUNDLE_VERSION = 1;
+static constexpr size_t ASSET_NAME_SIZE = 20;
+static constexpr uint32_t ASSET_ALIGN = 64;
+
+enum class AssetKind : uint8_t { BLOB, IMAGE, FONT, SOUND };
+enum class AssetCodec : uint8_t { RAW, RLE };
+
+struct asset_bundle_header_t {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t size;      // header to the end of the last asset
+    uint32_t index_crc; // CRC-32 of the entries
+};
+static_assert(sizeof(asset_bundle_header_t) == 16, "asset_bundle_header_t is stored as is");
+
+struct asset_entry_t {
+    std::array<char, ASSET_NAME_SIZE> name; // NUL padded
+    uint32_t offset;                        // from the start of the bundle
+    uint32_t size;                          // stored bytes
+    uint32_t raw_size;                      // bytes after decoding, size for RAW
+    uint32_t crc;                           // CRC-32 of the stored bytes
+    AssetKind kind;
+    AssetCodec codec;
+    uint8_t color_format; // images, lv_color_format_t
+    uint8_t unit;         // RLE element size in bytes, the pixel size for images
+    uint16_t width;
+    uint16_t height;
+    uint32_t stride;
+};
+static_assert(sizeof(asset_entry_t) == 48, "asset_entry_t is stored as is");
+
+// Run-length code over unit-byte elements: a control byte c then either (c & 0x7F) + 1 copies of one element
+// (c & 0x80) or c + 1 literal elements. Returns false if src does not decode to exactly dst_size bytes.
+inline auto RleDecode(const uint8_t *src, size_t src_size, uint8_t unit, uint8_t *dst, size_t dst_size) -> bool {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < src_size) {
+        uint8_t control = src[in++];
+        size_t count = (control & 0x7F) + 1U;
+        size_t bytes = count * unit;
+        if (out + bytes > dst_size) {
+            return false;
+        }
+        if (control & 0x80) {
+            if (in + unit > src_size) {
+                return false;
+            }
+            for (size_t i = 0; i < count; i++) {
+                memcpy(dst + out + i * unit, src + in, unit);
+            }
+            in += unit;
+        } else {
+            if (in + bytes > src_size) {
+                return false;
+            }
+            memcpy(dst + out, src + in, bytes);
+            in += bytes;
+        }
+        out += bytes;
+    }
+    return out == dst_size;
+}
+
+// A bundle in memory, mapped or loaded, checked once on Attach. Lookups are a scan of the index, bundles hold tens
+// of assets and are looked up at setup.
+class AssetBundle {
+  private:
+    const uint8_t *base = nullptr;
+    const asset_bundle_header_t *header = nullptr;
+    const asset_entry_t *entries = nullptr;
+
+  public:
+    // Checks the header, the index CRC and that every asset lies inside size. Not the asset CRCs, see Verify.
+    auto Attach(const void *data, size_t size) -> bool {
+        base = nullptr;
+        if (size < sizeof(asset_bundle_header_t)) {
+            return false;
+        }
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        const auto *head = reinterpret_cast<const asset_bundle_header_t *>(bytes);
+        size_t index_size = head->count * sizeof(asset_entry_t);
+        if (head->magic != ASSET_BUNDLE_MAGIC || head->version != ASSET_BUNDLE_VERSION || head->size > size ||
+            sizeof(asset_bundle_header_t) + index_size > head->size) {
+            return false;
+        }
+        const auto *index = reinterpret_cast<const asset_entry_t *>(bytes + sizeof(asset_bundle_header_t));
+        if (Crc32(index, index_size) != head->index_crc) {
+            return false;
+        }
+        for (size_t i = 0; i < head->count; i++) {
+            if (index[i].offset % ASSET_ALIGN || index[i].offset > head->size ||
+                index[i].size > head->size - index[i].offset || index[i].name.back() != '\0') {
+                return false;
+            }
+        }
+        base = bytes;
+        header = head;
+        entries = index;
+        return true;
+    }
+
+    [[nodiscard]] auto Attached() const -> bool {
+        return base != nullptr;
+    }
+    [[nodiscard]] auto Size() const -> uint32_t {
+        return base ? header->size : 0;
+    }
+    // Identifies the bundle contents, the index covers every asset's CRC
+    [[nodiscard]] auto Id() const -> uint32_t {
+        return base ? header->index_crc : 0;
+    }
+    [[nodiscard]] auto Count() const -> size_t {
+        return base ? header->count : 0;
+    }
+    [[nodiscard]] auto Entry(size_t i) const -> const asset_entry_t & {
+        return entries[i];
+    }
+
+    [[nodiscard]] auto Find(const char *name) const -> const asset_entry_t * {
+        for (size_t i = 0; i < Count(); i++) {
+            if (strncmp(entries[i].name.data(), name, ASSET_NAME_SIZE) == 0) {
+                return &entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Stored bytes of an asset, in place
+    [[nodiscard]] auto Data(const asset_entry_t &entry) const -> const uint8_t * {
+        return base + entry.offset;
+    }
+
+    // Reads every byte of the asset, for tools and after a flash
+    [[nodiscard]] auto Verify(const asset_entry_t &entry) const -> bool {
+        return Crc32(Data(entry), entry.size) == entry.crc;
+    }
+};
+
+#endif
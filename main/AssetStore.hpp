@@ -0,0 +1,136 @@
+#pragma once
+#ifndef ASSETSTORE_HPP
+#define ASSETSTORE_HPP
+
+#include <array>
+#include <stdint.h>
+
+#include "bsp_board_extra.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "lvgl.h"
+
+#include "AssetBundle.hpp"
+
+// The asset bundle in the assets partition, mapped once at boot. Unpacked images are handed to LVGL pointing into
+// the mapping, RLE packed ones are decoded into PSRAM the first time they are asked for and kept. A new skin is a new
+// bundle flashed to the partition, the firmware stays as it is. Call from the UI task.
+class AssetStore {
+  private:
+    static constexpr size_t MAX_IMAGES = 16;
+
+    struct image_slot_t {
+        const asset_entry_t *entry;
+        lv_image_dsc_t image;
+    };
+
+    esp_partition_mmap_handle_t map{};
+    AssetBundle bundle;
+    std::array<image_slot_t, MAX_IMAGES> images{};
+    size_t image_count = 0;
+    size_t decoded_bytes = 0;
+
+    auto Lookup(const char *name, AssetKind kind) const -> const asset_entry_t * {
+        const asset_entry_t *entry = bundle.Find(name);
+        if (!entry || entry->kind != kind) {
+            ESP_LOGE("ASSETS", "No asset %s of kind %u", name, static_cast<uint8_t>(kind));
+            return nullptr;
+        }
+        return entry;
+    }
+
+  public:
+    AssetStore() = default;
+    AssetStore(const AssetStore &) = delete;
+    auto operator=(const AssetStore &) -> AssetStore & = delete;
+
+    auto Open(const char *label) -> bool {
+        const esp_partition_t *partition =
+            esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+        if (!partition) {
+            ESP_LOGE("ASSETS", "No %s partition", label);
+            return false;
+        }
+        asset_bundle_header_t header;
+        if (esp_partition_read(partition, 0, &header, sizeof(header)) != ESP_OK || header.magic != ASSET_BUNDLE_MAGIC ||
+            header.size > partition->size) {
+            ESP_LOGE("ASSETS", "No asset bundle in %s, flash one made with asset_pack", label);
+            return false;
+        }
+        const void *data = nullptr;
+        esp_err_t err = esp_partition_mmap(partition, 0, header.size, ESP_PARTITION_MMAP_DATA, &data, &map);
+        if (err != ESP_OK) {
+            ESP_LOGE("ASSETS", "Failed to map %s ERR: %s", label, esp_err_to_name(err));
+            return false;
+        }
+        if (!bundle.Attach(data, header.size)) {
+            ESP_LOGE("ASSETS", "Asset bundle in %s is damaged or of another version", label);
+            esp_partition_munmap(map);
+            return false;
+        }
+        ESP_LOGI("ASSETS", "%zu assets, %lu bytes mapped, bundle %08lx", bundle.Count(), bundle.Size(), bundle.Id());
+        return true;
+    }
+
+    // Changes whenever any asset does, 0 without a bundle
+    [[nodiscard]] auto Id() const -> uint32_t {
+        return bundle.Id();
+    }
+
+    // nullptr when the image is missing or does not decode
+    auto Image(const char *name) -> const lv_image_dsc_t * {
+        for (size_t i = 0; i < image_count; i++) {
+            if (strncmp(images[i].entry->name.data(), name, ASSET_NAME_SIZE) == 0) {
+                return &images[i].image;
+            }
+        }
+        const asset_entry_t *entry = Lookup(name, AssetKind::IMAGE);
+        if (!entry || image_count == MAX_IMAGES) {
+            return nullptr;
+        }
+        const uint8_t *pixels = bundle.Data(*entry);
+        if (entry->codec == AssetCodec::RLE) {
+            auto *decoded = static_cast<uint8_t *>(heap_caps_malloc(entry->raw_size, MALLOC_CAP_SPIRAM));
+            if (!decoded || !RleDecode(pixels, entry->size, entry->unit, decoded, entry->raw_size)) {
+                ESP_LOGE("ASSETS", "Failed to decode %s", name);
+                heap_caps_free(decoded);
+                return nullptr;
+            }
+            decoded_bytes += entry->raw_size;
+            pixels = decoded;
+        }
+        image_slot_t &slot = images[image_count++];
+        slot.entry = entry;
+        slot.image.header.magic = LV_IMAGE_HEADER_MAGIC;
+        slot.image.header.cf = entry->color_format;
+        slot.image.header.w = entry->width;
+        slot.image.header.h = entry->height;
+        slot.image.header.stride = entry->stride;
+        slot.image.data_size = entry->raw_size;
+        slot.image.data = pixels;
+        return &slot.image;
+    }
+
+    // An LVGL binary font (lv_font_conv --format bin) read from the mapping, free with lv_binfont_destroy
+    auto Font(const char *name) -> lv_font_t * {
+        const asset_entry_t *entry = Lookup(name, AssetKind::FONT);
+        if (!entry) {
+            return nullptr;
+        }
+        return lv_binfont_create_from_buffer(const_cast<uint8_t *>(bundle.Data(*entry)), entry->size);
+    }
+
+    // Plays a sound asset through the BSP audio player, read from the mapping instead of a file
+    auto PlaySound(const char *name) -> bool {
+        const asset_entry_t *entry = Lookup(name, AssetKind::SOUND);
+        return entry && bsp_extra_player_play_buffer(bundle.Data(*entry), entry->size) == ESP_OK;
+    }
+
+    // PSRAM taken by decoded images
+    [[nodiscard]] auto DecodedBytes() const -> size_t {
+        return decoded_bytes;
+    }
+};
+
+#endif
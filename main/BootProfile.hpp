@@ -0,0 +1,83 @@
+#pragma once
+#ifndef BOOTPROFILE_HPP
+#define BOOTPROFILE_HPP
+
+#include <array>
+#include <stdint.h>
+
+#include "esp_log.h"
+
+#include "Hal.hpp"
+
+enum class BootPhase : uint8_t {
+    APP_MAIN,
+    SPLASH_SHOWN, // pre-rendered background on the panel, before LVGL runs
+    LVGL_UP,
+    FIRST_LVGL_FRAME,
+    SCENE_BUILT,
+    FIRST_FRAME, // first meaningful frame: the whole dash with every gauge drawn
+    FIRST_VALID, // every gauge shows a live or restored value
+    ALL_LIVE,    // every gauge shows a received value
+    COUNT
+};
+static constexpr size_t BOOT_PHASE_COUNT = static_cast<size_t>(BootPhase::COUNT);
+static constexpr std::array<const char *, BOOT_PHASE_COUNT> BOOT_PHASE_NAMES{
+    "app_main", "splash shown", "lvgl up", "first lvgl frame", "scene built", "first meaningful frame",
+    "first valid frame", "all gauges live"};
+
+// Measured from app start like every phase, the bootloader and image load are not included
+static constexpr int64_t FIRST_FRAME_TARGET_US = 300000;
+
+// Time from app start to each boot phase, the first time it is reached. Phases are marked by the task that reaches
+// them, one writer per phase, and read once the first meaningful frame is out.
+class BootProfile {
+  private:
+    int64_t start_us;
+    std::array<int64_t, BOOT_PHASE_COUNT> reached_us{};
+
+  public:
+    // start_us: NowUs() when the app started, 0 on the device where esp_timer starts with the app
+    explicit BootProfile(int64_t start_us) : start_us(start_us) {}
+
+    // Returns true the first time phase is reached
+    auto Mark(BootPhase phase) -> bool {
+        int64_t &at = reached_us[static_cast<size_t>(phase)];
+        if (at) {
+            return false;
+        }
+        at = hal::NowUs() - start_us;
+        // 0 means not reached
+        at = at ? at : 1;
+        return true;
+    }
+
+    [[nodiscard]] auto Reached(BootPhase phase) const -> bool {
+        return reached_us[static_cast<size_t>(phase)] != 0;
+    }
+    // Microseconds from app start, 0 if not reached
+    [[nodiscard]] auto At(BootPhase phase) const -> int64_t {
+        return reached_us[static_cast<size_t>(phase)];
+    }
+
+    // First pixel is the splash when there was one, otherwise the first LVGL frame
+    [[nodiscard]] auto FirstPixelUs() const -> int64_t {
+        return Reached(BootPhase::SPLASH_SHOWN) ? At(BootPhase::SPLASH_SHOWN) : At(BootPhase::FIRST_LVGL_FRAME);
+    }
+
+    // Phases reached so far, in ms from app start
+    auto LogSummary(const char *tag) const -> void {
+        for (size_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+            if (reached_us[i]) {
+                ESP_LOGI(tag, "%-24s %6lld ms after app start", BOOT_PHASE_NAMES[i], reached_us[i] / 1000);
+            }
+        }
+        int64_t first_frame = At(BootPhase::FIRST_FRAME);
+        if (first_frame) {
+            ESP_LOGI(tag, "from app start: first pixel %lld ms, first meaningful frame %lld ms, target %lld ms%s",
+                     FirstPixelUs() / 1000, first_frame / 1000, FIRST_FRAME_TARGET_US / 1000,
+                     first_frame > FIRST_FRAME_TARGET_US ? ", MISSED" : "");
+        }
+    }
+};
+
+#endif
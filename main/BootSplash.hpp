@@ -0,0 +1,129 @@
+#pragma once
+#ifndef BOOTSPLASH_HPP
+#define BOOTSPLASH_HPP
+
+#include <array>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_app_desc.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "lvgl.h"
+
+#include "Hal.hpp"
+
+// Start of the splash partition, the pixels follow from PIXELS_OFFSET
+struct splash_header_t {
+    uint32_t magic;
+    uint16_t width;
+    uint16_t height;
+    uint32_t stride;
+    uint32_t data_size;
+    uint32_t skin;                  // AssetStore::Id() of the assets it was rendered from
+    std::array<uint8_t, 8> app_sha; // start of the ELF SHA-256 of the firmware that rendered it
+};
+
+// The pre-rendered dash background (dash image plus scales, RGB565, what MainDisplay::CacheBackground renders) kept
+// in the splash partition, so the next boot can put it on the panel before LVGL is up and use it as the LVGL
+// background straight from flash through a partition mmap, without creating the scales or rendering the cache.
+// It is tied to the firmware build and the asset bundle that rendered it, a new build or skin renders and saves it
+// once on its first boot.
+// Redraws then read the background through the flash cache instead of PSRAM.
+class BootSplash {
+  private:
+    static constexpr uint32_t MAGIC = 0x53504C31; // "SPL1"
+    static constexpr size_t PIXELS_OFFSET = 4096;
+    static constexpr size_t SECTOR_SIZE = 4096;
+
+    const char *label;
+    const esp_partition_t *partition = nullptr;
+    uint32_t skin = 0;
+    esp_partition_mmap_handle_t map{};
+    lv_image_dsc_t image{};
+
+    [[nodiscard]] auto Expected(uint32_t width, uint32_t height, uint32_t stride) const -> splash_header_t {
+        splash_header_t header{};
+        header.magic = MAGIC;
+        header.width = static_cast<uint16_t>(width);
+        header.height = static_cast<uint16_t>(height);
+        header.stride = stride;
+        header.data_size = stride * height;
+        header.skin = skin;
+        memcpy(header.app_sha.data(), esp_app_get_description()->app_elf_sha256, header.app_sha.size());
+        return header;
+    }
+
+  public:
+    explicit BootSplash(const char *partition_label) : label(partition_label) {}
+
+    BootSplash(const BootSplash &) = delete;
+    auto operator=(const BootSplash &) -> BootSplash & = delete;
+
+    // The saved background as an LVGL image mapped from flash, nullptr when there is none for this build and skin
+    auto Open(uint32_t width, uint32_t height, uint32_t skin_id) -> const lv_image_dsc_t * {
+        skin = skin_id;
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+        if (!partition) {
+            ESP_LOGE("SPLASH", "No %s partition, the dash is built from the image at every boot", label);
+            return nullptr;
+        }
+        splash_header_t header;
+        splash_header_t expected = Expected(width, height, width * 2);
+        if (esp_partition_read(partition, 0, &header, sizeof(header)) != ESP_OK ||
+            memcmp(&header, &expected, sizeof(header)) != 0) {
+            ESP_LOGI("SPLASH", "No splash for this build and skin, rendering it");
+            return nullptr;
+        }
+        const void *pixels = nullptr;
+        esp_err_t err = esp_partition_mmap(partition, PIXELS_OFFSET, header.data_size, ESP_PARTITION_MMAP_DATA,
+                                           &pixels, &map);
+        if (err != ESP_OK) {
+            ESP_LOGE("SPLASH", "Failed to map the splash ERR: %s", esp_err_to_name(err));
+            return nullptr;
+        }
+        image.header.magic = LV_IMAGE_HEADER_MAGIC;
+        image.header.cf = LV_COLOR_FORMAT_RGB565;
+        image.header.w = header.width;
+        image.header.h = header.height;
+        image.header.stride = header.stride;
+        image.data_size = header.data_size;
+        image.data = static_cast<const uint8_t *>(pixels);
+        return &image;
+    }
+
+    // Writes a rendered background, the header last so a cut leaves no splash rather than a torn one. Erasing and
+    // writing 1 MB takes seconds, call it from a task that can wait.
+    auto Save(const lv_draw_buf_t *background) -> bool {
+        if (!partition || !background || background->header.cf != LV_COLOR_FORMAT_RGB565) {
+            return false;
+        }
+        // The panel takes the splash as one packed bitmap
+        if (background->header.stride != background->header.w * 2) {
+            ESP_LOGE("SPLASH", "Background rows are padded (stride %lu), not saving it", background->header.stride);
+            return false;
+        }
+        splash_header_t header = Expected(background->header.w, background->header.h, background->header.stride);
+        size_t end = PIXELS_OFFSET + header.data_size;
+        if (end > partition->size) {
+            ESP_LOGE("SPLASH", "Background of %lu bytes does not fit in %s", header.data_size, label);
+            return false;
+        }
+        int64_t start = hal::NowUs();
+        esp_err_t err = esp_partition_erase_range(partition, 0, (end + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE);
+        if (err == ESP_OK) {
+            err = esp_partition_write(partition, PIXELS_OFFSET, background->data, header.data_size);
+        }
+        if (err == ESP_OK) {
+            err = esp_partition_write(partition, 0, &header, sizeof(header));
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE("SPLASH", "Failed to save the splash ERR: %s", esp_err_to_name(err));
+            return false;
+        }
+        ESP_LOGI("SPLASH", "Saved %lu bytes in %lld ms", header.data_size, (hal::NowUs() - start) / 1000);
+        return true;
+    }
+};
+
+#endif
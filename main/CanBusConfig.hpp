@@ -0,0 +1,28 @@
+#pragma once
+#ifndef CANBUSCONFIG_HPP
+#define CANBUSCONFIG_HPP
+
+#include <array>
+#include <stdint.h>
+
+// One receive bus, the index in CAN_RX_BUSES is the bus number frames and signals are tagged with.
+// Controller 1 is the gateway transmit side, so receive buses use controllers 0 and 2.
+struct can_bus_config_t {
+    uint8_t controller;
+    int tx_pin;
+    int rx_pin;
+    uint32_t bitrate;
+};
+
+// clang-format off
+static constexpr std::array CAN_RX_BUSES{
+    //               controller  tx  rx  bitrate
+    can_bus_config_t{0,          21, 22, 500000}, // powertrain
+    // can_bus_config_t{2,       TX, RX, 100000}, // body, add pins to enable a second bus
+};
+// clang-format on
+
+static constexpr uint8_t CAN_BUS_COUNT = CAN_RX_BUSES.size();
+static_assert(CAN_BUS_COUNT >= 1 && CAN_BUS_COUNT <= 2, "receive buses use controllers 0 and 2");
+
+#endif
@@ -2,148 +2,193 @@
 #ifndef CANCONNECT_HPP
 #define CANCONNECT_HPP
 
+#include <array>
+#include <memory>
+
 #include "driver/twai.h"
 #include "esp_log.h"
 
-#define TORQ3 0x0AA
-#define SPEED 0x1A0
-#define ENGDATA 0x1D0
-#define FUELMLS 0x330
+#include "CanBusConfig.hpp"
+#include "CanFrame.hpp"
+#include "CanReceiver.hpp"
+#include "CanRxBackend.hpp"
+#include "TwaiBus.hpp"
 
-#define RX0 GPIO_NUM_22
-#define TX0 GPIO_NUM_21
 #define RX1 GPIO_NUM_27
 #define TX1 GPIO_NUM_47
 
-class CanConnect {
+// CanReceiver on the TWAI controllers, plus controller 1 as the transmit side
+class CanConnect : public CanReceiver {
   private:
     twai_handle_t h0{};
     twai_handle_t h1{};
     twai_message_t can_frame{};
-    static constexpr TickType_t timeout_in_ms = 3000;
+    can_frame_t rx_frame{};
+    can_controller_health_t h0_health{}; // refreshed with every driver batch
+    TwaiController rx_controller{h0};
+    TwaiController tx_controller{h1};
+    CanRecovery rx_recovery{rx_controller, "bus 0"};
+    CanRecovery tx_recovery{tx_controller, "tx"};
+    std::array<std::unique_ptr<TwaiQueueBackend>, CAN_BUS_COUNT> owned_backends{};
+    static constexpr uint32_t rx_queue_len = 64; // ~10 ms of a saturated 500 kbit/s bus
+    static constexpr uint32_t tx_queue_len = 16;
+    static constexpr UBaseType_t pump_priority = 6;
+    static constexpr uint32_t recovery_poll_ms = 20;
+
+    // Single bus without backends: controller of bus 0 is drained directly, no pump task or ring in between
+    auto TwaiRxConfig() -> void {
+        const can_bus_config_t &bus = CAN_RX_BUSES[0];
+        twai_general_config_t twai0 = TWAI_GENERAL_CONFIG_DEFAULT(
+            static_cast<gpio_num_t>(bus.tx_pin), static_cast<gpio_num_t>(bus.rx_pin), TWAI_MODE_NORMAL);
+        twai0.controller_id = bus.controller;
+        twai0.rx_queue_len = rx_queue_len;
+        twai0.alerts_enabled = TWAI_ALERT_RX_DATA | TWAI_RECOVERY_ALERTS;
+        twai_timing_config_t twai_timing = TwaiTiming(bus.bitrate);
+        twai_filter_config_t rx_twai_filter =
+            gateway_mode ? twai_filter_config_t TWAI_FILTER_CONFIG_ACCEPT_ALL() : TwaiFilter(rx_filters[0]);
+
+        if (esp_err_t err = twai_driver_install_v2(&twai0, &twai_timing, &rx_twai_filter, &h0); err != ESP_OK) {
+            ESP_LOGE("CAN FATAL", "Failed to install twai driver for handle 0 (receive CAN) ERR: %s", esp_err_to_name(err));
+        }
+        if (esp_err_t err = twai_start_v2(h0); err != ESP_OK) {
+            ESP_LOGE("CAN FATAL", "Failed to start twai driver for handle 0 (receive CAN) ERR: %s", esp_err_to_name(err));
+        }
+    }
 
-    auto TwaiConfig() -> void {
-        twai_general_config_t twai0 = TWAI_GENERAL_CONFIG_DEFAULT(TX0, RX0, TWAI_MODE_NORMAL);
-        twai0.controller_id = 0;
+    auto TwaiTxConfig() -> void {
         twai_general_config_t twai1 = TWAI_GENERAL_CONFIG_DEFAULT(TX1, RX1, TWAI_MODE_NORMAL);
         twai1.controller_id = 1;
+        twai1.tx_queue_len = tx_queue_len;
+        twai1.alerts_enabled = TWAI_ALERT_BUS_OFF | TWAI_ALERT_BUS_RECOVERED | TWAI_ALERT_ERR_PASS |
+                               TWAI_ALERT_ABOVE_ERR_WARN | TWAI_ALERT_ERR_ACTIVE | TWAI_ALERT_ARB_LOST |
+                               TWAI_ALERT_BUS_ERROR;
 
         twai_timing_config_t twai_timing = TWAI_TIMING_CONFIG_500KBITS();
         twai_filter_config_t twai_filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
 
-        if (esp_err_t err = twai_driver_install_v2(&twai0, &twai_timing, &twai_filter, &h0) != ESP_OK) {
-            ESP_LOGE("CAN FATAL", "Failed to install twai driver for handle 0 (receive CAN) ERR: %s", esp_err_to_name(err));
-        }
-        if (esp_err_t err = twai_start_v2(h0) != ESP_OK) {
-            ESP_LOGE("CAN FATAL", "Failed to start twai driver for handle 0 (receive CAN) ERR: %s", esp_err_to_name(err));
-        };
-
-        if (esp_err_t err = twai_driver_install_v2(&twai1, &twai_timing, &twai_filter, &h1) != ESP_OK) {
+        if (esp_err_t err = twai_driver_install_v2(&twai1, &twai_timing, &twai_filter, &h1); err != ESP_OK) {
             ESP_LOGE("CAN FATAL", "Failed to install twai driver for handle 1 (transmit CAN) ERR: %s", esp_err_to_name(err));
         }
-        if (esp_err_t err = twai_start_v2(h1) != ESP_OK) {
+        if (esp_err_t err = twai_start_v2(h1); err != ESP_OK) {
             ESP_LOGE("CAN FATAL", "Failed to start twai driver for handle 1 (transmit CAN) ERR: %s", esp_err_to_name(err));
-        };
-    }
-
-    auto TransmitFrame(const twai_message_t &can_frame) -> void {
-        if (esp_err_t err = twai_transmit_v2(h1, &can_frame, pdMS_TO_TICKS(timeout_in_ms)) != ESP_OK) {
-            ESP_LOGE("CAN FATAL", "Not transmitting any CAN Data, %s", esp_err_to_name(err));
         }
     }
 
-  public:
-    CanConnect() {
-        TwaiConfig();
-    }
-    auto ReceiveFrame() -> bool {
-        if (esp_err_t err = twai_receive_v2(h0, &can_frame, pdMS_TO_TICKS(timeout_in_ms)) != ESP_OK) {
-            ESP_LOGE("CAN FATAL", "Not receiving any CAN Data, %s", esp_err_to_name(err));
-            return false;
+    // Transmit side alerts, a bus-off there stops the gateway but not the dash, so they are picked up between batches
+    auto PollTxAlerts() -> void {
+        if (!h1) {
+            return;
         }
-        return true;
+        uint32_t alerts = 0;
+        if (twai_read_alerts_v2(h1, &alerts, 0) == ESP_OK) {
+            tx_recovery.HandleAlerts(TwaiAlerts(alerts), esp_timer_get_time());
+        }
+        tx_recovery.Poll(esp_timer_get_time());
     }
 
-    auto HandleRPM(bool transmit = false) -> uint16_t {
-        if (can_frame.identifier != TORQ3) {
+    template <typename Handler>
+    auto ReceiveDriverBatch(Handler &handler) -> uint32_t {
+        // Bus-off and recovery come in as alerts, the wait only runs into its timeout on a silent bus
+        uint32_t alerts = 0;
+        uint32_t wait_ms = rx_recovery.Recovering() ? recovery_poll_ms : timeout_in_ms;
+        bool alerted = twai_read_alerts_v2(h0, &alerts, pdMS_TO_TICKS(wait_ms)) == ESP_OK;
+        rx_recovery.HandleAlerts(alerted ? TwaiAlerts(alerts) : 0, esp_timer_get_time());
+        rx_recovery.Poll(esp_timer_get_time());
+        if (!alerted) {
+            if (!rx_recovery.Recovering()) {
+                ESP_LOGE("CAN FATAL", "Not receiving any CAN Data, no RX alert in %lu ms", timeout_in_ms);
+            }
             return 0;
         }
-        uint16_t rpm_value = 0;
-        uint8_t modifier = 255;
-        uint8_t scale = 4;
-        uint8_t increment_value = can_frame.data[6];
-        uint16_t raw_value = increment_value * modifier;
-        uint8_t active_raw_value = can_frame.data[5];
-        rpm_value = ((raw_value / 2) / scale) + active_raw_value;
-
-        if (transmit) {
-            TransmitFrame(can_frame);
-        }
-        return rpm_value;
-    }
-    auto HandleSpeed(bool transmit = false) -> uint8_t {
-        if (can_frame.identifier != SPEED) {
-            return 0;
+        if (alerts & TWAI_ALERT_RX_QUEUE_FULL) {
+            rx_stats.queue_full_events++;
         }
-        uint8_t speed_value = 0;
-        uint8_t modifier = 255;
-        uint8_t increment_value = can_frame.data[1] & 0x0F; // extracts only the right most hex digit, AKA first 4 bits
-        uint16_t raw_value = increment_value * modifier;
-        uint8_t active_raw_value = can_frame.data[0];
-
-        uint32_t scaled = (raw_value * 621 + 5000) / 1000;
-        speed_value = scaled + active_raw_value;
 
-        if (transmit) {
-            TransmitFrame(can_frame);
+        twai_status_info_t status{};
+        if (twai_get_status_info_v2(h0, &status) == ESP_OK) {
+            h0_health = TwaiHealth(status);
+            if (status.msgs_to_rx > rx_stats.queue_high_water) {
+                rx_stats.queue_high_water = status.msgs_to_rx;
+            }
+            rx_stats.rx_missed = status.rx_missed_count;
+            rx_stats.rx_overrun = status.rx_overrun_count;
         }
-        return speed_value;
-    }
 
-    auto HandleFuel(bool transmit = false) -> uint8_t {
-        if (can_frame.identifier != ENGDATA) {
-            return 0;
+        uint32_t count = 0;
+        while (twai_receive_v2(h0, &can_frame, 0) == ESP_OK) {
+            TwaiToFrame(can_frame, 0, rx_frame);
+            id_stats->Record(rx_frame);
+            if (!Accepts(rx_frame)) {
+                rx_stats.sw_rejected++;
+                continue;
+            }
+            handler(static_cast<const can_frame_t &>(rx_frame));
+            count++;
         }
+        return count;
+    }
 
-        if (transmit) {
-            TransmitFrame(can_frame);
-        }
-        return (can_frame.data[3] * 100) / 255; // full byte, turned into percentage for fuel
+  public:
+    // Receives every bus in CAN_RX_BUSES on the TWAI driver. gateway_mode opens the RX filters so every frame
+    // reaches the handler, see CanGateway.
+    explicit CanConnect(bool gateway_mode = false) : CanReceiver(gateway_mode) {
+        LogRxFilters();
+        if (CAN_BUS_COUNT == 1) {
+            TwaiRxConfig();
+        } else {
+            // The receive task runs on core 0, the pumps sit just above it so they never starve
+            can_rx_backends_t backends{};
+            for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++) {
+                owned_backends[bus] =
+                    std::make_unique<TwaiQueueBackend>(bus, CAN_RX_BUSES[bus], gateway_mode, pump_priority, 0);
+                backends[bus] = owned_backends[bus].get();
+            }
+            merger = std::make_unique<CanMerger>(backends);
+            rx_backends = backends;
+        }
+        TwaiTxConfig();
+    }
+    // Receives through backends, one per bus, instead of the TWAI driver queue
+    explicit CanConnect(const can_rx_backends_t &backends, bool gateway_mode = false)
+        : CanReceiver(backends, gateway_mode) {
+        TwaiTxConfig();
     }
 
-    auto HandleTemp(bool transmit = false) -> uint8_t {
-        if (can_frame.identifier != ENGDATA) {
-            return 0;
-        }
-        if (transmit) {
-            TransmitFrame(can_frame);
-        }
-        // coolant temp is held as one full byte (0-255), so should return the full byte and be fine
-        return can_frame.data[0] - 48; // -48 for bias/offset
+    // See CanReceiver::ReceiveBatch, without backends the driver queue of bus 0 is drained directly
+    template <typename Handler>
+    auto ReceiveBatch(Handler &&handler) -> uint32_t {
+        uint32_t count = CountBatch(merger ? ReceiveBackendBatch(handler) : ReceiveDriverBatch(handler));
+        PollTxAlerts();
+        return count;
     }
 
-    auto HandleODO(bool transmit = false) -> uint32_t {
-        if (can_frame.identifier != FUELMLS) {
-            return 0;
+    // See CanReceiver::ControllerHealth, without backends bus 0 reports the status read with the last batch
+    auto ControllerHealth(uint8_t bus, can_controller_health_t &health) -> bool {
+        if (merger) {
+            return CanReceiver::ControllerHealth(bus, health);
         }
-        uint32_t odometer_value = 0;
-
-        if (transmit) {
-            TransmitFrame(can_frame);
+        if (bus != 0) {
+            return false;
         }
-        return odometer_value;
+        health = h0_health;
+        return true;
     }
 
-    auto HandleFUELRNG(bool transmit = false) -> uint16_t {
-        if (can_frame.identifier != FUELMLS) {
-            return 0;
+    // Bus-off recovery and alert history of the receive controller of bus, see CanReceiver::Recovery
+    auto Recovery(uint8_t bus) -> CanRecovery * {
+        if (merger) {
+            return CanReceiver::Recovery(bus);
         }
-        uint16_t fuelRange_value = 0;
+        return bus == 0 ? &rx_recovery : nullptr;
+    }
+    auto TxRecovery() -> CanRecovery & {
+        return tx_recovery;
+    }
 
-        if (transmit) {
-            TransmitFrame(can_frame);
-        }
-        return fuelRange_value;
+    // Queues frame on handle 1, waits at most timeout_ms for room in the driver TX queue
+    auto Transmit(const can_frame_t &frame, uint32_t timeout_ms) -> esp_err_t {
+        twai_message_t message = TwaiFromFrame(frame);
+        return twai_transmit_v2(h1, &message, pdMS_TO_TICKS(timeout_ms));
     }
 };
 
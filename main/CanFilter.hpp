@@ -0,0 +1,160 @@
+#pragma once
+#ifndef CANFILTER_HPP
+#define CANFILTER_HPP
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+// Acceptance filter for standard (11-bit) data frames, laid out like twai_filter_config_t.
+// Mask bits set to 1 are "don't care". accepted_ids is how many of the 2048 IDs the filter lets through.
+struct can_filter_t {
+    uint32_t acceptance_code = 0;
+    uint32_t acceptance_mask = 0xFFFFFFFF;
+    bool single_filter = true;
+    uint32_t accepted_ids = 2048;
+    bool exact = false;
+};
+
+namespace can_filter {
+
+static constexpr uint32_t ID_BITS = 0x7FF;
+// Single filter: ID in bits 31:21, RTR bit 20, bits 19:0 hold data bytes 1-2 and are left as don't care
+static constexpr uint32_t SINGLE_ID_SHIFT = 21;
+static constexpr uint32_t SINGLE_DATA_MASK = 0x000FFFFF;
+// Dual filter: filter 1 ID in bits 31:21, filter 2 ID in bits 15:5, data byte 1 nibbles in 19:16 and 3:0
+static constexpr uint32_t DUAL_ID1_SHIFT = 21;
+static constexpr uint32_t DUAL_ID2_SHIFT = 5;
+static constexpr uint32_t DUAL_DATA_MASK = 0x000F000F;
+// Above this many IDs the dual filter split is no longer brute forced, the single filter is used instead
+static constexpr size_t MAX_DUAL_SEARCH = 16;
+
+struct id_group_t {
+    uint32_t code = 0;
+    uint32_t dont_care = 0;
+    uint32_t members = 0;
+
+    [[nodiscard]] constexpr auto Accepted() const -> uint32_t {
+        return 1U << __builtin_popcount(dont_care);
+    }
+    // IDs both groups accept
+    [[nodiscard]] constexpr auto Overlap(const id_group_t &other) const -> uint32_t {
+        bool disjoint = (code ^ other.code) & ~(dont_care | other.dont_care);
+        return disjoint ? 0 : 1U << __builtin_popcount(dont_care & other.dont_care);
+    }
+};
+
+template <size_t N>
+constexpr auto GroupOf(const std::array<uint32_t, N> &ids, size_t count, uint32_t selection) -> id_group_t {
+    id_group_t group;
+    bool first = true;
+    for (size_t i = 0; i < count; i++) {
+        if (!(selection & (1U << i))) {
+            continue;
+        }
+        uint32_t id = ids[i] & ID_BITS;
+        if (first) {
+            group.code = id;
+            first = false;
+        }
+        group.dont_care |= group.code ^ id;
+        group.members++;
+    }
+    group.code &= ~group.dont_care;
+    return group;
+}
+
+constexpr auto SingleFilter(const id_group_t &group) -> can_filter_t {
+    can_filter_t filter;
+    filter.single_filter = true;
+    filter.acceptance_code = group.code << SINGLE_ID_SHIFT;
+    filter.acceptance_mask = (group.dont_care << SINGLE_ID_SHIFT) | SINGLE_DATA_MASK;
+    filter.accepted_ids = group.Accepted();
+    filter.exact = filter.accepted_ids == group.members;
+    return filter;
+}
+
+constexpr auto DualFilter(const id_group_t &first, const id_group_t &second) -> can_filter_t {
+    can_filter_t filter;
+    filter.single_filter = false;
+    filter.acceptance_code = (first.code << DUAL_ID1_SHIFT) | (second.code << DUAL_ID2_SHIFT);
+    filter.acceptance_mask =
+        (first.dont_care << DUAL_ID1_SHIFT) | (second.dont_care << DUAL_ID2_SHIFT) | DUAL_DATA_MASK;
+    // An ID both halves match passes once
+    filter.accepted_ids = first.Accepted() + second.Accepted() - first.Overlap(second);
+    filter.exact = filter.accepted_ids == first.members + second.members;
+    return filter;
+}
+
+// What the controller does with a standard frame: a mask bit of 0 means the frame bit must equal the code bit. The
+// data byte bits are don't care in every filter built here, only the ID and the RTR bit are compared.
+constexpr auto Passes(const can_filter_t &filter, uint32_t id, bool rtr = false) -> bool {
+    auto matches = [&](uint32_t bits, uint32_t field) {
+        return ((bits ^ filter.acceptance_code) & ~filter.acceptance_mask & field) == 0;
+    };
+    id &= ID_BITS;
+    if (filter.single_filter) {
+        return matches((id << SINGLE_ID_SHIFT) | (rtr ? 1U << (SINGLE_ID_SHIFT - 1) : 0), 0xFFFFFFFF);
+    }
+    return matches((id << DUAL_ID1_SHIFT) | (rtr ? 1U << (DUAL_ID1_SHIFT - 1) : 0), 0xFFFF0000) ||
+           matches((id << DUAL_ID2_SHIFT) | (rtr ? 1U << (DUAL_ID2_SHIFT - 1) : 0), 0x0000FFFF);
+}
+
+// One half of a dual filter, or the single filter, as an ID and the bits compared against it, for mask filter APIs
+// that take those instead of the register layout. Set bits in compared must match.
+struct id_match_t {
+    uint32_t id = 0;
+    uint32_t compared = 0;
+};
+
+constexpr auto IdMatch(const can_filter_t &filter, bool second_half = false) -> id_match_t {
+    uint32_t shift = !filter.single_filter && second_half ? DUAL_ID2_SHIFT : DUAL_ID1_SHIFT;
+    return {(filter.acceptance_code >> shift) & ID_BITS, ~(filter.acceptance_mask >> shift) & ID_BITS};
+}
+
+// Standard data frame IDs the filter passes, counted the way the controller matches them
+constexpr auto CountPassed(const can_filter_t &filter, bool rtr = false) -> uint32_t {
+    uint32_t passed = 0;
+    for (uint32_t id = 0; id <= ID_BITS; id++) {
+        passed += Passes(filter, id, rtr) ? 1 : 0;
+    }
+    return passed;
+}
+
+} // namespace can_filter
+
+// Finds the tightest single or dual acceptance filter covering the first count IDs in ids. A filter that is not
+// exact also passes IDs outside the list, those need to be dropped in software.
+template <size_t N>
+constexpr auto ComputeAcceptanceFilter(const std::array<uint32_t, N> &ids, size_t count = N) -> can_filter_t {
+    using namespace can_filter;
+    if (count == 0 || count > 32) {
+        return can_filter_t{};
+    }
+    uint32_t all = count == 32 ? 0xFFFFFFFF : (1U << count) - 1;
+    can_filter_t best = SingleFilter(GroupOf(ids, count, all));
+    if (count >= 2 && count <= MAX_DUAL_SEARCH) {
+        // ids[0] always sits in the first group, so every split is visited once
+        for (uint32_t selection = 1; selection < all; selection += 2) {
+            can_filter_t dual = DualFilter(GroupOf(ids, count, selection), GroupOf(ids, count, all & ~selection));
+            if (dual.accepted_ids < best.accepted_ids) {
+                best = dual;
+            }
+        }
+    }
+    return best;
+}
+
+static_assert(ComputeAcceptanceFilter(std::array<uint32_t, 1>{0x123}).exact);
+static_assert(ComputeAcceptanceFilter(std::array<uint32_t, 2>{0x0AA, 0x330}).acceptance_code == 0x15406600);
+static_assert(ComputeAcceptanceFilter(std::array<uint32_t, 3>{0x100, 0x101, 0x102}).accepted_ids == 3);
+static_assert(ComputeAcceptanceFilter(std::array<uint32_t, 3>{0x100, 0x101, 0x7FF}, 2).acceptance_mask == 0x002FFFFF);
+// Halves for {0x100, 0x103} and {0x101}: the first also matches 0x101 and 0x102, four IDs pass, not five
+static_assert(can_filter::DualFilter({0x100, 0x003, 2}, {0x101, 0x000, 1}).accepted_ids == 4);
+static_assert(can_filter::CountPassed(can_filter::DualFilter({0x100, 0x003, 2}, {0x101, 0x000, 1})) == 4);
+static_assert(!can_filter::DualFilter({0x100, 0x003, 2}, {0x101, 0x000, 1}).exact);
+// Remote frames are never passed, the RTR bit is compared
+static_assert(can_filter::CountPassed(ComputeAcceptanceFilter(std::array<uint32_t, 2>{0x0AA, 0x330}), true) == 0);
+static_assert(can_filter::CountPassed(ComputeAcceptanceFilter(std::array<uint32_t, 1>{0x123}), true) == 0);
+
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+#ifndef CANFRAME_HPP
+#define CANFRAME_HPP
+
+#include <stdint.h>
+
+// Driver independent CAN frame as it moves through the RX path, timestamp is taken when the frame is received
+struct can_frame_t {
+    int64_t timestamp_us = 0;
+    uint32_t identifier = 0;
+    uint8_t dlc = 0;
+    uint8_t bus = 0;
+    bool extd = false;
+    bool rtr = false;
+    uint8_t data[8] = {};
+};
+
+#endif
@@ -0,0 +1,182 @@
+#pragma once
+#ifndef CANGATEWAY_HPP
+#define CANGATEWAY_HPP
+
+#include <array>
+#include <atomic>
+#include <stdint.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "CanConnect.hpp"
+#include "CanRing.hpp"
+
+enum class GatewayAction : uint8_t {
+    FORWARD = 0,
+    DROP = 1,
+    REWRITE = 2
+};
+
+// What happens to one CAN ID on its way from the RX bus to controller 1.
+// REWRITE replaces the identifier with rewrite_id and each data byte with (data & ~data_mask) | data_value.
+// min_interval_us rate limits the forwarded frames, 0 forwards every frame.
+struct gateway_rule_t {
+    uint32_t identifier = 0;
+    GatewayAction action = GatewayAction::FORWARD;
+    uint32_t rewrite_id = 0;
+    uint8_t data_mask[8] = {};
+    uint8_t data_value[8] = {};
+    uint32_t min_interval_us = 0;
+};
+
+struct gateway_stats_t {
+    uint32_t queued = 0;
+    uint32_t sent = 0;
+    uint32_t dropped_rule = 0;
+    uint32_t dropped_rate = 0;
+    uint32_t dropped_full = 0; // TX ring was full, the CAN task never waits for the gateway
+    uint32_t tx_failed = 0;
+};
+
+// Forwards frames from the RX bus to controller 1 without ever blocking the receive path. The CAN task calls
+// Submit() which applies the per-ID rule and pushes into a lock-free TX ring, a dedicated task drains the ring
+// into the TWAI driver.
+class CanGateway {
+  private:
+    static constexpr size_t tx_ring_size = 64;
+    static constexpr size_t max_rules = 32;
+    static constexpr uint8_t no_rule = 0xFF;
+    static constexpr uint32_t tx_timeout_ms = 10;
+    static constexpr uint32_t stats_period_ms = 10000;
+
+    CanRing<tx_ring_size> tx_ring;
+    std::array<uint8_t, CAN_STD_ID_COUNT> rule_index{};
+    std::array<gateway_rule_t, max_rules> rules{};
+    std::array<int64_t, max_rules> last_forward_us{};
+    size_t rule_count = 0;
+    GatewayAction default_action = GatewayAction::FORWARD;
+
+    CanConnect *can{};
+    TaskHandle_t task{};
+    gateway_stats_t stats{};
+    std::atomic<uint32_t> sent{0};
+    std::atomic<uint32_t> tx_failed{0};
+
+    static auto ApplyRewrite(const gateway_rule_t &rule, can_frame_t &frame) -> void {
+        frame.identifier = rule.rewrite_id;
+        for (size_t i = 0; i < sizeof(frame.data); i++) {
+            frame.data[i] = (frame.data[i] & ~rule.data_mask[i]) | rule.data_value[i];
+        }
+    }
+
+    static void gatewayTask(void *task_param) {
+        auto *self = static_cast<CanGateway *>(task_param);
+        TickType_t last_stats = xTaskGetTickCount();
+
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(stats_period_ms));
+            self->tx_ring.Drain([self](const can_frame_t &frame) {
+                if (self->can->Transmit(frame, tx_timeout_ms) == ESP_OK) {
+                    self->sent.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    self->tx_failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+
+            if (xTaskGetTickCount() - last_stats >= pdMS_TO_TICKS(stats_period_ms)) {
+                last_stats = xTaskGetTickCount();
+                gateway_stats_t stats = self->GetStats();
+                ESP_LOGI("CAN GW", "queued: %lu sent: %lu dropped rule: %lu rate: %lu full: %lu tx failed: %lu",
+                         stats.queued, stats.sent, stats.dropped_rule, stats.dropped_rate, stats.dropped_full,
+                         stats.tx_failed);
+            }
+        }
+    }
+
+  public:
+    CanGateway() {
+        rule_index.fill(no_rule);
+    }
+
+    // Rules have to be added before Start(), later rules for the same ID replace earlier ones
+    auto AddRule(const gateway_rule_t &rule) -> bool {
+        if (rule.identifier >= CAN_STD_ID_COUNT) {
+            return false;
+        }
+        uint8_t index = rule_index[rule.identifier];
+        if (index == no_rule) {
+            if (rule_count == max_rules) {
+                ESP_LOGE("CAN GW", "No room for a rule for ID 0x%03lx", rule.identifier);
+                return false;
+            }
+            index = static_cast<uint8_t>(rule_count++);
+            rule_index[rule.identifier] = index;
+        }
+        rules[index] = rule;
+        return true;
+    }
+
+    // Action for IDs without a rule
+    auto SetDefaultAction(GatewayAction action) -> void {
+        default_action = action == GatewayAction::REWRITE ? GatewayAction::FORWARD : action;
+    }
+
+    auto Start(CanConnect &connection, UBaseType_t priority, BaseType_t core) -> void {
+        can = &connection;
+        xTaskCreatePinnedToCore(gatewayTask, "CAN GW TASK", 3072, this, priority, &task, core);
+    }
+
+    // Called from the CAN task for every received frame, never blocks
+    auto Submit(const can_frame_t &frame) -> void {
+        const gateway_rule_t *rule = nullptr;
+        GatewayAction action = default_action;
+        if (!frame.extd && frame.identifier < CAN_STD_ID_COUNT && rule_index[frame.identifier] != no_rule) {
+            rule = &rules[rule_index[frame.identifier]];
+            action = rule->action;
+        }
+        if (action == GatewayAction::DROP) {
+            stats.dropped_rule++;
+            return;
+        }
+
+        if (rule && rule->min_interval_us) {
+            int64_t &last = last_forward_us[rule_index[frame.identifier]];
+            if (last && frame.timestamp_us - last < rule->min_interval_us) {
+                stats.dropped_rate++;
+                return;
+            }
+            last = frame.timestamp_us;
+        }
+
+        can_frame_t *slot = tx_ring.Reserve();
+        if (!slot) {
+            stats.dropped_full++;
+            return;
+        }
+        *slot = frame;
+        if (action == GatewayAction::REWRITE) {
+            ApplyRewrite(*rule, *slot);
+        }
+        tx_ring.Commit();
+        stats.queued++;
+    }
+
+    // Wakes the TX task once per RX batch instead of once per frame
+    auto Flush() -> void {
+        if (task && tx_ring.Size()) {
+            xTaskNotifyGive(task);
+        }
+    }
+
+    [[nodiscard]] auto GetStats() const -> gateway_stats_t {
+        gateway_stats_t snapshot = stats;
+        snapshot.sent = sent.load(std::memory_order_relaxed);
+        snapshot.tx_failed = tx_failed.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+};
+
+#endif
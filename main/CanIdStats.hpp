@@ -0,0 +1,137 @@
+#pragma once
+#ifndef CANIDSTATS_HPP
+#define CANIDSTATS_HPP
+
+#include <array>
+#include <stdint.h>
+
+#include "esp_log.h"
+
+#include "CanBusConfig.hpp"
+#include "CanFrame.hpp"
+#include "CanSignals.hpp"
+
+// Arrivals of one (bus, ID). frames counts since start, the interval and period fields since the last LogStats.
+struct can_id_stats_t {
+    uint32_t key = 0;
+    uint32_t frames = 0;
+    uint32_t period_frames = 0;
+    uint32_t intervals = 0;
+    int64_t last_us = 0;
+    uint32_t min_interval_us = UINT32_MAX;
+    uint32_t max_interval_us = 0;
+    uint64_t interval_sum_us = 0;
+};
+
+// Per-ID arrival counts, rates and inter-arrival jitter plus a per-bus load estimate, kept by the CAN task for every
+// frame it receives. A direct-mapped (bus, ID) index points into a fixed table of the IDs seen so far, so recording
+// is one table load and a few adds at any bus rate. Extended IDs and IDs past the table only count towards the bus.
+class CanIdStats {
+  private:
+    static constexpr size_t MAX_IDS = 128;
+    static constexpr uint8_t NOT_TRACKED = 0xFF;
+    static_assert(MAX_IDS < NOT_TRACKED, "ID table index is 8 bits");
+
+    std::array<uint8_t, CAN_KEY_COUNT> index;
+    std::array<can_id_stats_t, MAX_IDS> ids{};
+    size_t id_count = 0;
+    uint32_t untracked_frames = 0;
+    std::array<uint64_t, CAN_BUS_COUNT> period_bits{};
+    int64_t period_start_us = 0;
+
+  public:
+    // Worst-case length on the wire including stuff bits and the interframe space, classic CAN
+    static constexpr auto FrameBits(uint8_t dlc, bool extd) -> uint32_t {
+        uint32_t data_bits = 8U * (dlc > 8 ? 8 : dlc);
+        return extd ? 67 + data_bits + (53 + data_bits) / 4 : 47 + data_bits + (33 + data_bits) / 4;
+    }
+
+    CanIdStats() {
+        index.fill(NOT_TRACKED);
+    }
+
+    auto Record(const can_frame_t &frame) -> void {
+        if (frame.bus >= CAN_BUS_COUNT) {
+            return;
+        }
+        period_bits[frame.bus] += FrameBits(frame.rtr ? 0 : frame.dlc, frame.extd);
+        if (!period_start_us) {
+            period_start_us = frame.timestamp_us;
+        }
+        if (frame.extd || frame.identifier >= CAN_STD_ID_COUNT) {
+            untracked_frames++;
+            return;
+        }
+        uint32_t key = CanKey(frame.bus, frame.identifier);
+        uint8_t slot = index[key];
+        if (slot == NOT_TRACKED) {
+            if (id_count == MAX_IDS) {
+                untracked_frames++;
+                return;
+            }
+            slot = static_cast<uint8_t>(id_count++);
+            index[key] = slot;
+            ids[slot].key = key;
+        }
+        can_id_stats_t &id = ids[slot];
+        if (id.last_us) {
+            int64_t gap = frame.timestamp_us - id.last_us;
+            auto interval = static_cast<uint32_t>(gap < 0 ? 0 : gap);
+            id.min_interval_us = interval < id.min_interval_us ? interval : id.min_interval_us;
+            id.max_interval_us = interval > id.max_interval_us ? interval : id.max_interval_us;
+            id.interval_sum_us += interval;
+            id.intervals++;
+        }
+        id.last_us = frame.timestamp_us;
+        id.frames++;
+        id.period_frames++;
+    }
+
+    [[nodiscard]] auto Count() const -> size_t {
+        return id_count;
+    }
+    [[nodiscard]] auto Get(size_t i) const -> const can_id_stats_t & {
+        return ids[i];
+    }
+    // Reception time of the last frame of (bus, ID), 0 if it has never been seen
+    [[nodiscard]] auto LastSeen(uint8_t bus, uint32_t identifier) const -> int64_t {
+        if (bus >= CAN_BUS_COUNT || identifier >= CAN_STD_ID_COUNT) {
+            return 0;
+        }
+        uint8_t slot = index[CanKey(bus, identifier)];
+        return slot == NOT_TRACKED ? 0 : ids[slot].last_us;
+    }
+
+    // One line per ID and one per bus for the period since the previous call, then starts a new period. Call from
+    // the task that records.
+    auto LogStats(const char *tag, int64_t now_us) -> void {
+        int64_t period_us = period_start_us ? now_us - period_start_us : 0;
+        for (size_t i = 0; i < id_count; i++) {
+            can_id_stats_t &id = ids[i];
+            uint32_t mean_us = id.intervals ? static_cast<uint32_t>(id.interval_sum_us / id.intervals) : 0;
+            uint32_t rate = period_us > 0 ? static_cast<uint32_t>(id.period_frames * 1000000LL / period_us) : 0;
+            ESP_LOGI(tag, "bus %u id 0x%03lx frames: %lu rate/s: %lu interval us min: %lu mean: %lu max: %lu "
+                          "last seen ms ago: %lld",
+                     CanKeyBus(id.key), CanKeyId(id.key), id.frames, rate, id.intervals ? id.min_interval_us : 0,
+                     mean_us, id.max_interval_us, (now_us - id.last_us) / 1000);
+            id.period_frames = 0;
+            id.min_interval_us = UINT32_MAX;
+            id.max_interval_us = 0;
+            id.interval_sum_us = 0;
+            id.intervals = 0;
+        }
+        for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++) {
+            uint64_t capacity = period_us > 0 ? static_cast<uint64_t>(period_us) * CAN_RX_BUSES[bus].bitrate : 0;
+            uint32_t load_permille = capacity ? static_cast<uint32_t>(period_bits[bus] * 1000000000ULL / capacity) : 0;
+            // Frames the hardware filter drops never get here, the estimate covers all traffic in gateway mode only
+            ESP_LOGI(tag, "bus %u load by received frames: %lu.%lu %%", bus, load_permille / 10, load_permille % 10);
+            period_bits[bus] = 0;
+        }
+        if (untracked_frames) {
+            ESP_LOGI(tag, "frames without per-ID stats (extended or past %zu IDs): %lu", MAX_IDS, untracked_frames);
+        }
+        period_start_us = now_us;
+    }
+};
+
+#endif
@@ -0,0 +1,120 @@
+#pragma once
+#ifndef CANMERGER_HPP
+#define CANMERGER_HPP
+
+#include <array>
+#include <stdint.h>
+
+#include "CanBusConfig.hpp"
+#include "CanRxBackend.hpp"
+
+template <size_t BUSES>
+struct basic_can_merge_stats_t {
+    std::array<uint32_t, BUSES> frames{};
+    uint32_t out_of_order = 0; // frames older than one already emitted, arrived after their merge window
+};
+using can_merge_stats_t = basic_can_merge_stats_t<CAN_BUS_COUNT>;
+
+// Merges the RX rings of every receive bus into one stream ordered by receive timestamp. Each ring is SPSC and
+// already in order, so merging is a lock-free k-way pick of the oldest ring head. Backends merged together have
+// to wake the same consumer, the device backends all notify the task that waits on them. BUSES is CAN_BUS_COUNT
+// outside of the host tests.
+template <size_t BUSES>
+class BasicCanMerger {
+  private:
+    std::array<CanRxBackend *, BUSES> backends{};
+    size_t backend_count = 0;
+    int64_t last_timestamp_us = 0;
+    basic_can_merge_stats_t<BUSES> stats{};
+
+  public:
+    // nullptr entries are skipped, a backend may deliver frames of more than one bus (replay does)
+    explicit BasicCanMerger(const std::array<CanRxBackend *, BUSES> &bus_backends) {
+        for (CanRxBackend *backend : bus_backends) {
+            if (backend) {
+                backends[backend_count++] = backend;
+            }
+        }
+    }
+
+    auto WaitForFrames(uint32_t timeout_ms) -> bool {
+        bool pending = false;
+        for (size_t i = 0; i < backend_count; i++) {
+            pending = backends[i]->WaitForFrames(0) || pending;
+        }
+        if (pending) {
+            return true;
+        }
+        if (backend_count == 0) {
+            return false;
+        }
+        backends[0]->WaitForFrames(timeout_ms);
+        for (size_t i = 0; i < backend_count; i++) {
+            if (backends[i]->Ring().Size()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Calls handler(const can_frame_t &) in timestamp order for the frames pending when the drain started
+    template <typename Handler>
+    auto Drain(Handler &&handler) -> uint32_t {
+        uint32_t budget = 0;
+        for (size_t i = 0; i < backend_count; i++) {
+            budget += backends[i]->Ring().SampleFill();
+        }
+
+        uint32_t count = 0;
+        while (count < budget) {
+            can_rx_ring_t *oldest = nullptr;
+            const can_frame_t *front = nullptr;
+            for (size_t i = 0; i < backend_count; i++) {
+                const can_frame_t *candidate = backends[i]->Ring().Front();
+                if (candidate && (!front || candidate->timestamp_us < front->timestamp_us)) {
+                    front = candidate;
+                    oldest = &backends[i]->Ring();
+                }
+            }
+            if (!front) {
+                break;
+            }
+            if (front->timestamp_us < last_timestamp_us) {
+                stats.out_of_order++;
+            } else {
+                last_timestamp_us = front->timestamp_us;
+            }
+            if (front->bus < BUSES) {
+                stats.frames[front->bus]++;
+            }
+            handler(*front);
+            oldest->Pop();
+            count++;
+        }
+        return count;
+    }
+
+    [[nodiscard]] auto HighWater() const -> uint32_t {
+        uint32_t high_water = 0;
+        for (size_t i = 0; i < backend_count; i++) {
+            uint32_t ring_high_water = backends[i]->Ring().HighWater();
+            high_water = ring_high_water > high_water ? ring_high_water : high_water;
+        }
+        return high_water;
+    }
+
+    [[nodiscard]] auto Dropped() const -> uint32_t {
+        uint32_t dropped = 0;
+        for (size_t i = 0; i < backend_count; i++) {
+            dropped += backends[i]->Ring().Dropped();
+        }
+        return dropped;
+    }
+
+    [[nodiscard]] auto GetStats() const -> const basic_can_merge_stats_t<BUSES> & {
+        return stats;
+    }
+};
+using CanMerger = BasicCanMerger<CAN_BUS_COUNT>;
+
+#endif
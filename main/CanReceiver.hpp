@@ -0,0 +1,172 @@
+#pragma once
+#ifndef CANRECEIVER_HPP
+#define CANRECEIVER_HPP
+
+#include <array>
+#include <memory>
+#include <stdint.h>
+
+#include "esp_log.h"
+
+#include "CanBusConfig.hpp"
+#include "CanFilter.hpp"
+#include "CanFrame.hpp"
+#include "CanIdStats.hpp"
+#include "CanMerger.hpp"
+#include "CanRxBackend.hpp"
+#include "CanSignals.hpp"
+
+// Counters for the batch receive path, rx_missed + rx_overrun is what the driver lost (queue full + HW FIFO overrun),
+// with RX backends rx_missed is the rings' drop count and queue_high_water their highest fill level.
+// sw_rejected counts frames that reached the receiver although no signal consumes them: what an inexact hardware
+// filter lets through, or every unwanted frame on backends without one (replay, SocketCAN).
+struct can_rx_stats_t {
+    uint32_t batches = 0;
+    uint32_t frames = 0;
+    uint32_t max_batch = 0;
+    uint32_t queue_high_water = 0;
+    uint32_t queue_full_events = 0;
+    uint32_t rx_missed = 0;
+    uint32_t rx_overrun = 0;
+    uint32_t sw_rejected = 0;
+};
+
+using can_rx_backends_t = std::array<CanRxBackend *, CAN_BUS_COUNT>;
+
+// Tightest acceptance filter for the IDs the signal table reads on bus
+constexpr auto BusRxFilter(uint8_t bus) -> can_filter_t {
+    auto bus_ids = CanDecoder::BusIds(bus);
+    return ComputeAcceptanceFilter(bus_ids.ids, bus_ids.count);
+}
+
+constexpr auto BusRxFilters() -> std::array<can_filter_t, CAN_BUS_COUNT> {
+    std::array<can_filter_t, CAN_BUS_COUNT> filters{};
+    for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++) {
+        filters[bus] = BusRxFilter(bus);
+    }
+    return filters;
+}
+
+// Receive path on top of RX backends, shared by CanConnect on the device and the host build: merges the backends,
+// applies the software post-filter and keeps the batch and per-ID stats.
+class CanReceiver {
+  protected:
+    std::unique_ptr<CanMerger> merger{};
+    can_rx_backends_t rx_backends{};
+    bool gateway_mode{};
+    can_rx_stats_t rx_stats{};
+    // Heap, the receiver usually lives on the CAN task's stack
+    std::unique_ptr<CanIdStats> id_stats = std::make_unique<CanIdStats>();
+    static constexpr uint32_t timeout_in_ms = 3000;
+    static constexpr std::array<can_filter_t, CAN_BUS_COUNT> rx_filters = BusRxFilters();
+
+    auto LogRxFilters() const -> void {
+        if (gateway_mode) {
+            // A gateway has to see every frame on the bus, not just the ones the dash decodes
+            ESP_LOGI("CAN", "Gateway mode, RX filters accept all IDs");
+            return;
+        }
+        for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++) {
+            const can_filter_t &filter = rx_filters[bus];
+            ESP_LOGI("CAN", "Bus %u RX filter code: 0x%08lx mask: 0x%08lx %s, passes %lu of %lu IDs%s", bus,
+                     filter.acceptance_code, filter.acceptance_mask, filter.single_filter ? "single" : "dual",
+                     filter.accepted_ids, CAN_STD_ID_COUNT, filter.exact ? "" : " (inexact)");
+        }
+    }
+
+    // Software post-filter. Always checked: not every backend programs rx_filters into a controller, and the table
+    // lookup costs less than a frame cache store.
+    auto Accepts(const can_frame_t &frame) const -> bool {
+        if (gateway_mode) {
+            return true;
+        }
+        if (frame.extd || frame.bus >= CAN_BUS_COUNT) {
+            return false;
+        }
+        return CanDecoder::Consumes(frame.bus, frame.identifier);
+    }
+
+    template <typename Handler>
+    auto ReceiveBackendBatch(Handler &handler) -> uint32_t {
+        if (!merger->WaitForFrames(timeout_in_ms)) {
+            ESP_LOGE("CAN FATAL", "Not receiving any CAN Data, RX backends idle for %lu ms", timeout_in_ms);
+            return 0;
+        }
+        uint32_t count = 0;
+        merger->Drain([&](const can_frame_t &frame) {
+            id_stats->Record(frame);
+            if (!Accepts(frame)) {
+                rx_stats.sw_rejected++;
+                return;
+            }
+            handler(frame);
+            count++;
+        });
+        rx_stats.queue_high_water = merger->HighWater();
+        rx_stats.rx_missed = merger->Dropped();
+        return count;
+    }
+
+    auto CountBatch(uint32_t count) -> uint32_t {
+        if (count == 0) {
+            return 0;
+        }
+        rx_stats.batches++;
+        rx_stats.frames += count;
+        if (count > rx_stats.max_batch) {
+            rx_stats.max_batch = count;
+        }
+        return count;
+    }
+
+    explicit CanReceiver(bool gateway_mode) : gateway_mode(gateway_mode) {}
+
+  public:
+    // Receives through backends, one per bus, nullptr entries are skipped
+    explicit CanReceiver(const can_rx_backends_t &backends, bool gateway_mode = false)
+        : merger(std::make_unique<CanMerger>(backends)), rx_backends(backends), gateway_mode(gateway_mode) {
+        LogRxFilters();
+    }
+
+    // Blocks until frames arrive, then drains every pending frame and calls handler(const can_frame_t &) for each.
+    // With more than one bus frames come merged in receive timestamp order, tagged with their bus.
+    // Returns the number of frames handled in this batch.
+    template <typename Handler>
+    auto ReceiveBatch(Handler &&handler) -> uint32_t {
+        return CountBatch(ReceiveBackendBatch(handler));
+    }
+
+    [[nodiscard]] auto GetRxStats() const -> const can_rx_stats_t & {
+        return rx_stats;
+    }
+
+    // Per-ID arrivals and bus load, only the receiving task may touch them
+    [[nodiscard]] auto IdStats() -> CanIdStats & {
+        return *id_stats;
+    }
+
+    // Health of the controller behind bus, false when its backend has none (replay, SocketCAN)
+    auto ControllerHealth(uint8_t bus, can_controller_health_t &health) -> bool {
+        return bus < CAN_BUS_COUNT && rx_backends[bus] && rx_backends[bus]->ControllerHealth(health);
+    }
+
+    // Bus-off recovery and alert history of bus, nullptr when its backend has no controller
+    auto Recovery(uint8_t bus) -> CanRecovery * {
+        return bus < CAN_BUS_COUNT && rx_backends[bus] ? rx_backends[bus]->Recovery() : nullptr;
+    }
+
+    // Per-bus frame counts and ordering of the merged stream, nullptr without backends
+    [[nodiscard]] auto GetMergeStats() const -> const can_merge_stats_t * {
+        return merger ? &merger->GetStats() : nullptr;
+    }
+
+    // Decodes a received frame through the signal table
+    static auto HandleFrame(const can_frame_t &frame, decoded_signals_t &signals) -> bool {
+        if (frame.extd || frame.rtr) {
+            return false;
+        }
+        return CanDecoder::Decode(frame.bus, frame.identifier, frame.data, frame.dlc, signals);
+    }
+};
+
+#endif
@@ -0,0 +1,186 @@
+#pragma once
+#ifndef CANRECOVERY_HPP
+#define CANRECOVERY_HPP
+
+#include <array>
+#include <stdint.h>
+
+#include "esp_log.h"
+
+#include "CanRxBackend.hpp"
+
+// Controller alerts, driver independent. TwaiAlerts() maps the TWAI driver's onto these.
+static constexpr uint32_t CAN_ALERT_BUS_OFF = 1U << 0;
+static constexpr uint32_t CAN_ALERT_BUS_RECOVERED = 1U << 1;
+static constexpr uint32_t CAN_ALERT_ERROR_PASSIVE = 1U << 2;
+static constexpr uint32_t CAN_ALERT_ERROR_WARNING = 1U << 3;
+static constexpr uint32_t CAN_ALERT_ERROR_ACTIVE = 1U << 4;
+static constexpr uint32_t CAN_ALERT_RX_QUEUE_FULL = 1U << 5;
+static constexpr uint32_t CAN_ALERT_RX_FIFO_OVERRUN = 1U << 6;
+static constexpr uint32_t CAN_ALERT_ARB_LOST = 1U << 7;
+static constexpr uint32_t CAN_ALERT_BUS_ERROR = 1U << 8;
+static constexpr size_t CAN_ALERT_COUNT = 9;
+static constexpr std::array<const char *, CAN_ALERT_COUNT> CAN_ALERT_NAMES{
+    "bus off", "recovered", "error passive", "error warning", "error active",
+    "rx queue full", "rx fifo overrun", "arb lost", "bus error"};
+
+// Operations recovery needs from a controller: the legacy TWAI driver on the device, a simulated one on the host
+class CanController {
+  public:
+    virtual ~CanController() = default;
+
+    // Starts the bus-off recovery sequence (128 x 11 recessive bits), the controller stops when it is done
+    virtual auto InitiateRecovery() -> bool = 0;
+    virtual auto Start() -> bool = 0;
+    virtual auto State() -> CanControllerState = 0;
+};
+
+struct can_alert_event_t {
+    int64_t time_us = 0;
+    uint32_t alerts = 0;
+};
+
+struct can_recovery_stats_t {
+    std::array<uint32_t, CAN_ALERT_COUNT> alerts{}; // times each alert was raised
+    uint32_t bus_offs = 0;
+    uint32_t recoveries = 0;
+    uint32_t retries = 0; // recovery steps repeated because the expected alert never came
+    uint32_t last_recovery_us = 0;
+    uint32_t max_recovery_us = 0;
+};
+
+// Bus-off recovery for one controller, driven by its alerts. Bus off initiates recovery right away, the recovered
+// alert restarts the controller, so the bus is back after the 128 x 11 bit recovery sequence plus one alert
+// round trip, under 3 ms at 500 kbit/s. Poll() covers alerts that got lost by checking the controller state when
+// a step takes longer than RETRY_US. Every alert is counted and kept in a short history.
+// Call HandleAlerts and Poll from the task that reads the controller's alerts.
+class CanRecovery {
+  public:
+    static constexpr size_t HISTORY = 16;
+    static constexpr int64_t RETRY_US = 50000;
+
+  private:
+    CanController &controller;
+    const char *name;
+    bool recovering = false;
+    int64_t bus_off_us = 0;
+    int64_t last_step_us = 0;
+    can_recovery_stats_t stats{};
+    std::array<can_alert_event_t, HISTORY> history{};
+    uint32_t history_count = 0;
+    uint32_t logged_count = 0;
+
+    auto Recovered(int64_t now_us) -> void {
+        recovering = false;
+        auto duration = static_cast<uint32_t>(now_us - bus_off_us);
+        stats.recoveries++;
+        stats.last_recovery_us = duration;
+        if (duration > stats.max_recovery_us) {
+            stats.max_recovery_us = duration;
+        }
+        ESP_LOGI("CAN ALERT", "%s back on the bus after %lu us", name, duration);
+    }
+
+    auto Restart(int64_t now_us) -> void {
+        last_step_us = now_us;
+        if (controller.Start()) {
+            Recovered(now_us);
+        } else {
+            ESP_LOGE("CAN ALERT", "%s failed to restart after recovery", name);
+        }
+    }
+
+  public:
+    CanRecovery(CanController &controller, const char *name) : controller(controller), name(name) {}
+
+    auto HandleAlerts(uint32_t alerts, int64_t now_us) -> void {
+        if (!alerts) {
+            return;
+        }
+        for (size_t i = 0; i < CAN_ALERT_COUNT; i++) {
+            if (alerts & (1U << i)) {
+                stats.alerts[i]++;
+            }
+        }
+        history[history_count++ % HISTORY] = {now_us, alerts};
+
+        if (alerts & CAN_ALERT_BUS_OFF) {
+            stats.bus_offs++;
+            recovering = true;
+            bus_off_us = now_us;
+            last_step_us = now_us;
+            ESP_LOGE("CAN ALERT", "%s bus off, starting recovery", name);
+            if (!controller.InitiateRecovery()) {
+                ESP_LOGE("CAN ALERT", "%s failed to initiate recovery", name);
+            }
+        }
+        if ((alerts & CAN_ALERT_BUS_RECOVERED) && recovering) {
+            Restart(now_us);
+        }
+        if (alerts & CAN_ALERT_ERROR_PASSIVE) {
+            ESP_LOGE("CAN ALERT", "%s error passive", name);
+        }
+    }
+
+    // Recovery watchdog, cheap when nothing is pending
+    auto Poll(int64_t now_us) -> void {
+        if (!recovering || now_us - last_step_us < RETRY_US) {
+            return;
+        }
+        last_step_us = now_us;
+        stats.retries++;
+        switch (controller.State()) {
+        case CanControllerState::BUS_OFF:
+            controller.InitiateRecovery();
+            break;
+        case CanControllerState::STOPPED:
+            Restart(now_us);
+            break;
+        case CanControllerState::RECOVERING:
+            break;
+        default:
+            // Running again without us seeing the recovered alert
+            Recovered(now_us);
+            break;
+        }
+    }
+
+    [[nodiscard]] auto Recovering() const -> bool {
+        return recovering;
+    }
+    [[nodiscard]] auto GetStats() const -> const can_recovery_stats_t & {
+        return stats;
+    }
+
+    // Calls fn(const can_alert_event_t &) for the kept alerts, oldest first
+    template <typename Fn>
+    auto ForEachAlert(Fn &&fn) const -> void {
+        uint32_t first = history_count > HISTORY ? history_count - HISTORY : 0;
+        for (uint32_t i = first; i < history_count; i++) {
+            fn(history[i % HISTORY]);
+        }
+    }
+
+    // Counts, then the alerts raised since the previous call that are still in the history
+    auto LogStats(const char *tag, int64_t now_us) -> void {
+        ESP_LOGI(tag, "%s bus offs: %lu recoveries: %lu retries: %lu last recovery us: %lu max: %lu", name,
+                 stats.bus_offs, stats.recoveries, stats.retries, stats.last_recovery_us, stats.max_recovery_us);
+        for (size_t i = 0; i < CAN_ALERT_COUNT; i++) {
+            if (stats.alerts[i]) {
+                ESP_LOGI(tag, "%s %s: %lu", name, CAN_ALERT_NAMES[i], stats.alerts[i]);
+            }
+        }
+        uint32_t first = history_count - logged_count > HISTORY ? history_count - HISTORY : logged_count;
+        for (uint32_t n = first; n < history_count; n++) {
+            const can_alert_event_t &event = history[n % HISTORY];
+            for (size_t i = 0; i < CAN_ALERT_COUNT; i++) {
+                if (event.alerts & (1U << i)) {
+                    ESP_LOGI(tag, "%s %lld ms ago: %s", name, (now_us - event.time_us) / 1000, CAN_ALERT_NAMES[i]);
+                }
+            }
+        }
+        logged_count = history_count;
+    }
+};
+
+#endif
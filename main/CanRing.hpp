@@ -0,0 +1,105 @@
+#pragma once
+#ifndef CANRING_HPP
+#define CANRING_HPP
+
+#include <array>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "CanFrame.hpp"
+
+// Single producer / single consumer ring of CAN frames. The producer may be an ISR: Reserve() hands out the next
+// free slot to fill in place and Commit() publishes it, nothing blocks or allocates. The consumer reads frames in
+// place with Drain() and frees the whole batch with one index store.
+template <size_t N>
+class CanRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "CanRing size must be a power of two");
+
+  private:
+    static constexpr uint32_t index_mask = N - 1;
+
+    std::array<can_frame_t, N> frames{};
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> dropped{0};
+    uint32_t high_water = 0;
+
+  public:
+    // Producer side, returns nullptr and counts a drop when the ring is full
+    auto Reserve() -> can_frame_t * {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= N) {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &frames[h & index_mask];
+    }
+
+    auto Commit() -> void {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    auto Push(const can_frame_t &frame) -> bool {
+        can_frame_t *slot = Reserve();
+        if (!slot) {
+            return false;
+        }
+        *slot = frame;
+        Commit();
+        return true;
+    }
+
+    // Consumer side, calls handler(const can_frame_t &) on up to max pending frames in arrival order
+    template <typename Handler>
+    auto Drain(Handler &&handler, size_t max = N) -> uint32_t {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t pending = head.load(std::memory_order_acquire) - t;
+        if (pending > high_water) {
+            high_water = pending;
+        }
+        uint32_t count = pending < max ? pending : static_cast<uint32_t>(max);
+        for (uint32_t i = 0; i < count; i++) {
+            handler(static_cast<const can_frame_t &>(frames[(t + i) & index_mask]));
+        }
+        tail.store(t + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side, oldest pending frame or nullptr, Pop() releases it
+    [[nodiscard]] auto Front() const -> const can_frame_t * {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) {
+            return nullptr;
+        }
+        return &frames[t & index_mask];
+    }
+
+    auto Pop() -> void {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer side, records the current fill level for HighWater()
+    auto SampleFill() -> uint32_t {
+        uint32_t pending = head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+        if (pending > high_water) {
+            high_water = pending;
+        }
+        return pending;
+    }
+
+    [[nodiscard]] auto Size() const -> uint32_t {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    [[nodiscard]] auto Dropped() const -> uint32_t {
+        return dropped.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] auto HighWater() const -> uint32_t {
+        return high_water;
+    }
+    static constexpr auto Capacity() -> size_t {
+        return N;
+    }
+};
+
+#endif
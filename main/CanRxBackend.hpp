@@ -0,0 +1,67 @@
+#pragma once
+#ifndef CANRXBACKEND_HPP
+#define CANRXBACKEND_HPP
+
+#include <stdint.h>
+
+#include "CanRing.hpp"
+
+static constexpr size_t CAN_RX_RING_SIZE = 256;
+using can_rx_ring_t = CanRing<CAN_RX_RING_SIZE>;
+
+// Error state of a CAN controller, warning and passive follow the error counters (96 and 128)
+enum class CanControllerState : uint8_t {
+    STOPPED = 0,
+    ERROR_ACTIVE = 1,
+    ERROR_WARNING = 2,
+    ERROR_PASSIVE = 3,
+    BUS_OFF = 4,
+    RECOVERING = 5,
+};
+static constexpr const char *CAN_CONTROLLER_STATE_NAMES[] = {"stopped", "active",  "warning",
+                                                             "passive", "bus off", "recovering"};
+
+static constexpr auto CanStateFromCounters(uint32_t tx_errors, uint32_t rx_errors) -> CanControllerState {
+    uint32_t errors = tx_errors > rx_errors ? tx_errors : rx_errors;
+    if (errors >= 128) {
+        return CanControllerState::ERROR_PASSIVE;
+    }
+    return errors >= 96 ? CanControllerState::ERROR_WARNING : CanControllerState::ERROR_ACTIVE;
+}
+
+// Controller health as the driver reports it, counts are totals since the driver started
+struct can_controller_health_t {
+    CanControllerState state = CanControllerState::STOPPED;
+    uint32_t tx_errors = 0; // TEC
+    uint32_t rx_errors = 0; // REC
+    uint32_t bus_errors = 0;
+    uint32_t rx_missed = 0;  // driver queue full
+    uint32_t rx_overrun = 0; // hardware FIFO overrun
+    uint32_t arb_lost = 0;
+};
+
+class CanRecovery;
+
+// Low-level receive source feeding frames into a ring the CAN task drains in bulk. Implemented by the TWAI ISR
+// backend on the device and by mocks or replay sources on a host build.
+class CanRxBackend {
+  public:
+    virtual ~CanRxBackend() = default;
+
+    // Blocks until the ring holds frames or timeout_ms passes, returns false on timeout
+    virtual auto WaitForFrames(uint32_t timeout_ms) -> bool = 0;
+
+    virtual auto Ring() -> can_rx_ring_t & = 0;
+
+    // Fills health for backends on a real controller, false for replay and other sources without one
+    virtual auto ControllerHealth(can_controller_health_t & /*health*/) -> bool {
+        return false;
+    }
+
+    // Bus-off recovery and alert history of the controller, nullptr for sources that never go bus off
+    virtual auto Recovery() -> CanRecovery * {
+        return nullptr;
+    }
+};
+
+#endif
@@ -0,0 +1,265 @@
+#pragma once
+#ifndef CANSIGNALS_HPP
+#define CANSIGNALS_HPP
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <utility>
+
+#include "CanBusConfig.hpp"
+
+static constexpr uint32_t TORQ3 = 0x0AA;
+static constexpr uint32_t SPEED = 0x1A0;
+static constexpr uint32_t ENGDATA = 0x1D0;
+static constexpr uint32_t FUELMLS = 0x330;
+
+static constexpr uint32_t CAN_STD_ID_COUNT = 2048;
+// Frames are keyed by (bus, 11-bit ID), key = bus * 2048 + ID
+static constexpr uint32_t CAN_KEY_COUNT = CAN_BUS_COUNT * CAN_STD_ID_COUNT;
+
+static constexpr auto CanKey(uint8_t bus, uint32_t identifier) -> uint32_t {
+    return bus * CAN_STD_ID_COUNT + identifier;
+}
+static constexpr auto CanKeyBus(uint32_t key) -> uint8_t {
+    return static_cast<uint8_t>(key / CAN_STD_ID_COUNT);
+}
+static constexpr auto CanKeyId(uint32_t key) -> uint32_t {
+    return key % CAN_STD_ID_COUNT;
+}
+
+// ODO and FUEL_RANGE are not in CAN_SIGNALS until their layout in FUELMLS is known, nothing decodes them yet
+enum class Signal : uint8_t {
+    RPM = 0,
+    SPEED = 1,
+    FUEL = 2,
+    TEMP = 3,
+    ODO = 4,
+    FUEL_RANGE = 5,
+    COUNT
+};
+static constexpr size_t SIGNAL_COUNT = static_cast<size_t>(Signal::COUNT);
+static constexpr uint32_t ALL_SIGNALS = (1U << SIGNAL_COUNT) - 1;
+
+static constexpr auto SignalBit(Signal signal) -> uint32_t {
+    return 1U << static_cast<uint8_t>(signal);
+}
+
+static constexpr std::array<const char *, SIGNAL_COUNT> SIGNAL_NAMES{"RPM", "SPEED", "FUEL", "TEMP", "ODO", "FUEL_RANGE"};
+
+// One signal inside a CAN frame, bits are numbered little-endian (Intel) from bit 0 of data[0].
+// value = raw * scale_num / scale_den + offset, bus is the index into CAN_RX_BUSES the frame arrives on.
+// A signal spread over several fields has one entry per field, add_to_previous sums a field into the value of the
+// entry before it.
+struct can_signal_t {
+    Signal signal;
+    uint32_t identifier;
+    uint8_t start_bit;
+    uint8_t length;
+    int32_t scale_num = 1;
+    int32_t scale_den = 1;
+    int32_t offset = 0;
+    bool is_signed = false;
+    uint8_t bus = 0;
+    bool add_to_previous = false;
+
+    [[nodiscard]] constexpr auto Key() const -> uint32_t {
+        return CanKey(bus, identifier);
+    }
+};
+
+// clang-format off
+static constexpr std::array CAN_SIGNALS{
+    // is_signed, bus and add_to_previous follow offset and default to an unsigned field of its own on bus 0.
+    // RPM and SPEED are two fields each, scaled the way the dash has always shown them.
+    //           signal         id       start len num     den   offset
+    can_signal_t{Signal::RPM,   TORQ3,   48,   8,  255,    8,    0},                 // data[6] * 255 / 2 / 4
+    can_signal_t{Signal::RPM,   TORQ3,   40,   8,  1,      1,    0, false, 0, true}, // + data[5]
+    can_signal_t{Signal::SPEED, SPEED,   8,    4,  158355, 1000, 5},                 // (data[1] & 0xF) * 255 * .621 + 5
+    can_signal_t{Signal::SPEED, SPEED,   0,    8,  1,      1,    0, false, 0, true}, // + data[0]
+    can_signal_t{Signal::FUEL,  ENGDATA, 24,   8,  100,    255,  0},                 // percent
+    can_signal_t{Signal::TEMP,  ENGDATA, 0,    8,  1,      1,    -48},
+};
+// clang-format on
+
+struct decoded_signals_t {
+    uint32_t updated = 0; // bit per Signal that was present in the decoded frame
+    std::array<int32_t, SIGNAL_COUNT> value{};
+
+    [[nodiscard]] auto Has(Signal signal) const -> bool {
+        return updated & SignalBit(signal);
+    }
+    [[nodiscard]] auto Get(Signal signal) const -> int32_t {
+        return value[static_cast<size_t>(signal)];
+    }
+};
+
+// Builds the frame dispatch for a signal table at compile time. Every distinct (bus, ID) becomes one frame
+// decoder with its signals unrolled as constants, and a per-key index turns dispatch into a single table load
+// and indirect call no matter how many signals or frames the table holds.
+template <const auto &Table>
+class SignalDecoder {
+  private:
+    static constexpr size_t signal_count = Table.size();
+    static constexpr uint8_t no_frame = 0xFF;
+
+    static constexpr auto CountFrames() -> size_t {
+        size_t frames = 0;
+        for (size_t i = 0; i < signal_count; i++) {
+            bool seen = false;
+            for (size_t j = 0; j < i; j++) {
+                seen = seen || Table[j].Key() == Table[i].Key();
+            }
+            frames += seen ? 0 : 1;
+        }
+        return frames;
+    }
+
+  public:
+    static constexpr size_t frame_count = CountFrames();
+
+  private:
+    static_assert(frame_count < no_frame, "too many frames for the 8-bit dispatch index");
+
+    static constexpr auto BuildFrameKeys() -> std::array<uint32_t, frame_count> {
+        std::array<uint32_t, frame_count> keys{};
+        size_t frames = 0;
+        for (size_t i = 0; i < signal_count; i++) {
+            bool seen = false;
+            for (size_t j = 0; j < frames; j++) {
+                seen = seen || keys[j] == Table[i].Key();
+            }
+            if (!seen) {
+                keys[frames++] = Table[i].Key();
+            }
+        }
+        return keys;
+    }
+
+    static constexpr auto BuildKeyIndex() -> std::array<uint8_t, CAN_KEY_COUNT> {
+        std::array<uint8_t, CAN_KEY_COUNT> index{};
+        for (auto &entry : index) {
+            entry = no_frame;
+        }
+        for (size_t frame = 0; frame < frame_count; frame++) {
+            index[frame_keys[frame]] = static_cast<uint8_t>(frame);
+        }
+        return index;
+    }
+
+  public:
+    // (bus, ID) key of every frame the table decodes, see CanKey()
+    static constexpr std::array<uint32_t, frame_count> frame_keys = BuildFrameKeys();
+
+  private:
+    static constexpr std::array<uint8_t, CAN_KEY_COUNT> key_index = BuildKeyIndex();
+
+    static constexpr auto BuildFrameSignalMasks() -> std::array<uint32_t, frame_count> {
+        std::array<uint32_t, frame_count> masks{};
+        for (size_t i = 0; i < signal_count; i++) {
+            masks[key_index[Table[i].Key()]] |= SignalBit(Table[i].signal);
+        }
+        return masks;
+    }
+
+  public:
+    // Which signals (bit per Signal) each frame in frame_keys carries
+    static constexpr std::array<uint32_t, frame_count> frame_signal_masks = BuildFrameSignalMasks();
+
+    // IDs consumed on one bus, the first count entries are valid
+    struct bus_ids_t {
+        std::array<uint32_t, frame_count> ids{};
+        size_t count = 0;
+    };
+    static constexpr auto BusIds(uint8_t bus) -> bus_ids_t {
+        bus_ids_t result;
+        for (uint32_t key : frame_keys) {
+            if (CanKeyBus(key) == bus) {
+                result.ids[result.count++] = CanKeyId(key);
+            }
+        }
+        return result;
+    }
+
+  private:
+    static auto LoadPayload(const uint8_t *data, uint8_t dlc) -> uint64_t {
+        uint8_t bytes[8] = {};
+        memcpy(bytes, data, dlc > 8 ? 8 : dlc);
+        uint64_t payload = 0;
+        for (int i = 7; i >= 0; i--) {
+            payload = (payload << 8) | bytes[i];
+        }
+        return payload;
+    }
+
+    template <size_t I>
+    static auto DecodeSignal(uint64_t payload, decoded_signals_t &out) -> void {
+        constexpr can_signal_t sig = Table[I];
+        static_assert(sig.identifier < CAN_STD_ID_COUNT, "only 11-bit identifiers are supported");
+        static_assert(sig.bus < CAN_BUS_COUNT, "signal is on a bus missing from CAN_RX_BUSES");
+        static_assert(sig.length > 0 && sig.start_bit + sig.length <= 64, "signal does not fit in 8 bytes");
+        static_assert(sig.scale_den != 0, "signal scale denominator is zero");
+        static_assert(!sig.add_to_previous ||
+                          (I > 0 && Table[I - 1].signal == sig.signal && Table[I - 1].Key() == sig.Key()),
+                      "add_to_previous needs an entry for the same signal and frame right before it");
+
+        constexpr uint64_t mask = sig.length == 64 ? ~0ULL : ((1ULL << sig.length) - 1);
+        uint64_t raw = (payload >> sig.start_bit) & mask;
+        int64_t value = static_cast<int64_t>(raw);
+        if constexpr (sig.is_signed && sig.length < 64) {
+            constexpr uint64_t sign_bit = 1ULL << (sig.length - 1);
+            value = static_cast<int64_t>((raw ^ sign_bit) - sign_bit);
+        }
+        if constexpr (sig.scale_num != 1 || sig.scale_den != 1) {
+            value = value * sig.scale_num / sig.scale_den;
+        }
+        constexpr auto slot = static_cast<size_t>(sig.signal);
+        if constexpr (sig.add_to_previous) {
+            out.value[slot] += static_cast<int32_t>(value + sig.offset);
+        } else {
+            out.value[slot] = static_cast<int32_t>(value + sig.offset);
+        }
+        out.updated |= 1U << slot;
+    }
+
+    template <size_t Frame, size_t... I>
+    static auto DecodeFrameSignals(uint64_t payload, decoded_signals_t &out, std::index_sequence<I...>) -> void {
+        ((Table[I].Key() == frame_keys[Frame] ? DecodeSignal<I>(payload, out) : void()), ...);
+    }
+
+    template <size_t Frame>
+    static auto DecodeFrameAt(const uint8_t *data, uint8_t dlc, decoded_signals_t &out) -> void {
+        DecodeFrameSignals<Frame>(LoadPayload(data, dlc), out, std::make_index_sequence<signal_count>{});
+    }
+
+    using frame_decoder_t = void (*)(const uint8_t *, uint8_t, decoded_signals_t &);
+
+    template <size_t... F>
+    static constexpr auto BuildDecoders(std::index_sequence<F...>) -> std::array<frame_decoder_t, frame_count> {
+        return {&DecodeFrameAt<F>...};
+    }
+
+    static constexpr std::array<frame_decoder_t, frame_count> decoders =
+        BuildDecoders(std::make_index_sequence<frame_count>{});
+
+  public:
+    [[nodiscard]] static constexpr auto Consumes(uint8_t bus, uint32_t identifier) -> bool {
+        return bus < CAN_BUS_COUNT && identifier < CAN_STD_ID_COUNT &&
+               key_index[CanKey(bus, identifier)] != no_frame;
+    }
+
+    // Decodes every table signal carried by this frame into out, returns false for frames the table does not use
+    static auto Decode(uint8_t bus, uint32_t identifier, const uint8_t *data, uint8_t dlc, decoded_signals_t &out)
+        -> bool {
+        if (!Consumes(bus, identifier)) {
+            return false;
+        }
+        decoders[key_index[CanKey(bus, identifier)]](data, dlc, out);
+        return true;
+    }
+};
+
+using CanDecoder = SignalDecoder<CAN_SIGNALS>;
+
+#endif
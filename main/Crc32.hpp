@@ -0,0 +1,32 @@
+#pragma once
+#ifndef CRC32_HPP
+#define CRC32_HPP
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE 802.3, reflected), table built at compile time
+constexpr auto BuildCrc32Table() -> std::array<uint32_t, 256> {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320U : 0);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+static constexpr std::array<uint32_t, 256> CRC32_TABLE = BuildCrc32Table();
+
+inline auto Crc32(const void *data, size_t size) -> uint32_t {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    uint32_t crc = 0xFFFFFFFFU;
+    for (size_t i = 0; i < size; i++) {
+        crc = CRC32_TABLE[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+#endif
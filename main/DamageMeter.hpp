@@ -0,0 +1,103 @@
+#pragma once
+#ifndef DAMAGEMETER_HPP
+#define DAMAGEMETER_HPP
+
+#include <array>
+#include <stdint.h>
+
+#include "Hal.hpp"
+#include "lvgl.h"
+
+struct damage_stats_t {
+    uint32_t frames = 0;     // refreshes that redrew anything
+    uint64_t pixels = 0;     // redrawn over all those frames
+    uint32_t max_pixels = 0; // largest single frame
+    uint64_t render_us = 0;  // drawing the dirty areas, including waits for the flush of earlier chunks
+    uint32_t max_render_us = 0;
+};
+
+// Counts the pixels LVGL redraws per frame on a display and times the rendering of them. Pixels come from the areas
+// invalidated between refreshes, areas that sit inside an earlier one are dropped the way lv_inv_area drops them,
+// overlaps LVGL later joins still count twice, so this is an upper bound of what reaches the flush callback. Events
+// run in the LVGL task, read the stats under the display lock.
+class DamageMeter {
+  private:
+    static constexpr uint32_t MAX_AREAS = 32; // LV_INV_BUF_SIZE
+    std::array<lv_area_t, MAX_AREAS> areas{};
+    uint32_t area_count = 0;
+    uint32_t frame_pixels = 0;
+    int64_t render_start_us = 0;
+    damage_stats_t stats;
+
+    static auto Inside(const lv_area_t &in, const lv_area_t &outer) -> bool {
+        return in.x1 >= outer.x1 && in.y1 >= outer.y1 && in.x2 <= outer.x2 && in.y2 <= outer.y2;
+    }
+
+    auto Invalidated(const lv_area_t &area) -> void {
+        for (uint32_t i = 0; i < area_count; i++) {
+            if (Inside(area, areas[i])) {
+                return;
+            }
+        }
+        if (area_count < MAX_AREAS) {
+            areas[area_count++] = area;
+        }
+        frame_pixels += lv_area_get_size(&area);
+    }
+
+    auto Refreshed() -> void {
+        if (frame_pixels) {
+            stats.frames++;
+            stats.pixels += frame_pixels;
+            if (frame_pixels > stats.max_pixels) {
+                stats.max_pixels = frame_pixels;
+            }
+        }
+        area_count = 0;
+        frame_pixels = 0;
+    }
+
+    auto Rendered() -> void {
+        auto render_us = static_cast<uint32_t>(hal::NowUs() - render_start_us);
+        stats.render_us += render_us;
+        if (render_us > stats.max_render_us) {
+            stats.max_render_us = render_us;
+        }
+    }
+
+    static auto DisplayEvent(lv_event_t *event) -> void {
+        auto *self = static_cast<DamageMeter *>(lv_event_get_user_data(event));
+        switch (lv_event_get_code(event)) {
+        case LV_EVENT_INVALIDATE_AREA:
+            self->Invalidated(*static_cast<const lv_area_t *>(lv_event_get_param(event)));
+            break;
+        case LV_EVENT_RENDER_START:
+            self->render_start_us = hal::NowUs();
+            break;
+        case LV_EVENT_RENDER_READY:
+            self->Rendered();
+            break;
+        default:
+            self->Refreshed();
+            break;
+        }
+    }
+
+  public:
+    // Call with the display lock held
+    auto Attach(lv_display_t *display) -> void {
+        lv_display_add_event_cb(display, DisplayEvent, LV_EVENT_INVALIDATE_AREA, this);
+        lv_display_add_event_cb(display, DisplayEvent, LV_EVENT_RENDER_START, this);
+        lv_display_add_event_cb(display, DisplayEvent, LV_EVENT_RENDER_READY, this);
+        lv_display_add_event_cb(display, DisplayEvent, LV_EVENT_REFR_READY, this);
+    }
+
+    [[nodiscard]] auto GetStats() const -> const damage_stats_t & {
+        return stats;
+    }
+    auto ResetStats() -> void {
+        stats = {};
+    }
+};
+
+#endif
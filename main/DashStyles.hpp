@@ -0,0 +1,50 @@
+#pragma once
+#ifndef DASHSTYLES_HPP
+#define DASHSTYLES_HPP
+
+#include "gaugeMath.hpp"
+#include "hexCodes.hpp"
+#include "lvgl.h"
+
+// Styles shared by every gauge, constant property lists in flash. lv_obj_set_style_* gives each object a local
+// style of its own on the LVGL heap, these are added by pointer with lv_obj_add_style and never change.
+
+// Scale labels
+static const lv_style_const_prop_t DASH_SCALE_PROPS[] = {
+    LV_STYLE_CONST_TEXT_COLOR(LV_COLOR_MAKE(0xFF, 0xFF, 0xFF)),
+    LV_STYLE_CONST_PROPS_END,
+};
+static LV_STYLE_CONST_INIT(DASH_SCALE_STYLE, DASH_SCALE_PROPS);
+
+// lv_arc indicator of the STOCK renderer
+static const lv_style_const_prop_t DASH_ARC_INDICATOR_PROPS[] = {
+    LV_STYLE_CONST_ARC_WIDTH(ARC_WIDTH),
+    LV_STYLE_CONST_ARC_COLOR(LV_COLOR_MAKE((GAUGE_COLOR >> 16) & 0xFF, (GAUGE_COLOR >> 8) & 0xFF, GAUGE_COLOR & 0xFF)),
+    LV_STYLE_CONST_ARC_ROUNDED(false),
+    LV_STYLE_CONST_PROPS_END,
+};
+static LV_STYLE_CONST_INIT(DASH_ARC_INDICATOR_STYLE, DASH_ARC_INDICATOR_PROPS);
+
+// Containers that draw nothing themselves
+static const lv_style_const_prop_t DASH_CLEAR_PROPS[] = {
+    LV_STYLE_CONST_BG_OPA(LV_OPA_TRANSP),
+    LV_STYLE_CONST_PROPS_END,
+};
+static LV_STYLE_CONST_INIT(DASH_CLEAR_STYLE, DASH_CLEAR_PROPS);
+
+// Screen behind the gauges when there is no dash image
+static const lv_style_const_prop_t DASH_BLACK_PROPS[] = {
+    LV_STYLE_CONST_BG_COLOR(LV_COLOR_MAKE(0x00, 0x00, 0x00)),
+    LV_STYLE_CONST_BG_OPA(LV_OPA_COVER),
+    LV_STYLE_CONST_PROPS_END,
+};
+static LV_STYLE_CONST_INIT(DASH_BLACK_STYLE, DASH_BLACK_PROPS);
+
+// Invisible with its children, still takes input
+static const lv_style_const_prop_t DASH_INVISIBLE_PROPS[] = {
+    LV_STYLE_CONST_OPA(LV_OPA_TRANSP),
+    LV_STYLE_CONST_PROPS_END,
+};
+static LV_STYLE_CONST_INIT(DASH_INVISIBLE_STYLE, DASH_INVISIBLE_PROPS);
+
+#endif
@@ -0,0 +1,358 @@
+#pragma once
+#ifndef DASHBOARDUI_HPP
+#define DASHBOARDUI_HPP
+
+#include <array>
+#include <optional>
+#include <stdint.h>
+
+#include "esp_log.h"
+
+#include "BootProfile.hpp"
+#include "DamageMeter.hpp"
+#include "FrameCache.hpp"
+#include "Hal.hpp"
+#include "Latency.hpp"
+#include "LvglHeap.hpp"
+#include "MainDisplay.hpp"
+#include "StaleWatch.hpp"
+#include "VehicleState.hpp"
+#include "WarmStart.hpp"
+
+struct decode_stats_t {
+    uint32_t polls = 0;
+    uint64_t cycles = 0;
+    uint32_t max_cycles = 0;
+};
+
+// The UI side of the pipeline, the same on the device and in the host build. Moves the gauges whose signal changed at
+// each display refresh and greys out the ones gone silent. Create after hal::DisplayInit().
+class DashboardUi {
+  private:
+    SignalReader reader;
+    std::optional<MainDisplay> dashboard;
+    DamageMeter damage;
+    LvglHeap lvgl_heap;
+    vehicle_state_t shown;
+    decode_stats_t decode_stats;
+    LatencyTable &latency;
+    WarmStart &warm_start;
+    BootProfile &boot;
+    int64_t decoded_us = 0;                             // when this refresh's poll finished
+    std::array<int64_t, SIGNAL_COUNT> applied_rx_us{}; // reception time of the values applied at this refresh's start
+    StaleWatch stale_watch{GAUGE_STALE_AFTER_MS};
+    uint32_t valid_signals = 0;                        // bit per Signal showing a live or restored value
+    int64_t restored_us = 0;                           // when the restored values were painted
+    bool sweeping = false;                             // startup sweep running, it owns the arcs
+    uint8_t build_step = 0;
+    bool built = false;
+    uint32_t last_skipped = 0;
+    int64_t last_log_us = hal::NowUs();
+
+  public:
+    static constexpr uint32_t displayed_signals =
+        SignalBit(Signal::RPM) | SignalBit(Signal::SPEED) | SignalBit(Signal::FUEL) | SignalBit(Signal::TEMP);
+
+    DashboardUi(const FrameCache &cache, LatencyTable &latency_table, WarmStart &warm, BootProfile &boot_profile)
+        : reader(cache, displayed_signals), latency(latency_table), warm_start(warm), boot(boot_profile) {}
+
+    // Runs in the LVGL task, the display registers a pointer to this object
+    DashboardUi(const DashboardUi &) = delete;
+    auto operator=(const DashboardUi &) -> DashboardUi & = delete;
+
+    // image: the dash image. prerendered: the dash with the scales baked in (the boot splash), used instead of image
+    // when there is one.
+    auto Setup(const lv_image_dsc_t *image, const lv_image_dsc_t *prerendered = nullptr) -> void {
+        hal::DisplayLock(1);
+        damage.Attach(lv_display_get_default());
+        if (prerendered) {
+            dashboard.emplace(prerendered, true);
+        } else {
+            dashboard.emplace(image);
+        }
+        lv_display_add_event_cb(lv_display_get_default(), RefreshEvent, LV_EVENT_REFR_START, this);
+        lv_display_add_event_cb(lv_display_get_default(), RefreshEvent, LV_EVENT_REFR_READY, this);
+        lv_timer_create(BuildTimer, 0, this);
+        hal::DisplayUnlock();
+    }
+
+    // Take the display lock while reading. nullptr until the scene is built, or when the background came in
+    // pre-rendered.
+    [[nodiscard]] auto Background() const -> const lv_draw_buf_t * {
+        return built ? dashboard->Background() : nullptr;
+    }
+
+  private:
+    // Setup only puts up the background, the gauges are built one per LVGL timer run so frames keep going out while
+    // the scene comes together. One gauge per call, then the background cache and the start values. Returns true when
+    // the scene is complete.
+    auto BuildStep() -> bool {
+        switch (build_step++) {
+        case 0:
+            dashboard->SetupRpmArc();
+            return false;
+        case 1:
+            dashboard->SetupSpeedArc();
+            return false;
+        case 2:
+            dashboard->SetupFuelArc();
+            return false;
+        case 3:
+            dashboard->SetupTempArc();
+            return false;
+        default:
+            break;
+        }
+        dashboard->CacheBackground();
+        if (warm_start.Warm()) {
+            Restore();
+        } else {
+            dashboard->RunArcAnimation();
+            sweeping = true;
+        }
+        built = true;
+        boot.Mark(BootPhase::SCENE_BUILT);
+        return true;
+    }
+
+    static auto BuildTimer(lv_timer_t *timer) -> void {
+        auto *self = static_cast<DashboardUi *>(lv_timer_get_user_data(timer));
+        if (self->BuildStep()) {
+            lv_timer_delete(timer);
+            lv_timer_create(PollTimer, LV_DEF_REFR_PERIOD, self);
+            lv_timer_create(StaleTimer, STALE_CHECK_MS, self);
+            self->lvgl_heap.Settle();
+            self->lvgl_heap.LogSummary("BOOT", LvglHeap::Stats());
+        }
+    }
+
+    // LVGL skips refreshes while nothing is invalid, so this polls at the refresh period in between: a value that
+    // arrives on an idle screen invalidates its gauge, which brings the next refresh.
+    static auto PollTimer(lv_timer_t *timer) -> void {
+        static_cast<DashboardUi *>(lv_timer_get_user_data(timer))->Update();
+    }
+
+    // A timer of its own rather than the refresh, so a silent bus greys out an idle screen
+    static auto StaleTimer(lv_timer_t *timer) -> void {
+        static_cast<DashboardUi *>(lv_timer_get_user_data(timer))->CheckStale();
+    }
+
+    auto Show(Signal signal, int32_t value) -> void {
+        switch (signal) {
+        case Signal::RPM:
+            dashboard->SetRPMValue(value);
+            break;
+        case Signal::SPEED:
+            dashboard->SetSpeedValue(value);
+            break;
+        case Signal::FUEL:
+            dashboard->SetFuelValue(value);
+            break;
+        case Signal::TEMP:
+            dashboard->SetTempValue(value);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // After a warm reset the gauges start at the values WarmStart kept instead of sweeping. Live values replace them
+    // as frames arrive, and they go stale on the usual deadlines counted from here if none do.
+    auto Restore() -> void {
+        restored_us = hal::NowUs();
+        uint32_t restored = warm_start.RestoredSignals() & displayed_signals;
+        for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+            if (restored & (1U << i)) {
+                Show(static_cast<Signal>(i), warm_start.Restored(static_cast<Signal>(i)));
+            }
+        }
+        valid_signals = restored;
+    }
+
+    auto Apply(const vehicle_state_t &state, Signal signal) -> void {
+        if (!state.Changed(shown, signal)) {
+            return;
+        }
+        int64_t rx_us = state.RxTime(signal);
+        latency.Record(LatencyStage::DECODED, signal, decoded_us - rx_us);
+        Show(signal, state.Get(signal));
+        valid_signals |= SignalBit(signal);
+        latency.Record(LatencyStage::APPLIED, signal, hal::NowUs() - rx_us);
+        applied_rx_us[static_cast<size_t>(signal)] = rx_us;
+    }
+
+    auto SetStale(Signal signal, bool stale) -> void {
+        switch (signal) {
+        case Signal::RPM:
+            dashboard->SetRPMStale(stale);
+            break;
+        case Signal::SPEED:
+            dashboard->SetSpeedStale(stale);
+            break;
+        case Signal::FUEL:
+            dashboard->SetFuelStale(stale);
+            break;
+        case Signal::TEMP:
+            dashboard->SetTempStale(stale);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // A handful of compares per run, LVGL is only touched when a signal goes stale or comes back. The state is the
+    // one the poll timer last read, at most a refresh period old.
+    auto CheckStale() -> void {
+        int64_t now = hal::NowUs();
+        const vehicle_state_t &state = reader.State();
+        uint32_t flipped = stale_watch.Check(state, valid_signals, restored_us, now);
+        for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+            if (!(flipped & (1U << i))) {
+                continue;
+            }
+            auto signal = static_cast<Signal>(i);
+            bool stale = stale_watch.Stale() & SignalBit(signal);
+            SetStale(signal, stale);
+            int64_t rx_us = state.RxTime(signal);
+            if (stale && rx_us) {
+                ESP_LOGI("UI", "%s stale, nothing received for %lld ms", SIGNAL_NAMES[i], (now - rx_us) / 1000);
+            }
+        }
+    }
+
+    // Moves only the gauges whose value changed and mirrors the shown values into WarmStart. Returns true when a gauge
+    // was updated.
+    auto Update() -> bool {
+        // dashboard->HideOnTouch();
+        uint32_t start = hal::CycleCount();
+        bool changed = reader.Poll();
+        uint32_t cycles = hal::CycleCount() - start;
+        decode_stats.polls++;
+        decode_stats.cycles += cycles;
+        if (cycles > decode_stats.max_cycles) {
+            decode_stats.max_cycles = cycles;
+        }
+        if (sweeping && !dashboard->ArcAnimationRunning()) {
+            // The sweep ends at the minimum, put back what arrived meanwhile
+            sweeping = false;
+            for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+                if (valid_signals & (1U << i)) {
+                    Show(static_cast<Signal>(i), shown.value[i]);
+                }
+            }
+        }
+        if (!changed) {
+            return false;
+        }
+        decoded_us = hal::NowUs();
+
+        const vehicle_state_t &state = reader.State();
+        Apply(state, Signal::RPM);
+        Apply(state, Signal::SPEED);
+        Apply(state, Signal::FUEL);
+        Apply(state, Signal::TEMP);
+        shown = state;
+        warm_start.Mirror(state, displayed_signals);
+        return true;
+    }
+
+    auto Rendered() -> void {
+        int64_t now = hal::NowUs();
+        for (size_t signal = 0; signal < SIGNAL_COUNT; signal++) {
+            if (applied_rx_us[signal]) {
+                latency.Record(LatencyStage::DRAWN, static_cast<Signal>(signal), now - applied_rx_us[signal]);
+                applied_rx_us[signal] = 0;
+            }
+        }
+        if (!boot.Reached(BootPhase::ALL_LIVE)) {
+            MarkFirstFrames();
+        }
+    }
+
+    // Meaningful: the whole scene is on the panel. Valid: every gauge shows a live or restored value and the sweep is
+    // over. Live: every gauge shows a received value. On a cold boot the last two are the first frame after the sweep
+    // with frames for every gauge.
+    auto MarkFirstFrames() -> void {
+        const char *kind = warm_start.Warm() ? "warm" : "cold";
+        if (boot.Mark(BootPhase::FIRST_FRAME)) {
+            ESP_LOGI("BOOT", "%s boot", kind);
+            boot.LogSummary("BOOT");
+        }
+        if (valid_signals == displayed_signals && !sweeping && boot.Mark(BootPhase::FIRST_VALID)) {
+            ESP_LOGI("BOOT", "%s boot, first valid frame %lld ms after app start", kind,
+                     boot.At(BootPhase::FIRST_VALID) / 1000);
+        }
+        uint32_t live = 0;
+        for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+            live |= shown.rx_time_us[i] ? 1U << i : 0;
+        }
+        if (boot.Reached(BootPhase::FIRST_VALID) && (live & displayed_signals) == displayed_signals &&
+            boot.Mark(BootPhase::ALL_LIVE)) {
+            ESP_LOGI("BOOT", "%s boot, all gauges live %lld ms after app start", kind,
+                     boot.At(BootPhase::ALL_LIVE) / 1000);
+        }
+    }
+
+    // REFR_START runs in the LVGL task with the display lock held, so whatever arrived up to then is drawn by that
+    // refresh: a value waits at most one refresh period. Each applied value's RX time is followed through decode,
+    // apply and REFR_READY into the DECODED, APPLIED and DRAWN stages of the latency table.
+    static auto RefreshEvent(lv_event_t *event) -> void {
+        auto *self = static_cast<DashboardUi *>(lv_event_get_user_data(event));
+        if (lv_event_get_code(event) == LV_EVENT_REFR_START) {
+            // Nothing to move until every gauge exists
+            if (self->built) {
+                self->Update();
+            }
+        } else {
+            self->boot.Mark(BootPhase::FIRST_LVGL_FRAME);
+            if (self->built) {
+                self->Rendered();
+            }
+        }
+    }
+
+  public:
+    // Take the display lock while reading
+    [[nodiscard]] auto State() const -> const vehicle_state_t & {
+        return shown;
+    }
+
+    // Call from the UI task, rates are over the time since the previous call
+    auto LogStats() -> void {
+        // Written by the LVGL task, copied under the lock and logged outside it
+        hal::DisplayLock(0);
+        signal_reader_stats_t stats = reader.GetStats();
+        decode_stats_t decode = decode_stats;
+        display_update_stats_t updates = dashboard->GetUpdateStats();
+        damage_stats_t drawn = damage.GetStats();
+        lvgl_heap_stats_t heap = LvglHeap::Stats();
+        hal::DisplayUnlock();
+
+        uint32_t avg_cycles = stats.frames_decoded ? static_cast<uint32_t>(decode.cycles / stats.frames_decoded) : 0;
+        ESP_LOGI("UI", "polls: %lu decoded frames: %lu superseded: %lu avg cycles/frame: %lu max cycles/poll: %lu",
+                 decode.polls, stats.frames_decoded, stats.frames_superseded, avg_cycles, decode.max_cycles);
+
+        uint32_t skipped = updates.arc_skipped + updates.label_skipped;
+        int64_t now = hal::NowUs();
+        int64_t elapsed_ms = (now - last_log_us) / 1000;
+        uint32_t avoided_per_s =
+            elapsed_ms > 0 ? static_cast<uint32_t>((skipped - last_skipped) * 1000LL / elapsed_ms) : 0;
+        ESP_LOGI("UI", "arc updates: %lu skipped: %lu label updates: %lu skipped: %lu avoided invalidations/s: %lu",
+                 updates.arc_updates, updates.arc_skipped, updates.label_updates, updates.label_skipped,
+                 avoided_per_s);
+
+        uint32_t avg_pixels = drawn.frames ? static_cast<uint32_t>(drawn.pixels / drawn.frames) : 0;
+        uint32_t avg_render_us = drawn.frames ? static_cast<uint32_t>(drawn.render_us / drawn.frames) : 0;
+        ESP_LOGI("UI", "redrawn frames: %lu avg px/frame: %lu max px/frame: %lu avg draw us: %lu max draw us: %lu",
+                 drawn.frames, avg_pixels, drawn.max_pixels, avg_render_us, drawn.max_render_us);
+
+        lvgl_heap.LogSummary("UI", heap);
+
+        // Histograms have one writer each and are read unlocked, a line can be off by the frames recorded meanwhile
+        latency.LogSummary("UI");
+        last_skipped = skipped;
+        last_log_us = now;
+    }
+};
+
+#endif
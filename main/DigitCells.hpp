@@ -0,0 +1,70 @@
+#pragma once
+#ifndef DIGITCELLS_HPP
+#define DIGITCELLS_HPP
+
+#include <array>
+#include <stdint.h>
+
+struct cell_rect_t {
+    int32_t x1;
+    int32_t y1;
+    int32_t x2;
+    int32_t y2;
+};
+
+// Right-aligned decimal cells of a NumericReadout without the LVGL side: each cell holds the DigitAtlas index of its
+// digit or BLANK for a leading zero, and Set reports the cells that have to be redrawn.
+class DigitCells {
+  public:
+    static constexpr uint8_t MAX_DIGITS = 6;
+    static constexpr uint8_t BLANK = 0xFF;
+
+  private:
+    std::array<uint8_t, MAX_DIGITS> shown{};
+    uint8_t count;
+    int32_t max_value = 0;
+
+  public:
+    // digits is capped at MAX_DIGITS, every cell starts blank
+    explicit constexpr DigitCells(uint8_t digits) : count(digits < MAX_DIGITS ? digits : MAX_DIGITS) {
+        shown.fill(BLANK);
+        for (uint8_t i = 0; i < count; i++) {
+            max_value = max_value * 10 + 9;
+        }
+    }
+
+    // Shows value clamped to the cells, returns a bit per cell whose digit changed
+    constexpr auto Set(int32_t value) -> uint32_t {
+        value = value < 0 ? 0 : (value > max_value ? max_value : value);
+        uint32_t changed = 0;
+        for (int32_t cell = count - 1; cell >= 0; cell--) {
+            bool leading = value == 0 && cell != count - 1;
+            uint8_t digit = leading ? BLANK : static_cast<uint8_t>(value % 10);
+            value /= 10;
+            if (digit != shown[cell]) {
+                shown[cell] = digit;
+                changed |= 1U << cell;
+            }
+        }
+        return changed;
+    }
+
+    [[nodiscard]] constexpr auto Digit(uint8_t cell) const -> uint8_t {
+        return shown[cell];
+    }
+    [[nodiscard]] constexpr auto Count() const -> uint8_t {
+        return count;
+    }
+    [[nodiscard]] constexpr auto MaxValue() const -> int32_t {
+        return max_value;
+    }
+
+    // Area of cell in a readout whose top left corner is x, y: the prefix comes first, then the cells left to right
+    static constexpr auto CellRect(int32_t x, int32_t y, int32_t prefix_width, int32_t cell_width,
+                                   int32_t cell_height, uint8_t cell) -> cell_rect_t {
+        int32_t left = x + prefix_width + cell * cell_width;
+        return {left, y, left + cell_width - 1, y + cell_height - 1};
+    }
+};
+
+#endif
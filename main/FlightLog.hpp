@@ -0,0 +1,357 @@
+#pragma once
+#ifndef FLIGHTLOG_HPP
+#define FLIGHTLOG_HPP
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CanFrame.hpp"
+#include "CanSignals.hpp"
+
+// Binary CAN log written by FlightRecorder. The log is a sequence of self contained blocks, one per flash sector,
+// so the oldest block can be overwritten without breaking the ones after it.
+//
+// Block: flight_block_header_t followed by payload_bytes of records. A record is
+//   flags    dlc in bits 3:0, extd bit 4, rtr bit 5, literal ID bit 6, bus bit 7
+//   delta    zigzag varint, microseconds since the previous record (the first record is relative to base_timestamp_us)
+//   ID       literal: varint identifier, else one byte index into the block dictionary
+//   data     literal: dlc bytes, else a byte with bit i set for every data byte that differs from the last frame
+//            of that ID in this block, followed by those bytes
+// Every standard frame with a literal ID enters the block dictionary (up to DICT_SIZE entries), extended frames are
+// always literal. Decoders rebuild the dictionary the same way.
+namespace flight_log {
+
+static constexpr uint32_t MAGIC = 0x464E4143; // "CANF"
+static constexpr uint8_t VERSION = 1;
+static constexpr size_t BLOCK_SIZE = 4096;
+static constexpr size_t DICT_SIZE = 255;
+static constexpr size_t MAX_RECORD_SIZE = 1 + 10 + 5 + 8;
+static constexpr uint32_t KEY_COUNT = 2 * CAN_STD_ID_COUNT;
+
+static constexpr uint8_t FLAG_DLC = 0x0F;
+static constexpr uint8_t FLAG_EXTD = 0x10;
+static constexpr uint8_t FLAG_RTR = 0x20;
+static constexpr uint8_t FLAG_LITERAL = 0x40;
+static constexpr uint8_t FLAG_BUS = 0x80;
+
+struct flight_block_header_t {
+    uint32_t magic;
+    uint32_t sequence;
+    int64_t base_timestamp_us;
+    uint16_t frame_count;
+    uint16_t payload_bytes;
+    uint8_t version;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(flight_block_header_t) == 24);
+
+static constexpr size_t HEADER_SIZE = sizeof(flight_block_header_t);
+
+inline auto PutVarint(uint8_t *out, uint64_t value) -> size_t {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(value);
+    return n;
+}
+
+// Returns the bytes consumed, 0 if the varint runs past end
+inline auto GetVarint(const uint8_t *in, const uint8_t *end, uint64_t &value) -> size_t {
+    value = 0;
+    for (size_t n = 0; n < 10 && in + n < end; n++) {
+        value |= static_cast<uint64_t>(in[n] & 0x7F) << (7 * n);
+        if (!(in[n] & 0x80)) {
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+constexpr auto ZigZag(int64_t value) -> uint64_t {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+constexpr auto UnZigZag(uint64_t value) -> int64_t {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Dictionary of one block, shared by the encoder and decoder so both sides agree on the indices
+class BlockDictionary {
+  private:
+    std::array<uint8_t, KEY_COUNT> index{};
+    std::array<uint32_t, DICT_SIZE> keys{};
+    std::array<std::array<uint8_t, 8>, DICT_SIZE> last{};
+    size_t size = 0;
+
+  public:
+    auto Clear() -> void {
+        size = 0;
+    }
+
+    // Slots are validated against keys, so Clear() never has to touch the index
+    [[nodiscard]] auto Find(uint32_t key) const -> int {
+        uint8_t slot = index[key];
+        return slot < size && keys[slot] == key ? slot : -1;
+    }
+
+    auto Add(uint32_t key) -> int {
+        if (size == DICT_SIZE) {
+            return -1;
+        }
+        index[key] = static_cast<uint8_t>(size);
+        keys[size] = key;
+        last[size] = {};
+        return static_cast<int>(size++);
+    }
+
+    [[nodiscard]] auto Key(size_t slot) const -> uint32_t {
+        return keys[slot];
+    }
+    [[nodiscard]] auto Count() const -> size_t {
+        return size;
+    }
+    auto Last(size_t slot) -> std::array<uint8_t, 8> & {
+        return last[slot];
+    }
+};
+
+inline auto DictKey(const can_frame_t &frame) -> uint32_t {
+    return (frame.bus & 1) * CAN_STD_ID_COUNT + frame.identifier;
+}
+
+// Encodes frames into one block buffer of BLOCK_SIZE bytes
+class BlockEncoder {
+  private:
+    BlockDictionary dict;
+    uint8_t *block = nullptr;
+    size_t used = 0;
+    uint16_t frame_count = 0;
+    uint32_t sequence = 0;
+    int64_t base_timestamp_us = 0;
+    int64_t last_timestamp_us = 0;
+
+  public:
+    auto Begin(uint8_t *buffer, uint32_t block_sequence) -> void {
+        dict.Clear();
+        block = buffer;
+        used = HEADER_SIZE;
+        frame_count = 0;
+        sequence = block_sequence;
+    }
+
+    // Returns false without touching the block when the record does not fit, the block has to be finished then
+    auto Append(const can_frame_t &frame) -> bool {
+        uint8_t record[MAX_RECORD_SIZE];
+        uint8_t dlc = frame.dlc > 8 ? 8 : frame.dlc;
+        uint8_t data_len = frame.rtr ? 0 : dlc;
+        uint8_t flags = dlc | (frame.extd ? FLAG_EXTD : 0) | (frame.rtr ? FLAG_RTR : 0) | (frame.bus ? FLAG_BUS : 0);
+
+        if (frame_count == 0) {
+            base_timestamp_us = frame.timestamp_us;
+            last_timestamp_us = frame.timestamp_us;
+        }
+        size_t n = 1;
+        n += PutVarint(record + n, ZigZag(frame.timestamp_us - last_timestamp_us));
+
+        int slot = -1;
+        bool standard = !frame.extd && frame.identifier < CAN_STD_ID_COUNT;
+        if (standard) {
+            slot = dict.Find(DictKey(frame));
+        }
+        if (slot < 0) {
+            flags |= FLAG_LITERAL;
+            n += PutVarint(record + n, frame.identifier);
+            memcpy(record + n, frame.data, data_len);
+            n += data_len;
+        } else {
+            record[n++] = static_cast<uint8_t>(slot);
+            std::array<uint8_t, 8> &last = dict.Last(slot);
+            uint8_t &changed = record[n++];
+            changed = 0;
+            for (uint8_t i = 0; i < data_len; i++) {
+                if (frame.data[i] != last[i]) {
+                    changed |= 1U << i;
+                    record[n++] = frame.data[i];
+                }
+            }
+        }
+        record[0] = flags;
+
+        if (used + n > BLOCK_SIZE || frame_count == UINT16_MAX) {
+            return false;
+        }
+        memcpy(block + used, record, n);
+        used += n;
+        frame_count++;
+        last_timestamp_us = frame.timestamp_us;
+
+        if (standard) {
+            if (slot < 0) {
+                slot = dict.Add(DictKey(frame));
+            }
+            if (slot >= 0) {
+                std::array<uint8_t, 8> &last = dict.Last(slot);
+                last = {};
+                memcpy(last.data(), frame.data, data_len);
+            }
+        }
+        return true;
+    }
+
+    // Writes the header, returns the number of bytes used in the block
+    auto Finish() -> size_t {
+        flight_block_header_t header{};
+        header.magic = MAGIC;
+        header.sequence = sequence;
+        header.base_timestamp_us = base_timestamp_us;
+        header.frame_count = frame_count;
+        header.payload_bytes = static_cast<uint16_t>(used - HEADER_SIZE);
+        header.version = VERSION;
+        memcpy(block, &header, HEADER_SIZE);
+        return used;
+    }
+
+    [[nodiscard]] auto Frames() const -> uint16_t {
+        return frame_count;
+    }
+    [[nodiscard]] auto Used() const -> size_t {
+        return used;
+    }
+    [[nodiscard]] auto BaseTimestamp() const -> int64_t {
+        return base_timestamp_us;
+    }
+};
+
+inline auto ReadHeader(const uint8_t *block, flight_block_header_t &header) -> bool {
+    memcpy(&header, block, HEADER_SIZE);
+    return header.magic == MAGIC && header.version == VERSION && header.payload_bytes <= BLOCK_SIZE - HEADER_SIZE;
+}
+
+// Decodes one block a frame at a time, so a reader never has to hold a whole block of frames
+class BlockDecoder {
+  private:
+    BlockDictionary dict;
+    flight_block_header_t header{};
+    const uint8_t *in = nullptr;
+    const uint8_t *end = nullptr;
+    uint16_t remaining = 0;
+    int64_t timestamp_us = 0;
+    bool corrupt = false;
+
+  public:
+    auto Begin(const uint8_t *block) -> bool {
+        dict.Clear();
+        remaining = 0;
+        corrupt = false;
+        if (!ReadHeader(block, header)) {
+            return false;
+        }
+        in = block + HEADER_SIZE;
+        end = in + header.payload_bytes;
+        remaining = header.frame_count;
+        timestamp_us = header.base_timestamp_us;
+        return true;
+    }
+
+    // Returns false at the end of the block or on a truncated record, Corrupt() tells the two apart
+    auto Next(can_frame_t &frame) -> bool {
+        if (remaining == 0 || corrupt) {
+            return false;
+        }
+        if (!DecodeRecord(frame)) {
+            corrupt = true;
+            return false;
+        }
+        remaining--;
+        return true;
+    }
+
+    [[nodiscard]] auto Corrupt() const -> bool {
+        return corrupt;
+    }
+    [[nodiscard]] auto Header() const -> const flight_block_header_t & {
+        return header;
+    }
+
+  private:
+    auto DecodeRecord(can_frame_t &frame) -> bool {
+        if (in >= end) {
+            return false;
+        }
+        uint8_t flags = *in++;
+        uint64_t value = 0;
+        size_t n = GetVarint(in, end, value);
+        if (!n) {
+            return false;
+        }
+        in += n;
+        timestamp_us += UnZigZag(value);
+
+        frame = {};
+        frame.timestamp_us = timestamp_us;
+        frame.dlc = flags & FLAG_DLC;
+        frame.extd = flags & FLAG_EXTD;
+        frame.rtr = flags & FLAG_RTR;
+        frame.bus = (flags & FLAG_BUS) ? 1 : 0;
+        uint8_t data_len = frame.rtr ? 0 : (frame.dlc > 8 ? 8 : frame.dlc);
+
+        int slot = -1;
+        if (flags & FLAG_LITERAL) {
+            n = GetVarint(in, end, value);
+            if (!n || in + n + data_len > end) {
+                return false;
+            }
+            in += n;
+            frame.identifier = static_cast<uint32_t>(value);
+            memcpy(frame.data, in, data_len);
+            in += data_len;
+            if (!frame.extd && frame.identifier < CAN_STD_ID_COUNT) {
+                slot = dict.Add(DictKey(frame));
+            }
+        } else {
+            if (in + 2 > end || *in >= dict.Count()) {
+                return false;
+            }
+            slot = *in++;
+            frame.identifier = dict.Key(slot) % CAN_STD_ID_COUNT;
+            uint8_t changed = *in++;
+            const std::array<uint8_t, 8> &last = dict.Last(slot);
+            memcpy(frame.data, last.data(), data_len);
+            for (uint8_t b = 0; b < data_len; b++) {
+                if (changed & (1U << b)) {
+                    if (in >= end) {
+                        return false;
+                    }
+                    frame.data[b] = *in++;
+                }
+            }
+        }
+        if (slot >= 0) {
+            std::array<uint8_t, 8> &last = dict.Last(slot);
+            last = {};
+            memcpy(last.data(), frame.data, data_len);
+        }
+        return true;
+    }
+};
+
+// Calls handler(const can_frame_t &) for every frame in a block, returns false for an invalid or truncated block
+template <typename Handler>
+auto DecodeBlock(const uint8_t *block, Handler &&handler) -> bool {
+    BlockDecoder decoder;
+    if (!decoder.Begin(block)) {
+        return false;
+    }
+    can_frame_t frame;
+    while (decoder.Next(frame)) {
+        handler(static_cast<const can_frame_t &>(frame));
+    }
+    return !decoder.Corrupt();
+}
+
+} // namespace flight_log
+
+#endif
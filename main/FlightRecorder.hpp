@@ -0,0 +1,233 @@
+#pragma once
+#ifndef FLIGHTRECORDER_HPP
+#define FLIGHTRECORDER_HPP
+
+#include <array>
+#include <atomic>
+#include <stdint.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "CanFrame.hpp"
+#include "FlightLog.hpp"
+#include "TraceSource.hpp"
+
+struct flight_recorder_stats_t {
+    uint32_t frames = 0;
+    uint32_t frames_dropped = 0; // both block buffers were waiting on flash
+    uint32_t blocks_written = 0;
+    uint32_t write_errors = 0;
+    uint64_t bytes = 0; // encoded bytes including block headers, excluding the unused tail of each sector
+    uint32_t blocks_closed = 0;
+    uint32_t sectors = 0;
+
+    // Encoded size per frame in hundredths of a byte
+    [[nodiscard]] auto BytesPerFrameX100() const -> uint32_t {
+        return frames ? static_cast<uint32_t>(bytes * 100 / frames) : 0;
+    }
+    // Frames the partition holds before wrapping, at the flash use per frame so far (sector tails included)
+    [[nodiscard]] auto HistoryFrames() const -> uint64_t {
+        return blocks_closed ? uint64_t{sectors} * frames / blocks_closed : 0;
+    }
+};
+
+// Always-on recorder of every received frame into the storage partition, which is used as a ring of sectors.
+// The CAN task encodes frames straight into one of two sector sized buffers, which costs a few hundred cycles and
+// never waits. A full buffer is handed to a low priority task that erases and programs its sector while the CAN
+// task fills the other buffer. When both buffers are still waiting on flash, frames are dropped and counted.
+class FlightRecorder {
+  private:
+    static constexpr int64_t max_block_age_us = 2000000; // bounds what a power cut can lose
+
+    enum BufferState : uint8_t {
+        FREE = 0,
+        FILLING = 1,
+        FULL = 2
+    };
+
+    struct block_buffer_t {
+        alignas(4) std::array<uint8_t, flight_log::BLOCK_SIZE> bytes;
+        std::atomic<uint8_t> state{FREE};
+        size_t used = 0;
+        uint32_t sequence = 0;
+    };
+
+    const esp_partition_t *partition{};
+    uint32_t sector_count = 0;
+    uint32_t next_sector = 0;
+    uint32_t next_sequence = 0;
+
+    std::array<block_buffer_t, 2> buffers;
+    block_buffer_t *active{};
+    flight_log::BlockEncoder encoder;
+    TaskHandle_t task{};
+
+    flight_recorder_stats_t stats{};
+    std::atomic<uint32_t> blocks_written{0};
+    std::atomic<uint32_t> write_errors{0};
+
+    // Continues after the newest block already in the partition, so a reboot does not overwrite recent history
+    auto FindWritePosition() -> void {
+        uint32_t newest_sequence = 0;
+        bool found = false;
+        for (uint32_t sector = 0; sector < sector_count; sector++) {
+            uint8_t raw[flight_log::HEADER_SIZE];
+            flight_log::flight_block_header_t header;
+            if (esp_partition_read(partition, sector * flight_log::BLOCK_SIZE, raw, sizeof(raw)) != ESP_OK ||
+                !flight_log::ReadHeader(raw, header)) {
+                continue;
+            }
+            if (!found || static_cast<int32_t>(header.sequence - newest_sequence) > 0) {
+                newest_sequence = header.sequence;
+                next_sector = (sector + 1) % sector_count;
+                found = true;
+            }
+        }
+        next_sequence = found ? newest_sequence + 1 : 0;
+    }
+
+    auto WriteBlock(block_buffer_t &buffer) -> void {
+        uint32_t offset = next_sector * flight_log::BLOCK_SIZE;
+        next_sector = (next_sector + 1) % sector_count;
+
+        // The header goes in last, a block cut short by a reset is never seen as valid
+        esp_err_t err = esp_partition_erase_range(partition, offset, flight_log::BLOCK_SIZE);
+        if (err == ESP_OK) {
+            err = esp_partition_write(partition, offset + flight_log::HEADER_SIZE,
+                                      buffer.bytes.data() + flight_log::HEADER_SIZE,
+                                      buffer.used - flight_log::HEADER_SIZE);
+        }
+        if (err == ESP_OK) {
+            err = esp_partition_write(partition, offset, buffer.bytes.data(), flight_log::HEADER_SIZE);
+        }
+        if (err == ESP_OK) {
+            blocks_written.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            write_errors.fetch_add(1, std::memory_order_relaxed);
+            ESP_LOGE("CAN REC", "Failed to write block at 0x%06lx ERR: %s", offset, esp_err_to_name(err));
+        }
+    }
+
+    auto OldestFull() -> block_buffer_t * {
+        block_buffer_t *oldest = nullptr;
+        for (block_buffer_t &buffer : buffers) {
+            if (buffer.state.load(std::memory_order_acquire) == FULL &&
+                (!oldest || static_cast<int32_t>(buffer.sequence - oldest->sequence) < 0)) {
+                oldest = &buffer;
+            }
+        }
+        return oldest;
+    }
+
+    static void writerTask(void *task_param) {
+        auto *self = static_cast<FlightRecorder *>(task_param);
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            // Oldest block first so sectors stay in sequence order
+            while (block_buffer_t *buffer = self->OldestFull()) {
+                self->WriteBlock(*buffer);
+                buffer->state.store(FREE, std::memory_order_release);
+            }
+        }
+    }
+
+    auto CloseActive() -> void {
+        active->used = encoder.Finish();
+        stats.bytes += active->used;
+        stats.blocks_closed++;
+        active->state.store(FULL, std::memory_order_release);
+        active = nullptr;
+        xTaskNotifyGive(task);
+    }
+
+    auto OpenBuffer() -> bool {
+        for (block_buffer_t &buffer : buffers) {
+            if (buffer.state.load(std::memory_order_acquire) == FREE) {
+                buffer.state.store(FILLING, std::memory_order_relaxed);
+                active = &buffer;
+                buffer.sequence = next_sequence;
+                encoder.Begin(buffer.bytes.data(), next_sequence++);
+                return true;
+            }
+        }
+        return false;
+    }
+
+  public:
+    // Opens the partition and starts the writer task, a missing partition leaves the recorder disabled
+    auto Start(const char *partition_label, UBaseType_t priority, BaseType_t core) -> bool {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label);
+        if (!partition) {
+            ESP_LOGE("CAN REC", "No partition named %s, flight recorder off", partition_label);
+            return false;
+        }
+        sector_count = partition->size / flight_log::BLOCK_SIZE;
+        stats.sectors = sector_count;
+        FindWritePosition();
+        ESP_LOGI("CAN REC", "Recording to %s, %lu sectors, resuming at sector %lu sequence %lu", partition_label,
+                 sector_count, next_sector, next_sequence);
+        xTaskCreatePinnedToCore(writerTask, "CAN REC TASK", 3072, this, priority, &task, core);
+        return true;
+    }
+
+    // Called from the CAN task for every received frame, never blocks
+    auto Record(const can_frame_t &frame) -> void {
+        if (!task) {
+            return;
+        }
+        if (active && frame.timestamp_us - encoder.BaseTimestamp() > max_block_age_us && encoder.Frames()) {
+            CloseActive();
+        }
+        if (!active && !OpenBuffer()) {
+            stats.frames_dropped++;
+            return;
+        }
+        if (!encoder.Append(frame)) {
+            CloseActive();
+            if (!OpenBuffer() || !encoder.Append(frame)) {
+                stats.frames_dropped++;
+                return;
+            }
+        }
+        stats.frames++;
+    }
+
+    [[nodiscard]] auto GetStats() const -> flight_recorder_stats_t {
+        flight_recorder_stats_t snapshot = stats;
+        snapshot.blocks_written = blocks_written.load(std::memory_order_relaxed);
+        snapshot.write_errors = write_errors.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    // Call from the CAN task, the counters it owns are not atomic
+    auto LogStats() const -> void {
+        flight_recorder_stats_t snapshot = GetStats();
+        uint32_t bytes_x100 = snapshot.BytesPerFrameX100();
+        uint64_t history_frames = snapshot.HistoryFrames();
+        ESP_LOGI("CAN REC", "frames: %lu dropped: %lu blocks: %lu errors: %lu bytes/frame: %lu.%02lu history: %llu frames",
+                 snapshot.frames, snapshot.frames_dropped, snapshot.blocks_written, snapshot.write_errors,
+                 bytes_x100 / 100, bytes_x100 % 100, history_frames);
+    }
+};
+
+// Reads a FlightRecorder partition back for FlightLogSource, don't replay a partition the recorder is writing to
+class FlightLogPartition : public FlightBlockStore {
+  private:
+    const esp_partition_t *partition{};
+
+  public:
+    explicit FlightLogPartition(const char *partition_label)
+        : partition(esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label)) {}
+
+    auto BlockCount() -> uint32_t override {
+        return partition ? partition->size / flight_log::BLOCK_SIZE : 0;
+    }
+    auto ReadBlock(uint32_t index, uint8_t *out, size_t len) -> bool override {
+        return partition && esp_partition_read(partition, index * flight_log::BLOCK_SIZE, out, len) == ESP_OK;
+    }
+};
+
+#endif
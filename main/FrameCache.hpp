@@ -0,0 +1,47 @@
+#pragma once
+#ifndef FRAMECACHE_HPP
+#define FRAMECACHE_HPP
+
+#include <array>
+#include <stdint.h>
+#include <string.h>
+
+#include "CanFrame.hpp"
+#include "CanSignals.hpp"
+#include "SeqLock.hpp"
+
+struct can_slot_t {
+    int64_t rx_time_us;
+    uint8_t dlc;
+    uint8_t data[8];
+};
+
+// Last raw frame of every standard ID on every bus, direct-mapped by CanKey(bus, ID). The RX path only copies the
+// payload in, consumers decode it later. Each slot is its own seqlock, so a slot generation is the arrival count.
+class FrameCache {
+  private:
+    std::array<SeqLock<can_slot_t>, CAN_KEY_COUNT> slots;
+
+  public:
+    auto Store(const can_frame_t &frame) -> void {
+        if (frame.extd || frame.identifier >= CAN_STD_ID_COUNT || frame.bus >= CAN_BUS_COUNT) {
+            return;
+        }
+        slots[CanKey(frame.bus, frame.identifier)].Write([&](can_slot_t &slot) {
+            slot.rx_time_us = frame.timestamp_us;
+            slot.dlc = frame.dlc > 8 ? 8 : frame.dlc;
+            memcpy(slot.data, frame.data, 8);
+        });
+    }
+
+    // Copies the latest frame for key and returns its generation, 0 if it has never been seen
+    auto Read(uint32_t key, can_slot_t &out) const -> uint32_t {
+        return slots[key].Read(out);
+    }
+
+    [[nodiscard]] auto Generation(uint32_t key) const -> uint32_t {
+        return slots[key].Generation();
+    }
+};
+
+#endif
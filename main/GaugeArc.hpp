@@ -0,0 +1,353 @@
+#pragma once
+#ifndef GAUGEARC_HPP
+#define GAUGEARC_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+#include "esp_log.h"
+#include "lvgl.h"
+
+// 1 puts every GaugeArc on a stock lv_arc whatever its config says, to compare DamageMeter numbers against
+#ifndef DASH_STOCK_ARC
+#define DASH_STOCK_ARC 0
+#endif
+
+enum class GaugeRenderer : uint8_t {
+    STOCK = 0,  // lv_arc
+    ARC = 1,    // lv_draw_arc of the indicator, swept-sector invalidation
+    SPRITE = 2, // full-scale arc rendered once, revealed by angle, swept-sector invalidation
+};
+
+struct gauge_arc_config_t {
+    int32_t size = 0;
+    int32_t rotation = 0;
+    int32_t span = 0; // degrees, clockwise from rotation
+    int32_t width = 0;
+    uint32_t color = 0;
+    int32_t min = 0;
+    int32_t max = 100;
+    bool reverse = false; // indicator grows from the far end of the span
+    GaugeRenderer renderer = GaugeRenderer::ARC;
+    bool gradient = false;       // SPRITE only, shades from color at the start of the span to gradient_color
+    uint32_t gradient_color = 0; // at its end
+    const lv_style_t *indicator_style = nullptr; // STOCK only, a shared indicator style used instead of width and color
+};
+
+// lv_arc background track, hidden: the dash image has its own
+static const lv_style_const_prop_t GAUGE_ARC_TRACK_PROPS[] = {
+    LV_STYLE_CONST_ARC_OPA(LV_OPA_TRANSP),
+    LV_STYLE_CONST_PROPS_END,
+};
+static LV_STYLE_CONST_INIT(GAUGE_ARC_TRACK_STYLE, GAUGE_ARC_TRACK_PROPS);
+
+// Indicator-only arc gauge. A value change invalidates a few rectangles hugging the annular sector between the old
+// and the new indicator edge, where lv_arc invalidates the bounding box of the whole changed arc segment, so the
+// background image and scales behind the gauge are only redrawn where the edge actually swept.
+//
+// The SPRITE renderer draws the full-scale arc with anti-aliasing once into an ARGB8888 sprite, cropped to the
+// span's bounding box. A second buffer of the same size is what gets drawn, and a value change copies or clears only
+// the swept pixels of it depending on which side of the indicator edge they fall. Per frame that is an image blend
+// instead of the arc coverage computation. It costs two sprite buffers in PSRAM (about 0.8 MB for the RPM arc) and
+// needs a span below 180 degrees.
+class GaugeArc {
+  private:
+    lv_obj_t *obj;
+    gauge_arc_config_t config;
+    int32_t value;
+    int32_t edge; // absolute angle of the moving end of the indicator
+    lv_draw_buf_t *sprite{};
+    lv_draw_buf_t *shown{};
+    lv_area_t sprite_area{}; // in object coordinates
+    lv_opa_t opa = LV_OPA_COVER;
+
+    static constexpr int32_t SECTOR_STEP_DEG = 12;
+    static constexpr int32_t MAX_SECTOR_RECTS = 4; // LVGL falls back to a full screen redraw past LV_INV_BUF_SIZE
+    static constexpr int32_t AA_MARGIN = 2;
+
+    // Moving edge of the indicator for value, whole degrees like lv_arc
+    [[nodiscard]] auto EdgeAngle(int32_t v) const -> int32_t {
+        int32_t offset = config.reverse ? lv_map(v, config.min, config.max, config.span, 0)
+                                        : lv_map(v, config.min, config.max, 0, config.span);
+        return config.rotation + offset;
+    }
+
+    [[nodiscard]] auto Center() const -> lv_point_t {
+        lv_area_t coords;
+        lv_obj_get_coords(obj, &coords);
+        return {coords.x1 + config.size / 2, coords.y1 + config.size / 2};
+    }
+
+    static auto Extend(lv_area_t &area, lv_point_t center, int32_t radius, int32_t angle) -> void {
+        int32_t x = center.x + ((lv_trigo_cos(static_cast<int16_t>(angle % 360)) * radius) >> LV_TRIGO_SHIFT);
+        int32_t y = center.y + ((lv_trigo_sin(static_cast<int16_t>(angle % 360)) * radius) >> LV_TRIGO_SHIFT);
+        area.x1 = std::min(area.x1, x);
+        area.y1 = std::min(area.y1, y);
+        area.x2 = std::max(area.x2, x);
+        area.y2 = std::max(area.y2, y);
+    }
+
+    // Bounding box of the ring segment from a to b (a < b), the outer circle's extremes count when the segment
+    // crosses an axis
+    [[nodiscard]] auto SectorArea(lv_point_t center, int32_t a, int32_t b) const -> lv_area_t {
+        int32_t outer = config.size / 2;
+        int32_t inner = outer - config.width;
+        lv_area_t area{LV_COORD_MAX, LV_COORD_MAX, -LV_COORD_MAX, -LV_COORD_MAX};
+        Extend(area, center, outer, a);
+        Extend(area, center, outer, b);
+        Extend(area, center, inner, a);
+        Extend(area, center, inner, b);
+        for (int32_t axis = (a / 90 + 1) * 90; axis < b; axis += 90) {
+            Extend(area, center, outer, axis);
+        }
+        area.x1 -= AA_MARGIN;
+        area.y1 -= AA_MARGIN;
+        area.x2 += AA_MARGIN;
+        area.y2 += AA_MARGIN;
+        return area;
+    }
+
+    // Calls fn with each rectangle covering the sweep between two edge angles, centered on center
+    template <typename Fn>
+    auto ForEachSweepArea(lv_point_t center, int32_t from, int32_t to, Fn &&fn) const -> void {
+        int32_t a = std::min(from, to);
+        int32_t b = std::max(from, to);
+        int32_t rects = std::clamp((b - a + SECTOR_STEP_DEG - 1) / SECTOR_STEP_DEG, 1, MAX_SECTOR_RECTS);
+        for (int32_t i = 0; i < rects; i++) {
+            lv_area_t area = SectorArea(center, a + (b - a) * i / rects, a + (b - a) * (i + 1) / rects);
+            fn(area);
+        }
+    }
+
+    auto InvalidateSweep(int32_t from, int32_t to) -> void {
+        ForEachSweepArea(Center(), from, to, [this](const lv_area_t &area) { lv_obj_invalidate_area(obj, &area); });
+    }
+
+    auto CreateSprite() -> bool {
+        int32_t half = config.size / 2;
+        lv_area_t bounds{0, 0, config.size - 1, config.size - 1};
+        lv_area_t span_area = SectorArea({half, half}, config.rotation, config.rotation + config.span);
+        if (config.span >= 180 || !lv_area_intersect(&sprite_area, &span_area, &bounds)) {
+            return false;
+        }
+        auto width = static_cast<uint32_t>(lv_area_get_width(&sprite_area));
+        auto height = static_cast<uint32_t>(lv_area_get_height(&sprite_area));
+        sprite = lv_draw_buf_create(width, height, LV_COLOR_FORMAT_ARGB8888, LV_STRIDE_AUTO);
+        shown = lv_draw_buf_create(width, height, LV_COLOR_FORMAT_ARGB8888, LV_STRIDE_AUTO);
+        if (!sprite || !shown) {
+            if (sprite) {
+                lv_draw_buf_destroy(sprite);
+            }
+            if (shown) {
+                lv_draw_buf_destroy(shown);
+            }
+            sprite = shown = nullptr;
+            return false;
+        }
+
+        lv_obj_t *canvas = lv_canvas_create(lv_obj_get_parent(obj));
+        lv_canvas_set_draw_buf(canvas, sprite);
+        lv_canvas_fill_bg(canvas, lv_color_black(), LV_OPA_TRANSP);
+        lv_layer_t layer;
+        lv_canvas_init_layer(canvas, &layer);
+        lv_draw_arc_dsc_t dsc;
+        lv_draw_arc_dsc_init(&dsc);
+        dsc.color = lv_color_hex(config.color);
+        dsc.width = config.width;
+        dsc.rounded = false;
+        dsc.center = {half - sprite_area.x1, half - sprite_area.y1};
+        dsc.radius = half;
+        dsc.start_angle = config.rotation;
+        dsc.end_angle = config.rotation + config.span;
+        lv_draw_arc(&layer, &dsc);
+        lv_canvas_finish_layer(canvas, &layer);
+        lv_obj_delete(canvas);
+
+        if (config.gradient) {
+            ShadeSprite();
+        }
+        lv_draw_buf_clear(shown, nullptr);
+        return true;
+    }
+
+    // Straight alpha ARGB8888, so recoloring keeps the anti-aliased edges
+    auto ShadeSprite() -> void {
+        lv_color32_t from = lv_color_to_32(lv_color_hex(config.color), LV_OPA_COVER);
+        lv_color32_t to = lv_color_to_32(lv_color_hex(config.gradient_color), LV_OPA_COVER);
+        float cx = static_cast<float>(config.size / 2 - sprite_area.x1);
+        float cy = static_cast<float>(config.size / 2 - sprite_area.y1);
+        for (uint32_t y = 0; y < sprite->header.h; y++) {
+            auto *row = reinterpret_cast<lv_color32_t *>(sprite->data + y * sprite->header.stride);
+            for (uint32_t x = 0; x < sprite->header.w; x++) {
+                if (!row[x].alpha) {
+                    continue;
+                }
+                float angle = std::atan2(static_cast<float>(y) - cy, static_cast<float>(x) - cx) * 180.0F / static_cast<float>(M_PI);
+                float t = std::fmod(angle - static_cast<float>(config.rotation) + 720.0F, 360.0F) /
+                          static_cast<float>(config.span);
+                t = std::clamp(t, 0.0F, 1.0F);
+                row[x].red = static_cast<uint8_t>(from.red + (to.red - from.red) * t);
+                row[x].green = static_cast<uint8_t>(from.green + (to.green - from.green) * t);
+                row[x].blue = static_cast<uint8_t>(from.blue + (to.blue - from.blue) * t);
+            }
+        }
+    }
+
+    // Copies the sprite into the shown buffer where a pixel now sits on the lit side of the edge and clears it
+    // where it does not, over the swept pixels only. With spans below 180 degrees the side of the edge ray is the
+    // sign of a cross product.
+    auto RevealSweep(int32_t from, int32_t to) -> void {
+        lv_point_t center{config.size / 2 - sprite_area.x1, config.size / 2 - sprite_area.y1};
+        int32_t dx = lv_trigo_cos(static_cast<int16_t>(edge % 360));
+        int32_t dy = lv_trigo_sin(static_cast<int16_t>(edge % 360));
+        lv_area_t bounds{0, 0, static_cast<int32_t>(sprite->header.w) - 1, static_cast<int32_t>(sprite->header.h) - 1};
+        ForEachSweepArea(center, from, to, [&](const lv_area_t &swept) {
+            lv_area_t area;
+            if (!lv_area_intersect(&area, &swept, &bounds)) {
+                return;
+            }
+            for (int32_t y = area.y1; y <= area.y2; y++) {
+                auto *src = reinterpret_cast<const lv_color32_t *>(sprite->data + y * sprite->header.stride);
+                auto *dst = reinterpret_cast<lv_color32_t *>(shown->data + y * shown->header.stride);
+                int32_t py = y - center.y;
+                for (int32_t x = area.x1; x <= area.x2; x++) {
+                    int32_t cross = dx * py - dy * (x - center.x);
+                    bool lit = config.reverse ? cross > 0 : cross < 0;
+                    dst[x] = lit ? src[x] : lv_color32_t{};
+                }
+            }
+        });
+        lv_image_cache_drop(shown);
+    }
+
+    static auto DrawEvent(lv_event_t *event) -> void {
+        auto *self = static_cast<GaugeArc *>(lv_event_get_user_data(event));
+        if (self->config.renderer == GaugeRenderer::SPRITE) {
+            lv_area_t coords;
+            lv_obj_get_coords(self->obj, &coords);
+            lv_area_t area{coords.x1 + self->sprite_area.x1, coords.y1 + self->sprite_area.y1,
+                           coords.x1 + self->sprite_area.x2, coords.y1 + self->sprite_area.y2};
+            lv_draw_image_dsc_t dsc;
+            lv_draw_image_dsc_init(&dsc);
+            dsc.src = self->shown;
+            dsc.opa = self->opa;
+            lv_draw_image(lv_event_get_layer(event), &dsc, &area);
+            return;
+        }
+        int32_t start = self->config.reverse ? self->edge : self->config.rotation;
+        int32_t end = self->config.reverse ? self->config.rotation + self->config.span : self->edge;
+        if (start == end) {
+            return;
+        }
+        lv_draw_arc_dsc_t dsc;
+        lv_draw_arc_dsc_init(&dsc);
+        dsc.color = lv_color_hex(self->config.color);
+        dsc.opa = self->opa;
+        dsc.width = self->config.width;
+        dsc.rounded = false;
+        dsc.center = self->Center();
+        dsc.radius = self->config.size / 2;
+        dsc.start_angle = start;
+        dsc.end_angle = end;
+        lv_draw_arc(lv_event_get_layer(event), &dsc);
+    }
+
+  public:
+    GaugeArc(lv_obj_t *parent, const gauge_arc_config_t &config)
+        : config(config), value(config.min), edge(EdgeAngle(value)) {
+#if DASH_STOCK_ARC
+        this->config.renderer = GaugeRenderer::STOCK;
+#endif
+        if (this->config.renderer == GaugeRenderer::STOCK) {
+            obj = lv_arc_create(parent);
+            lv_obj_set_size(obj, config.size, config.size);
+            lv_arc_set_rotation(obj, config.rotation);
+            lv_arc_set_bg_angles(obj, 0, config.span);
+            lv_arc_set_range(obj, config.min, config.max);
+            lv_arc_set_mode(obj, config.reverse ? LV_ARC_MODE_REVERSE : LV_ARC_MODE_NORMAL);
+            lv_arc_set_value(obj, value);
+            lv_obj_remove_style(obj, nullptr, LV_PART_KNOB);
+            lv_obj_add_style(obj, &GAUGE_ARC_TRACK_STYLE, LV_PART_MAIN);
+            if (config.indicator_style) {
+                lv_obj_add_style(obj, config.indicator_style, LV_PART_INDICATOR);
+            } else {
+                lv_obj_set_style_arc_width(obj, config.width, LV_PART_INDICATOR);
+                lv_obj_set_style_arc_color(obj, lv_color_hex(config.color), LV_PART_INDICATOR);
+                lv_obj_set_style_arc_rounded(obj, false, LV_PART_INDICATOR);
+            }
+        } else {
+            obj = lv_obj_create(parent);
+            lv_obj_remove_style_all(obj);
+            lv_obj_set_size(obj, config.size, config.size);
+            lv_obj_add_event_cb(obj, DrawEvent, LV_EVENT_DRAW_MAIN, this);
+        }
+        lv_obj_center(obj);
+        lv_obj_remove_flag(obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+
+        if (this->config.renderer == GaugeRenderer::SPRITE && !CreateSprite()) {
+            ESP_LOGE("UI", "Gauge sprite unavailable (span %ld, no memory?), drawing the arc instead", config.span);
+            this->config.renderer = GaugeRenderer::ARC;
+        }
+    }
+
+    // The draw callback points at this object
+    GaugeArc(const GaugeArc &) = delete;
+    auto operator=(const GaugeArc &) -> GaugeArc & = delete;
+
+    // Returns false without touching LVGL when the indicator would not move
+    auto SetValue(int32_t v) -> bool {
+        v = std::clamp(v, config.min, config.max);
+        int32_t new_edge = EdgeAngle(v);
+        value = v;
+        if (new_edge == edge) {
+            return false;
+        }
+        int32_t old_edge = edge;
+        edge = new_edge;
+        switch (config.renderer) {
+        case GaugeRenderer::STOCK:
+            lv_arc_set_value(obj, v);
+            break;
+        case GaugeRenderer::SPRITE:
+            RevealSweep(old_edge, new_edge);
+            InvalidateSweep(old_edge, new_edge);
+            break;
+        default:
+            InvalidateSweep(old_edge, new_edge);
+            break;
+        }
+        return true;
+    }
+
+    // Fades the indicator, for a value that is no longer current. Redraws the whole gauge, meant for rare changes.
+    auto SetOpacity(lv_opa_t new_opa) -> void {
+        if (new_opa == opa) {
+            return;
+        }
+        opa = new_opa;
+        if (config.renderer == GaugeRenderer::STOCK) {
+            lv_obj_set_style_arc_opa(obj, opa, LV_PART_INDICATOR);
+        } else {
+            lv_obj_invalidate(obj);
+        }
+    }
+
+    [[nodiscard]] auto Value() const -> int32_t {
+        return value;
+    }
+    [[nodiscard]] auto Min() const -> int32_t {
+        return config.min;
+    }
+    [[nodiscard]] auto Max() const -> int32_t {
+        return config.max;
+    }
+    [[nodiscard]] auto Renderer() const -> GaugeRenderer {
+        return config.renderer;
+    }
+    [[nodiscard]] auto Obj() const -> lv_obj_t * {
+        return obj;
+    }
+};
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+#ifndef HAL_HPP
+#define HAL_HPP
+
+// Platform layer for the code that also runs in the Linux host build (host/). Everything in namespace hal:
+//   NowUs() -> int64_t                 monotonic time in microseconds
+//   SleepMs(ms)                        blocks the calling task
+//   CycleCount() -> uint32_t           free running CPU cycle counter, for short measurements only
+//   TaskCreate(fn, name, stack, arg, priority, core) -> bool
+// and where LVGL is available
+//   DisplayInit(background)            brings up the panel (or the host window / headless display) and LVGL
+//   DisplayLock(timeout_ms) -> bool    LVGL lock, timeout 0 waits forever like bsp_display_lock
+//   DisplayUnlock()
+// The TWAI driver, the flight recorder partition, the gateway and PanelInit() / PanelShow(image), which put a frame on
+// the panel before LVGL runs, stay ESP-IDF only.
+#ifdef ESP_PLATFORM
+#include "HalEsp.hpp"
+#else
+#include "HalLinux.hpp"
+#endif
+
+#endif
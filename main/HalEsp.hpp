@@ -0,0 +1,143 @@
+#pragma once
+#ifndef HALESP_HPP
+#define HALESP_HPP
+
+#include <stdint.h>
+
+#include "bsp/esp32_p4_wifi6_touch_lcd_xc.h"
+#include "esp_cpu.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lvgl_port.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lvgl.h"
+
+#include "LvglHeap.hpp"
+
+namespace hal {
+
+using task_fn_t = void (*)(void *);
+
+inline auto NowUs() -> int64_t {
+    return esp_timer_get_time();
+}
+
+inline auto SleepMs(uint32_t ms) -> void {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+inline auto CycleCount() -> uint32_t {
+    return esp_cpu_get_cycle_count();
+}
+
+inline auto TaskCreate(task_fn_t fn, const char *name, uint32_t stack_bytes, void *arg, uint32_t priority, int core)
+    -> bool {
+    return xTaskCreatePinnedToCore(fn, name, stack_bytes, arg, priority, nullptr, core) == pdPASS;
+}
+
+namespace detail {
+
+inline auto Panel() -> bsp_lcd_handles_t & {
+    static bsp_lcd_handles_t handles{};
+    return handles;
+}
+
+// What bsp_display_start_with_config does after the panel is up, for a panel PanelInit already brought up
+inline auto AddPanelToLvgl(const bsp_display_cfg_t &cfg) -> lv_display_t * {
+    const bsp_lcd_handles_t &panel = Panel();
+    lvgl_port_display_cfg_t display_cfg = {.io_handle = panel.io,
+                                           .panel_handle = panel.panel,
+                                           .control_handle = panel.control,
+                                           .buffer_size = cfg.buffer_size,
+                                           .double_buffer = cfg.double_buffer,
+                                           .hres = BSP_LCD_H_RES,
+                                           .vres = BSP_LCD_V_RES,
+                                           .monochrome = false,
+                                           .rotation = {.swap_xy = false, .mirror_x = false, .mirror_y = false},
+                                           .color_format = LV_COLOR_FORMAT_RGB565,
+                                           .flags = {
+                                               .buff_dma = cfg.flags.buff_dma,
+                                               .buff_spiram = cfg.flags.buff_spiram,
+                                               .sw_rotate = cfg.flags.sw_rotate,
+                                               .swap_bytes = BSP_LCD_BIGENDIAN,
+                                               .full_refresh = false,
+                                               .direct_mode = false,
+                                           }};
+    lvgl_port_display_dsi_cfg_t dsi_cfg = {.flags = {.avoid_tearing = false}};
+    lv_display_t *display = lvgl_port_add_disp_dsi(&display_cfg, &dsi_cfg);
+    esp_lcd_touch_handle_t touch = nullptr;
+    if (display && bsp_touch_new(nullptr, &touch) == ESP_OK) {
+        lvgl_port_touch_cfg_t touch_cfg = {.disp = display, .handle = touch};
+        lvgl_port_add_touch(&touch_cfg);
+    }
+    return display;
+}
+
+} // namespace detail
+
+// Brings up the DSI panel and the backlight without LVGL, so a frame can be shown before LVGL runs. Device only.
+inline auto PanelInit() -> bool {
+    bsp_lcd_handles_t &panel = detail::Panel();
+    if (!panel.panel && bsp_display_new_with_handles(nullptr, &panel) != ESP_OK) {
+        panel = {};
+        return false;
+    }
+    return true;
+}
+
+// Copies a full screen RGB565 image into the panel's frame buffer. Device only, after PanelInit().
+inline auto PanelShow(const lv_image_dsc_t *image) -> bool {
+    const bsp_lcd_handles_t &panel = detail::Panel();
+    if (!panel.panel ||
+        esp_lcd_panel_draw_bitmap(panel.panel, 0, 0, BSP_LCD_H_RES, BSP_LCD_V_RES, image->data) != ESP_OK) {
+        return false;
+    }
+    bsp_display_backlight_on();
+    return true;
+}
+
+// background: the screen starts out showing this image instead of black, the same one PanelShow put up so the
+// first LVGL frame does not blank it
+inline auto DisplayInit(const lv_image_dsc_t *background = nullptr) -> void {
+    bsp_display_cfg_t cfg = {.lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
+                             .buffer_size = BSP_LCD_DRAW_BUFF_SIZE,
+                             .double_buffer = BSP_LCD_DRAW_BUFF_DOUBLE,
+                             .flags = {
+                                 .buff_dma = true,
+                                 .buff_spiram = false,
+                                 .sw_rotate = false,
+                             }};
+    if (!detail::Panel().panel) {
+        bsp_display_start_with_config(&cfg);
+        bsp_display_lock(0);
+        LvglHeap::MovePixelBuffers();
+    } else {
+        lvgl_port_init(&cfg.lvgl_port_cfg);
+        // Held from before the display exists, so the LVGL task can not refresh it before the background is set
+        bsp_display_lock(0);
+        LvglHeap::MovePixelBuffers();
+        detail::AddPanelToLvgl(cfg);
+    }
+    bsp_display_backlight_on();
+    bsp_display_brightness_set(100);
+    lv_obj_remove_flag(lv_screen_active(), LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_size(lv_screen_active(), 720, 720);
+    lv_obj_set_style_bg_color(lv_screen_active(), lv_color_hex(0x000000), 0);
+    if (background) {
+        lv_obj_set_style_bg_image_src(lv_screen_active(), background, 0);
+    }
+    bsp_display_unlock();
+}
+
+inline auto DisplayLock(uint32_t timeout_ms) -> bool {
+    return bsp_display_lock(timeout_ms);
+}
+
+inline auto DisplayUnlock() -> void {
+    bsp_display_unlock();
+}
+
+} // namespace hal
+
+#endif
@@ -0,0 +1,178 @@
+#pragma once
+#ifndef LATENCY_HPP
+#define LATENCY_HPP
+
+#include <array>
+#include <stdint.h>
+
+#include "esp_log.h"
+
+#include "CanSignals.hpp"
+
+// Log-linear histogram of microsecond latencies in fixed memory: exact below 8 us, then 4 buckets per power of two
+// (at most 25 % wide) up to about 67 s, everything above lands in the last bucket
+class LatencyHistogram {
+  private:
+    static constexpr uint32_t LINEAR = 8;
+    static constexpr uint32_t SUB_BITS = 2;
+    static constexpr uint32_t SUB = 1U << SUB_BITS;
+    static constexpr uint32_t FIRST_EXP = 3; // log2(LINEAR)
+    static constexpr uint32_t LAST_EXP = 25;
+
+  public:
+    static constexpr uint32_t BUCKETS = LINEAR + (LAST_EXP - FIRST_EXP + 1) * SUB;
+
+  private:
+    std::array<uint32_t, BUCKETS> counts{};
+    uint32_t total = 0;
+    uint32_t max_us = 0;
+
+    static auto Bucket(uint32_t us) -> uint32_t {
+        if (us < LINEAR) {
+            return us;
+        }
+        uint32_t exp = 31 - __builtin_clz(us);
+        if (exp > LAST_EXP) {
+            return BUCKETS - 1;
+        }
+        uint32_t sub = (us >> (exp - SUB_BITS)) & (SUB - 1);
+        return LINEAR + (exp - FIRST_EXP) * SUB + sub;
+    }
+
+  public:
+    // Smallest latency that falls in bucket
+    static auto BucketLow(uint32_t bucket) -> uint32_t {
+        if (bucket < LINEAR) {
+            return bucket;
+        }
+        uint32_t exp = FIRST_EXP + (bucket - LINEAR) / SUB;
+        uint32_t sub = (bucket - LINEAR) % SUB;
+        return (1U << exp) + (sub << (exp - SUB_BITS));
+    }
+
+    auto Record(int64_t us) -> void {
+        auto value = static_cast<uint32_t>(us < 0 ? 0 : (us > UINT32_MAX ? UINT32_MAX : us));
+        counts[Bucket(value)]++;
+        total++;
+        if (value > max_us) {
+            max_us = value;
+        }
+    }
+
+    auto Reset() -> void {
+        counts.fill(0);
+        total = 0;
+        max_us = 0;
+    }
+
+    // Upper edge (at most the max) of the bucket holding the part/whole quantile (99 for p99, 999, 1000 for p99.9), 0 when empty
+    [[nodiscard]] auto Percentile(uint32_t part, uint32_t whole = 100) const -> uint32_t {
+        if (!total) {
+            return 0;
+        }
+        uint64_t rank = (static_cast<uint64_t>(total) * part + whole - 1) / whole;
+        uint64_t seen = 0;
+        for (uint32_t bucket = 0; bucket < BUCKETS; bucket++) {
+            seen += counts[bucket];
+            if (seen >= rank && seen) {
+                uint32_t high = bucket + 1 < BUCKETS ? BucketLow(bucket + 1) - 1 : max_us;
+                return high < max_us ? high : max_us;
+            }
+        }
+        return max_us;
+    }
+
+    [[nodiscard]] auto Count() const -> uint32_t {
+        return total;
+    }
+    [[nodiscard]] auto Max() const -> uint32_t {
+        return max_us;
+    }
+    [[nodiscard]] auto Counts() const -> const std::array<uint32_t, BUCKETS> & {
+        return counts;
+    }
+};
+
+// How far a value has come, every stage is measured from the frame's RX timestamp
+enum class LatencyStage : uint8_t {
+    STORED = 0,  // payload in the frame cache, CAN task
+    DECODED = 1, // signal decoded by the UI's SignalReader
+    APPLIED = 2, // gauge updated, before rendering
+    DRAWN = 3,   // refresh that drew it is done (REFR_READY, the last chunk may still be on its way to the panel)
+    COUNT
+};
+static constexpr size_t LATENCY_STAGE_COUNT = static_cast<size_t>(LatencyStage::COUNT);
+static constexpr std::array<const char *, LATENCY_STAGE_COUNT> LATENCY_STAGE_NAMES{"stored", "decoded", "applied",
+                                                                                   "drawn"};
+
+// CAN-to-pixel latency histograms per stage and per signal, plus one per stage over all frames or signals. Each
+// histogram has a single writer: STORED is the CAN task's, the rest belong to the LVGL task. Readers tolerate torn
+// counts, they are statistics.
+class LatencyTable {
+  private:
+    static constexpr size_t ALL = SIGNAL_COUNT;
+    std::array<std::array<LatencyHistogram, SIGNAL_COUNT + 1>, LATENCY_STAGE_COUNT> histograms{};
+
+  public:
+    // A frame reached stage, not tied to one signal
+    auto Record(LatencyStage stage, int64_t latency_us) -> void {
+        histograms[static_cast<size_t>(stage)][ALL].Record(latency_us);
+    }
+    auto Record(LatencyStage stage, Signal signal, int64_t latency_us) -> void {
+        histograms[static_cast<size_t>(stage)][static_cast<size_t>(signal)].Record(latency_us);
+        histograms[static_cast<size_t>(stage)][ALL].Record(latency_us);
+    }
+
+    [[nodiscard]] auto Get(LatencyStage stage) const -> const LatencyHistogram & {
+        return histograms[static_cast<size_t>(stage)][ALL];
+    }
+    [[nodiscard]] auto Get(LatencyStage stage, Signal signal) const -> const LatencyHistogram & {
+        return histograms[static_cast<size_t>(stage)][static_cast<size_t>(signal)];
+    }
+
+    auto Reset() -> void {
+        for (auto &stage : histograms) {
+            for (LatencyHistogram &histogram : stage) {
+                histogram.Reset();
+            }
+        }
+    }
+
+    // One line per stage
+    auto LogSummary(const char *tag) const -> void {
+        for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+            const LatencyHistogram &histogram = histograms[stage][ALL];
+            ESP_LOGI(tag, "latency %-7s n: %lu p50: %lu p90: %lu p99: %lu max: %lu us", LATENCY_STAGE_NAMES[stage],
+                     histogram.Count(), histogram.Percentile(50), histogram.Percentile(90), histogram.Percentile(99),
+                     histogram.Max());
+        }
+    }
+
+    // Percentiles of every stage and signal that saw traffic, then the non-empty buckets of each
+    auto Dump(const char *tag) const -> void {
+        for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+            for (size_t signal = 0; signal <= SIGNAL_COUNT; signal++) {
+                const LatencyHistogram &histogram = histograms[stage][signal];
+                if (!histogram.Count()) {
+                    continue;
+                }
+                const char *name = signal == ALL ? "all" : SIGNAL_NAMES[signal];
+                ESP_LOGI(tag, "%s/%s n: %lu p50: %lu p90: %lu p99: %lu p99.9: %lu max: %lu us",
+                         LATENCY_STAGE_NAMES[stage], name, histogram.Count(), histogram.Percentile(50),
+                         histogram.Percentile(90), histogram.Percentile(99), histogram.Percentile(999, 1000),
+                         histogram.Max());
+                const auto &counts = histogram.Counts();
+                for (uint32_t bucket = 0; bucket < LatencyHistogram::BUCKETS; bucket++) {
+                    if (!counts[bucket]) {
+                        continue;
+                    }
+                    uint32_t high = bucket + 1 < LatencyHistogram::BUCKETS ? LatencyHistogram::BucketLow(bucket + 1) - 1
+                                                                          : histogram.Max();
+                    ESP_LOGI(tag, "  %8lu..%-8lu us %lu", LatencyHistogram::BucketLow(bucket), high, counts[bucket]);
+                }
+            }
+        }
+    }
+};
+
+#endif
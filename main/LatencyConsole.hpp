@@ -0,0 +1,55 @@
+#pragma once
+#ifndef LATENCYCONSOLE_HPP
+#define LATENCYCONSOLE_HPP
+
+#include <string.h>
+
+#include "esp_console.h"
+#include "esp_log.h"
+
+#include "Latency.hpp"
+
+// "latency" on the UART console dumps every histogram of the table, "latency reset" clears them. The REPL runs in
+// its own task, a dump racing the writers can be off by the frames recorded meanwhile.
+class LatencyConsole {
+  private:
+    static inline LatencyTable *table = nullptr;
+
+    static auto Command(int argc, char **argv) -> int {
+        if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+            table->Reset();
+            ESP_LOGI("LATENCY", "histograms cleared");
+            return 0;
+        }
+        if (argc > 1) {
+            ESP_LOGE("LATENCY", "usage: latency [reset]");
+            return 1;
+        }
+        table->Dump("LATENCY");
+        return 0;
+    }
+
+  public:
+    static auto Start(LatencyTable &latency) -> bool {
+        table = &latency;
+        esp_console_repl_t *repl = nullptr;
+        esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+        repl_config.prompt = "minidash>";
+        esp_console_dev_uart_config_t uart_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+        if (esp_console_new_repl_uart(&uart_config, &repl_config, &repl) != ESP_OK) {
+            ESP_LOGE("LATENCY", "Failed to create the console");
+            return false;
+        }
+        esp_console_cmd_t command{};
+        command.command = "latency";
+        command.help = "Dump the CAN to display latency histograms, 'latency reset' clears them";
+        command.func = Command;
+        if (esp_console_cmd_register(&command) != ESP_OK || esp_console_start_repl(repl) != ESP_OK) {
+            ESP_LOGE("LATENCY", "Failed to start the console");
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif
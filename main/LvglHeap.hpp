@@ -0,0 +1,80 @@
+#pragma once
+#ifndef LVGLHEAP_HPP
+#define LVGLHEAP_HPP
+
+#include <initializer_list>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "esp_log.h"
+#include "lvgl.h"
+
+struct lvgl_heap_stats_t {
+    uint32_t total = 0; // arena size, 0 when LVGL allocates from the C library
+    uint32_t used = 0;
+    uint32_t peak = 0;
+    uint32_t biggest_free = 0;
+    uint8_t frag_pct = 0;
+};
+
+// The LVGL heap. On the device it is LVGL's own allocator over a fixed arena in internal RAM
+// (CONFIG_LV_USE_BUILTIN_MALLOC, CONFIG_LV_MEM_SIZE_KILOBYTES) holding objects, styles, timers, animations and the
+// renderer's scratch memory, with no expansion, so an allocation that does not fit fails instead of taking from
+// the rest of the system. Pixel buffers stay on the C heap (PSRAM above CONFIG_SPIRAM_MALLOC_ALWAYSINTERNAL): the
+// background cache, gauge sprites and digit atlas are sized by the screen and would not fit in the arena. The host
+// build keeps LVGL on the C library so gauge_bench can count its allocations, there is no arena to report.
+class LvglHeap {
+  private:
+    uint32_t settled_used = 0;
+
+    static auto PixelMalloc(size_t size, lv_color_format_t color_format) -> void * {
+        LV_UNUSED(color_format);
+        // Room to align the start, as LVGL's own handler does
+        return malloc(size + LV_DRAW_BUF_ALIGN - 1);
+    }
+
+    static auto PixelFree(void *buf) -> void {
+        free(buf);
+    }
+
+  public:
+    // Call after lv_init, before the first draw buffer is created: buffers go back through the handlers they were
+    // made with.
+    static auto MovePixelBuffers() -> void {
+        for (lv_draw_buf_handlers_t *handlers :
+             {lv_draw_buf_get_handlers(), lv_draw_buf_get_font_handlers(), lv_draw_buf_get_image_handlers()}) {
+            handlers->buf_malloc_cb = PixelMalloc;
+            handlers->buf_free_cb = PixelFree;
+        }
+    }
+
+    // Take the display lock
+    static auto Stats() -> lvgl_heap_stats_t {
+        lv_mem_monitor_t monitor;
+        lv_mem_monitor(&monitor);
+        lvgl_heap_stats_t stats;
+        stats.total = static_cast<uint32_t>(monitor.total_size);
+        stats.used = static_cast<uint32_t>(monitor.total_size - monitor.free_size);
+        stats.peak = static_cast<uint32_t>(monitor.max_used);
+        stats.biggest_free = static_cast<uint32_t>(monitor.free_biggest_size);
+        stats.frag_pct = monitor.frag_pct;
+        return stats;
+    }
+
+    // Takes the usage once the scene is built as the baseline LogSummary compares against, take the display lock
+    auto Settle() -> void {
+        settled_used = Stats().used;
+    }
+
+    // Usage should stay at the settled value while the dash runs, growth means something allocates per update
+    auto LogSummary(const char *tag, const lvgl_heap_stats_t &stats) const -> void {
+        if (!stats.total) {
+            return;
+        }
+        ESP_LOGI(tag, "lvgl heap: used %lu of %lu B (%+ld since setup) peak %lu B biggest free %lu B frag %u%%",
+                 stats.used, stats.total, static_cast<int32_t>(stats.used - settled_used), stats.peak,
+                 stats.biggest_free, stats.frag_pct);
+    }
+};
+
+#endif
@@ -1,25 +1,49 @@
 #pragma once
 #ifndef MAINDISPLAY_HPP
 #define MAINDISPLAY_HPP
+#include <array>
+#include <optional>
+#include <stdint.h>
+
+#include "DashStyles.hpp"
+#include "GaugeArc.hpp"
+#include "NumericReadout.hpp"
 #include "gaugeMath.hpp"
 #include "hexCodes.hpp"
 #include "lvgl.h"
 #include "ParentDisplay.hpp"
 
-LV_IMG_DECLARE(MiniDash_v1_2);
+// 0 keeps the dash image and the scales as live objects, to compare DamageMeter draw times against
+#ifndef DASH_CACHE_BACKGROUND
+#define DASH_CACHE_BACKGROUND 1
+#endif
+
+// Setter calls that reached LVGL and those dropped because the gauge would have looked the same
+struct display_update_stats_t {
+    uint32_t arc_updates = 0;
+    uint32_t arc_skipped = 0;
+    uint32_t label_updates = 0;
+    uint32_t label_skipped = 0;
+};
 
 class MainDisplay : ParentDisplay {
   private:
     lv_obj_t *dash_bg;
-    lv_obj_t *rpmArc{};
-    lv_obj_t *rpmLabel{};
-    lv_obj_t *speedArc{};
-    lv_obj_t *speedLabel{};
-    lv_obj_t *fuelArc{};
-    lv_obj_t *fuelLabel{};
-    lv_obj_t *tempArc{};
-    lv_obj_t *tempLabel{};
+    std::optional<GaugeArc> rpmArc;
+    std::optional<NumericReadout> rpmLabel;
+    std::optional<GaugeArc> speedArc;
+    std::optional<NumericReadout> speedLabel;
+    std::optional<GaugeArc> fuelArc;
+    std::optional<NumericReadout> fuelLabel;
+    std::optional<GaugeArc> tempArc;
+    std::optional<NumericReadout> tempLabel;
     lv_obj_t *invis_overlay{};
+    std::array<lv_obj_t *, 4> scales{};
+    uint32_t scale_count = 0;
+    lv_draw_buf_t *background{};
+    bool prerendered = false; // dash_bg shows a background with the scales baked in
+
+    display_update_stats_t update_stats;
 
     enum class ArcType : uint8_t {
         uNULL = 0,
@@ -40,24 +64,26 @@ class MainDisplay : ParentDisplay {
         int16_t max = 100;
         int16_t ticks = 0;
         int16_t ticks_major = 1;
+        GaugeRenderer renderer = GaugeRenderer::ARC;
     };
     struct label_config {
+        const char *prefix = "";
+        uint8_t digits = 3;
         int16_t label_offset = 0;
     };
 
     auto static setArcData(void *obj, int32_t value) -> void {
-        auto *arc = static_cast<lv_obj_t *>(obj);
-        lv_arc_set_value(arc, value);
+        static_cast<GaugeArc *>(obj)->SetValue(value);
     }
 
-    static auto arcAnim(lv_obj_t *arc, bool startupEnable) -> void {
+    static auto arcAnim(std::optional<GaugeArc> &arc, bool startupEnable) -> void {
         if (!arc) {
             ESP_LOGE("FATAL", "null arc was passed into arcAnim function");
             return;
         }
         lv_anim_t anim;
         lv_anim_init(&anim);
-        lv_anim_set_var(&anim, arc);
+        lv_anim_set_var(&anim, &*arc);
 
         lv_anim_set_exec_cb(&anim, setArcData);
 
@@ -73,8 +99,8 @@ class MainDisplay : ParentDisplay {
             &anim, ANIM_DUR); // Set duration of the animation, this is for some
                               // reason linked to the counter-clockwise rotation
                               // lv_anim_set_repeat_delay(&anim, ANIM_DELAY);
-        int32_t max_val = lv_arc_get_max_value(arc);
-        int32_t min_val = lv_arc_get_min_value(arc);
+        int32_t max_val = arc->Max();
+        int32_t min_val = arc->Min();
         lv_anim_set_values(
             &anim, min_val,
             max_val); // Set the begin and end values for the animation, this should
@@ -82,77 +108,124 @@ class MainDisplay : ParentDisplay {
         lv_anim_start(&anim);
     }
 
-    static void arcSetup(lv_obj_t *arc, arc_config *config) {
-        if (arc) {
-            lv_obj_t *scale = lv_scale_create(arc);
-            // Scale Object alignment
-            lv_obj_center(scale);
-            lv_obj_set_size(scale, config->size, config->size);
-            lv_scale_set_rotation(scale, config->rotation);
-            lv_scale_set_mode(scale, LV_SCALE_MODE_ROUND_INNER);
-            lv_scale_set_range(scale, config->min, config->max);
-            lv_scale_set_angle_range(scale, config->angle);
-            lv_obj_set_style_text_color(scale, lv_color_hex(0xFFFFFF), 0);
-            lv_scale_set_total_tick_count(scale, config->ticks);
-            lv_scale_set_major_tick_every(scale, config->ticks_major);
-
-            // Object alignment and size adjustment
-            lv_obj_center(arc);
-            lv_obj_set_size(arc, config->size, config->size);
-            lv_arc_set_rotation(arc, config->rotation);
-            lv_arc_set_bg_angles(arc, 0, config->angle);
-            lv_arc_set_value(arc, 0);
-
-            // Object style changes
-            lv_obj_set_style_arc_width(arc, config->width, LV_PART_INDICATOR);
-            lv_obj_remove_style(arc, nullptr, LV_PART_KNOB);
-            lv_obj_set_style_arc_color(arc, lv_color_hex(config->color),
-                                       LV_PART_INDICATOR);
-            lv_obj_set_style_arc_opa(arc, LV_OPA_TRANSP, LV_PART_MAIN);
-            lv_obj_set_style_arc_rounded(arc, false, LV_PART_INDICATOR);
-
-            // Make it unclickable and give it an animation for testing
-            lv_obj_clear_flag(arc, LV_OBJ_FLAG_CLICKABLE);
-
-            //Arc specific settings:
-            if (config->identifier == ArcType::FUEL) {
-                lv_arc_set_range(arc, config->max, config->min);
-                lv_arc_set_mode(arc, LV_ARC_MODE_REVERSE); // Set mode to reverse so the
+    auto arcSetup(std::optional<GaugeArc> &arc, arc_config *config) -> void {
+        gauge_arc_config_t gauge;
+        gauge.size = config->size;
+        gauge.rotation = config->rotation;
+        gauge.span = config->angle;
+        gauge.width = config->width;
+        gauge.color = config->color;
+        gauge.renderer = config->renderer;
+        if (config->width == ARC_WIDTH && config->color == GAUGE_COLOR) {
+            gauge.indicator_style = &DASH_ARC_INDICATOR_STYLE;
+        }
+        //Arc specific settings:
+        if (config->identifier == ArcType::FUEL) {
+            gauge.min = config->max;
+            gauge.max = config->min;
+            gauge.reverse = true; // Reverse so the indicator empties towards the end of the span
+        } else {
+            gauge.min = config->min;
+            gauge.max = config->max;
+        }
+        arc.emplace(dash_bg, gauge);
+        if (prerendered) {
+            return;
+        }
+
+        // GaugeArc only draws the indicator, the scale sits on top of it as a sibling
+        lv_obj_t *scale = lv_scale_create(dash_bg);
+        // Scale Object alignment
+        lv_obj_center(scale);
+        lv_obj_set_size(scale, config->size, config->size);
+        lv_scale_set_rotation(scale, config->rotation);
+        lv_scale_set_mode(scale, LV_SCALE_MODE_ROUND_INNER);
+        lv_scale_set_range(scale, config->min, config->max);
+        lv_scale_set_angle_range(scale, config->angle);
+        lv_obj_add_style(scale, &DASH_SCALE_STYLE, 0);
+        lv_scale_set_total_tick_count(scale, config->ticks);
+        lv_scale_set_major_tick_every(scale, config->ticks_major);
+        if (scale_count < scales.size()) {
+            scales[scale_count++] = scale;
+        }
+    }
+
+    auto setGaugesHidden(bool hidden) -> void {
+        for (lv_obj_t *obj : {rpmArc ? rpmArc->Obj() : nullptr, speedArc ? speedArc->Obj() : nullptr,
+                              fuelArc ? fuelArc->Obj() : nullptr, tempArc ? tempArc->Obj() : nullptr,
+                              rpmLabel ? rpmLabel->Obj() : nullptr, speedLabel ? speedLabel->Obj() : nullptr,
+                              fuelLabel ? fuelLabel->Obj() : nullptr, tempLabel ? tempLabel->Obj() : nullptr}) {
+            if (!obj) {
+                continue;
+            }
+            if (hidden) {
+                lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
             } else {
-                lv_arc_set_range(arc, config->min, config->max);
+                lv_obj_remove_flag(obj, LV_OBJ_FLAG_HIDDEN);
             }
         }
     }
 
-    static auto labelSetup(lv_obj_t *label, label_config *config) -> void {
-        lv_obj_align(label, LV_ALIGN_CENTER, LABEL_OFFSET_X, config->label_offset);
+    auto labelSetup(std::optional<NumericReadout> &label, label_config *config) -> void {
+        label.emplace(dash_bg, config->prefix, config->digits, LABEL_OFFSET_X, config->label_offset);
+    }
+
+    auto setArcIfMoved(GaugeArc &arc, int32_t value) -> void {
+        if (arc.SetValue(value)) {
+            update_stats.arc_updates++;
+        } else {
+            update_stats.arc_skipped++;
+        }
+    }
 
-        lv_label_set_text(label, "");
+    auto setLabelIfChanged(NumericReadout &label, int32_t value) -> void {
+        if (label.SetValue(value)) {
+            update_stats.label_updates++;
+        } else {
+            update_stats.label_skipped++;
+        }
+    }
 
-        lv_obj_set_style_text_color(label, lv_color_hex(0xFFFFFF), 0);
+    static auto setStale(std::optional<GaugeArc> &arc, std::optional<NumericReadout> &label, bool stale) -> void {
+        lv_opa_t opa = stale ? STALE_OPA : LV_OPA_COVER;
+        if (arc) {
+            arc->SetOpacity(opa);
+        }
+        if (label) {
+            label->SetOpacity(opa);
+        }
     }
 
-    auto ImageSetup() -> void {
-        lv_img_set_src(dash_bg, &MiniDash_v1_2);
+    auto ImageSetup(const lv_image_dsc_t *image) -> void {
+        if (!image) {
+            // Without a source the image is 0x0 and clips every gauge in it away, it spans the parent instead
+            ESP_LOGE("UI", "No dash image, drawing the gauges on a black screen");
+            lv_obj_set_size(dash_bg, LV_PCT(100), LV_PCT(100));
+            lv_obj_center(dash_bg);
+            lv_obj_add_style(lv_screen_active(), &DASH_BLACK_STYLE, LV_PART_MAIN);
+            return;
+        }
+        lv_img_set_src(dash_bg, image);
         lv_obj_center(dash_bg);
     }
     auto InvisOverlaySetup() -> void {
         lv_obj_remove_style_all(invis_overlay);
         lv_obj_set_size(invis_overlay, LV_PCT(100), LV_PCT(100));
         lv_obj_center(invis_overlay);
-        lv_obj_set_style_opa(invis_overlay, LV_OPA_TRANSP, 0);
+        lv_obj_add_style(invis_overlay, &DASH_INVISIBLE_STYLE, 0);
     }
 
   public:
-    MainDisplay() : dash_bg(lv_img_create(parentDisplay)),
-                    invis_overlay(lv_obj_create(lv_scr_act())) {
+    // background: the dash image. prerendered: it is an RGB565 screen-sized dash with the scales, as
+    // CacheBackground makes it, the scales are then not created and CacheBackground has nothing to do.
+    explicit MainDisplay(const lv_image_dsc_t *background, bool prerendered = false)
+        : dash_bg(lv_img_create(parentDisplay)), invis_overlay(lv_obj_create(lv_scr_act())),
+          prerendered(prerendered && background) {
         InvisOverlaySetup();
-        ImageSetup();
+        ImageSetup(background);
     }
 
     auto SetupRpmArc() -> void {
-        rpmArc = lv_arc_create(dash_bg);
-        rpmLabel = lv_label_create(dash_bg);
         arc_config arc_config;
         arc_config.identifier = ArcType::RPM;
         arc_config.rotation = RPM_ARC_ROTATION;
@@ -161,8 +234,11 @@ class MainDisplay : ParentDisplay {
         arc_config.min = RPM_ARC_MIN;
         arc_config.max = RPM_ARC_MAX;
         arc_config.ticks = RPM_TICKS;
+        arc_config.renderer = GaugeRenderer::SPRITE; // changes every frame, a copy beats the arc coverage
 
         label_config label_config;
+        label_config.prefix = "RPM: ";
+        label_config.digits = 4;
         label_config.label_offset = RPM_LABEL_OFFSET_Y;
 
         arcSetup(rpmArc, &arc_config);
@@ -170,8 +246,6 @@ class MainDisplay : ParentDisplay {
     }
 
     auto SetupSpeedArc() -> void {
-        speedArc = lv_arc_create(dash_bg);
-        speedLabel = lv_label_create(dash_bg);
         arc_config arc_config;
         arc_config.identifier = ArcType::SPEED;
         arc_config.rotation = SPEED_ARC_ROTATION;
@@ -181,8 +255,9 @@ class MainDisplay : ParentDisplay {
         arc_config.max = SPEED_ARC_MAX;
         arc_config.ticks = SPEED_TICKS;
 
-        speedLabel = lv_label_create(dash_bg);
         label_config label_config;
+        label_config.prefix = "SPEED: ";
+        label_config.digits = 3;
         label_config.label_offset = SPEEDO_LABEL_OFFSET_Y;
 
         arcSetup(speedArc, &arc_config);
@@ -190,8 +265,6 @@ class MainDisplay : ParentDisplay {
     }
 
     auto SetupFuelArc() -> void {
-        fuelArc = lv_arc_create(dash_bg);
-        fuelLabel = lv_label_create(dash_bg);
         arc_config arc_config;
         arc_config.identifier = ArcType::FUEL;
         arc_config.rotation = FUEL_ARC_ROTATION;
@@ -201,8 +274,9 @@ class MainDisplay : ParentDisplay {
         arc_config.max = FUEL_ARC_MAX;
         arc_config.ticks = FUEL_TICKS;
 
-        fuelLabel = lv_label_create(dash_bg);
         label_config label_config;
+        label_config.prefix = "FUEL: ";
+        label_config.digits = 3;
         label_config.label_offset = FUEL_LABEL_OFFSET_Y;
 
         arcSetup(fuelArc, &arc_config);
@@ -210,8 +284,6 @@ class MainDisplay : ParentDisplay {
     }
 
     auto SetupTempArc() -> void {
-        tempArc = lv_arc_create(dash_bg);
-        tempLabel = lv_label_create(dash_bg);
         arc_config arc_config;
         arc_config.identifier = ArcType::TEMP;
         arc_config.rotation = TEMP_ARC_ROTATION;
@@ -221,8 +293,9 @@ class MainDisplay : ParentDisplay {
         arc_config.max = TEMP_ARC_MAX;
         arc_config.ticks = TEMP_TICKS;
 
-        tempLabel = lv_label_create(dash_bg);
         label_config label_config;
+        label_config.prefix = "TEMP: ";
+        label_config.digits = 3;
         label_config.label_offset = TEMP_LABEL_OFFSET_Y;
 
         arcSetup(tempArc, &arc_config);
@@ -234,8 +307,8 @@ class MainDisplay : ParentDisplay {
             ESP_LOGE("FATAL", "rpmArc is null");
             return;
         }
-        lv_arc_set_value(rpmArc, value);
-        lv_label_set_text_fmt(rpmLabel, "RPM: %i", value);
+        setArcIfMoved(*rpmArc, value);
+        setLabelIfChanged(*rpmLabel, value);
     }
 
     auto SetSpeedValue(uint8_t value) -> void {
@@ -243,8 +316,8 @@ class MainDisplay : ParentDisplay {
             ESP_LOGE("FATAL", "speedArc is null");
             return;
         }
-        lv_arc_set_value(speedArc, value);
-        lv_label_set_text_fmt(speedLabel, "SPEED: %i", value);
+        setArcIfMoved(*speedArc, value);
+        setLabelIfChanged(*speedLabel, value);
     }
 
     auto SetFuelValue(uint8_t value) -> void {
@@ -252,8 +325,8 @@ class MainDisplay : ParentDisplay {
             ESP_LOGE("FATAL", "fuelArc is null");
             return;
         }
-        lv_arc_set_value(fuelArc, value);
-        lv_label_set_text_fmt(fuelLabel, "FUEL: %i", value);
+        setArcIfMoved(*fuelArc, value);
+        setLabelIfChanged(*fuelLabel, value);
     }
 
     auto SetTempValue(uint16_t value) -> void {
@@ -261,8 +334,57 @@ class MainDisplay : ParentDisplay {
             ESP_LOGE("FATAL", "tempArc is null");
             return;
         }
-        lv_arc_set_value(tempArc, value);
-        lv_label_set_text_fmt(tempLabel, "TEMP: %i", value);
+        setArcIfMoved(*tempArc, value);
+        setLabelIfChanged(*tempLabel, value);
+    }
+
+    // Greys a gauge out while its value is stale, the last value stays visible
+    auto SetRPMStale(bool stale) -> void {
+        setStale(rpmArc, rpmLabel, stale);
+    }
+    auto SetSpeedStale(bool stale) -> void {
+        setStale(speedArc, speedLabel, stale);
+    }
+    auto SetFuelStale(bool stale) -> void {
+        setStale(fuelArc, fuelLabel, stale);
+    }
+    auto SetTempStale(bool stale) -> void {
+        setStale(tempArc, tempLabel, stale);
+    }
+
+    [[nodiscard]] auto GetUpdateStats() const -> const display_update_stats_t & {
+        return update_stats;
+    }
+
+    // Renders the dash image with the scales baked in once into an opaque RGB565 buffer (PSRAM through malloc) and
+    // shows that instead, so every redraw of a dirty area starts from a plain copy of it rather than blending the
+    // image and drawing tick lines and scale labels again. Call after the Setup*Arc functions, before the animation.
+    auto CacheBackground() -> bool {
+#if DASH_CACHE_BACKGROUND
+        if (prerendered) {
+            return true;
+        }
+        setGaugesHidden(true);
+        background = lv_snapshot_take(dash_bg, LV_COLOR_FORMAT_RGB565);
+        setGaugesHidden(false);
+        if (!background) {
+            ESP_LOGE("UI", "No memory for the background cache, drawing the background live");
+            return false;
+        }
+        for (uint32_t i = 0; i < scale_count; i++) {
+            lv_obj_delete(scales[i]);
+        }
+        scale_count = 0;
+        lv_image_set_src(dash_bg, background);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // The cached background, nullptr when there is none or it came in pre-rendered
+    [[nodiscard]] auto Background() const -> const lv_draw_buf_t * {
+        return background;
     }
 
     void HideOnTouch() {
@@ -275,6 +397,16 @@ class MainDisplay : ParentDisplay {
         arcAnim(fuelArc, true);
         arcAnim(tempArc, true);
     }
+
+    // True while any gauge is still in the startup sweep
+    [[nodiscard]] auto ArcAnimationRunning() -> bool {
+        for (std::optional<GaugeArc> *arc : {&rpmArc, &speedArc, &fuelArc, &tempArc}) {
+            if (*arc && lv_anim_get(&**arc, setArcData)) {
+                return true;
+            }
+        }
+        return false;
+    }
 };
 
 #endif
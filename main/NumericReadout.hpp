@@ -0,0 +1,178 @@
+#pragma once
+#ifndef NUMERICREADOUT_HPP
+#define NUMERICREADOUT_HPP
+
+#include <array>
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "lvgl.h"
+
+#include "DigitCells.hpp"
+
+// Digits 0-9 of one font, each rasterized once into an ARGB8888 cell of the widest digit's size. Shared by every
+// NumericReadout, built by the first one under the display lock.
+class DigitAtlas {
+  private:
+    std::array<lv_draw_buf_t *, 10> digits{};
+    int32_t cell_width = 0;
+    int32_t cell_height = 0;
+
+  public:
+    // Draws text into a transparent ARGB8888 buffer of width x height
+    static auto Rasterize(lv_obj_t *parent, const char *text, const lv_font_t *font, uint32_t color, int32_t width,
+                          int32_t height) -> lv_draw_buf_t * {
+        lv_draw_buf_t *buf = lv_draw_buf_create(static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+                                                LV_COLOR_FORMAT_ARGB8888, LV_STRIDE_AUTO);
+        if (!buf) {
+            return nullptr;
+        }
+        lv_obj_t *canvas = lv_canvas_create(parent);
+        lv_canvas_set_draw_buf(canvas, buf);
+        lv_canvas_fill_bg(canvas, lv_color_black(), LV_OPA_TRANSP);
+        lv_layer_t layer;
+        lv_canvas_init_layer(canvas, &layer);
+        lv_draw_label_dsc_t dsc;
+        lv_draw_label_dsc_init(&dsc);
+        dsc.color = lv_color_hex(color);
+        dsc.font = font;
+        dsc.text = text;
+        lv_area_t area{0, 0, width - 1, height - 1};
+        lv_draw_label(&layer, &dsc, &area);
+        lv_canvas_finish_layer(canvas, &layer);
+        lv_obj_delete(canvas);
+        return buf;
+    }
+
+    DigitAtlas(lv_obj_t *parent, const lv_font_t *font, uint32_t color) {
+        cell_height = lv_font_get_line_height(font);
+        for (char digit = '0'; digit <= '9'; digit++) {
+            int32_t width = lv_font_get_glyph_width(font, static_cast<uint32_t>(digit), 0);
+            if (width > cell_width) {
+                cell_width = width;
+            }
+        }
+        const char text[10][2] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", "9"};
+        for (uint32_t digit = 0; digit < digits.size(); digit++) {
+            digits[digit] = Rasterize(parent, text[digit], font, color, cell_width, cell_height);
+        }
+    }
+
+    [[nodiscard]] auto Ready() const -> bool {
+        for (const lv_draw_buf_t *digit : digits) {
+            if (!digit) {
+                return false;
+            }
+        }
+        return true;
+    }
+    [[nodiscard]] auto Digit(uint8_t digit) const -> const lv_draw_buf_t * {
+        return digits[digit];
+    }
+    [[nodiscard]] auto CellWidth() const -> int32_t {
+        return cell_width;
+    }
+    [[nodiscard]] auto CellHeight() const -> int32_t {
+        return cell_height;
+    }
+};
+
+// Fixed-width "PREFIX: 1234" readout. The prefix is rasterized once, the value goes into right-aligned digit cells
+// blitted from the DigitAtlas, and a value change invalidates only the cells whose digit changed. SetValue does no
+// formatting, allocation or text layout. Values are clamped to the cell count, leading zeros are blank (DigitCells).
+class NumericReadout {
+  private:
+    lv_obj_t *obj;
+    const DigitAtlas &atlas;
+    lv_draw_buf_t *prefix{};
+    int32_t prefix_width;
+    DigitCells cells;
+    lv_opa_t opa = LV_OPA_COVER;
+
+    static auto SharedAtlas(lv_obj_t *parent) -> const DigitAtlas & {
+        static DigitAtlas atlas(parent, lv_font_get_default(), 0xFFFFFF);
+        if (!atlas.Ready()) {
+            ESP_LOGE("UI", "No memory for the digit atlas, readouts stay blank");
+        }
+        return atlas;
+    }
+
+    [[nodiscard]] auto CellArea(uint8_t cell) const -> lv_area_t {
+        lv_area_t coords;
+        lv_obj_get_coords(obj, &coords);
+        cell_rect_t rect =
+            DigitCells::CellRect(coords.x1, coords.y1, prefix_width, atlas.CellWidth(), atlas.CellHeight(), cell);
+        return {rect.x1, rect.y1, rect.x2, rect.y2};
+    }
+
+    static auto DrawEvent(lv_event_t *event) -> void {
+        auto *self = static_cast<NumericReadout *>(lv_event_get_user_data(event));
+        lv_layer_t *layer = lv_event_get_layer(event);
+        lv_draw_image_dsc_t dsc;
+        lv_draw_image_dsc_init(&dsc);
+        dsc.opa = self->opa;
+        if (self->prefix) {
+            lv_area_t coords;
+            lv_obj_get_coords(self->obj, &coords);
+            lv_area_t area{coords.x1, coords.y1, coords.x1 + self->prefix_width - 1,
+                           coords.y1 + self->atlas.CellHeight() - 1};
+            dsc.src = self->prefix;
+            lv_draw_image(layer, &dsc, &area);
+        }
+        for (uint8_t cell = 0; cell < self->cells.Count(); cell++) {
+            uint8_t digit = self->cells.Digit(cell);
+            if (digit == DigitCells::BLANK || !self->atlas.Digit(digit)) {
+                continue;
+            }
+            lv_area_t area = self->CellArea(cell);
+            dsc.src = self->atlas.Digit(digit);
+            lv_draw_image(layer, &dsc, &area);
+        }
+    }
+
+  public:
+    // Centered on the parent at x_offset, y_offset like an aligned label, digits is the number of value cells
+    NumericReadout(lv_obj_t *parent, const char *prefix_text, uint8_t digits, int32_t x_offset, int32_t y_offset)
+        : obj(lv_obj_create(parent)), atlas(SharedAtlas(parent)),
+          prefix_width(lv_text_get_width(prefix_text, static_cast<uint32_t>(strlen(prefix_text)),
+                                         lv_font_get_default(), 0)),
+          cells(digits) {
+        prefix = DigitAtlas::Rasterize(parent, prefix_text, lv_font_get_default(), 0xFFFFFF, prefix_width,
+                                       atlas.CellHeight());
+        lv_obj_remove_style_all(obj);
+        lv_obj_set_size(obj, prefix_width + cells.Count() * atlas.CellWidth(), atlas.CellHeight());
+        lv_obj_align(obj, LV_ALIGN_CENTER, x_offset, y_offset);
+        lv_obj_remove_flag(obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_add_event_cb(obj, DrawEvent, LV_EVENT_DRAW_MAIN, this);
+    }
+
+    // The draw callback points at this object
+    NumericReadout(const NumericReadout &) = delete;
+    auto operator=(const NumericReadout &) -> NumericReadout & = delete;
+
+    // Returns false when no digit changed
+    auto SetValue(int32_t value) -> bool {
+        uint32_t changed = cells.Set(value);
+        for (uint8_t cell = 0; cell < cells.Count(); cell++) {
+            if (changed & (1U << cell)) {
+                lv_area_t area = CellArea(cell);
+                lv_obj_invalidate_area(obj, &area);
+            }
+        }
+        return changed;
+    }
+
+    auto SetOpacity(lv_opa_t new_opa) -> void {
+        if (new_opa != opa) {
+            opa = new_opa;
+            lv_obj_invalidate(obj);
+        }
+    }
+
+    [[nodiscard]] auto Obj() const -> lv_obj_t * {
+        return obj;
+    }
+};
+
+#endif
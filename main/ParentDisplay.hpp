@@ -4,6 +4,8 @@
 #include "esp_log.h"
 #include "lvgl.h"
 
+#include "DashStyles.hpp"
+
 class ParentDisplay {
   protected:
     static void hideObjectCallback(lv_event_t *event) {
@@ -25,7 +27,7 @@ class ParentDisplay {
 
     ParentDisplay() : parentDisplay(lv_obj_create(lv_screen_active())) {
         lv_obj_remove_style_all(parentDisplay);
-        lv_obj_set_style_bg_opa(parentDisplay, LV_OPA_TRANSP, LV_PART_MAIN);
+        lv_obj_add_style(parentDisplay, &DASH_CLEAR_STYLE, LV_PART_MAIN);
         lv_obj_set_size(parentDisplay, 720, 720);
         lv_obj_remove_flag(parentDisplay, LV_OBJ_FLAG_SCROLLABLE);
     }
@@ -0,0 +1,121 @@
+#pragma once
+#ifndef REPLAYBACKEND_HPP
+#define REPLAYBACKEND_HPP
+
+#include <stdint.h>
+
+#include "CanRxBackend.hpp"
+#include "Hal.hpp"
+#include "TraceSource.hpp"
+
+struct replay_stats_t {
+    uint32_t frames = 0;
+    uint32_t loops = 0;
+    int64_t max_lag_us = 0; // how far behind its recorded spacing a frame was delivered
+};
+
+// Receive backend that plays a recorded trace into the RX path in place of a controller. speed scales the recorded
+// frame spacing, 1 is real time, 4 is four times faster and 0 delivers frames as fast as the consumer drains them.
+// Frames are stamped with the time they are delivered, so everything downstream sees them as live traffic.
+class ReplayBackend : public CanRxBackend {
+  private:
+    TraceSource &source;
+    float speed;
+    bool loop;
+    can_rx_ring_t ring;
+    can_frame_t pending{};
+    bool has_pending = false;
+    bool finished = false;
+    bool started = false;
+    int64_t trace_start_us = 0;
+    int64_t wall_start_us = 0;
+    replay_stats_t stats{};
+
+    auto DueAt(const can_frame_t &frame) const -> int64_t {
+        if (speed <= 0) {
+            return wall_start_us;
+        }
+        return wall_start_us + static_cast<int64_t>((frame.timestamp_us - trace_start_us) / speed);
+    }
+
+    auto StartTimebase(int64_t now) -> void {
+        trace_start_us = pending.timestamp_us;
+        wall_start_us = now;
+    }
+
+    auto Fetch(int64_t now) -> bool {
+        if (has_pending) {
+            return true;
+        }
+        if (finished) {
+            return false;
+        }
+        if (source.Next(pending)) {
+            has_pending = true;
+            if (!started) {
+                started = true;
+                StartTimebase(now);
+            }
+            return true;
+        }
+        if (loop && stats.frames && source.Rewind() && source.Next(pending)) {
+            has_pending = true;
+            stats.loops++;
+            StartTimebase(now);
+            return true;
+        }
+        finished = true;
+        return false;
+    }
+
+    // Moves every frame that is due by now into the ring
+    auto Fill(int64_t now) -> void {
+        while (ring.Size() < can_rx_ring_t::Capacity() && Fetch(now)) {
+            int64_t due = DueAt(pending);
+            if (due > now) {
+                return;
+            }
+            if (now - due > stats.max_lag_us) {
+                stats.max_lag_us = now - due;
+            }
+            pending.timestamp_us = speed <= 0 ? now : due;
+            ring.Push(pending);
+            has_pending = false;
+            stats.frames++;
+        }
+    }
+
+  public:
+    ReplayBackend(TraceSource &source, float speed, bool loop) : source(source), speed(speed), loop(loop) {}
+
+    auto WaitForFrames(uint32_t timeout_ms) -> bool override {
+        int64_t deadline = hal::NowUs() + int64_t{timeout_ms} * 1000;
+        while (true) {
+            int64_t now = hal::NowUs();
+            Fill(now);
+            if (ring.Size()) {
+                return true;
+            }
+            if (now >= deadline) {
+                return false;
+            }
+            // A finished trace looks like a silent bus, sleep out the timeout instead of spinning
+            int64_t wake = has_pending && DueAt(pending) < deadline ? DueAt(pending) : deadline;
+            int64_t wait_ms = (wake - now + 999) / 1000;
+            hal::SleepMs(wait_ms > 0 ? static_cast<uint32_t>(wait_ms) : 1);
+        }
+    }
+
+    auto Ring() -> can_rx_ring_t & override {
+        return ring;
+    }
+
+    [[nodiscard]] auto Finished() const -> bool {
+        return finished && !has_pending;
+    }
+    [[nodiscard]] auto GetStats() const -> const replay_stats_t & {
+        return stats;
+    }
+};
+
+#endif
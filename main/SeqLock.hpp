@@ -0,0 +1,52 @@
+#pragma once
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// Single writer / multi reader sequence lock. The writer never waits, readers copy the value and retry if a
+// write overlapped the copy. An odd sequence means a write is in progress, sequence / 2 is the generation.
+// Readers must not run at a higher priority on the writer's core, they would spin on an interrupted write.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied with memcpy");
+
+  private:
+    std::atomic<uint32_t> sequence{0};
+    T value{};
+
+  public:
+    // Writer side only, update receives the shared value and edits it in place
+    template <typename Update>
+    auto Write(Update &&update) -> void {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        update(value);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Copies a consistent value into out and returns its generation
+    auto Read(T &out) const -> uint32_t {
+        while (true) {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            memcpy(&out, &value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                return before >> 1;
+            }
+        }
+    }
+
+    [[nodiscard]] auto Generation() const -> uint32_t {
+        return sequence.load(std::memory_order_acquire) >> 1;
+    }
+};
+
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef STALEWATCH_HPP
+#define STALEWATCH_HPP
+
+#include <array>
+#include <stdint.h>
+
+#include "CanSignals.hpp"
+#include "VehicleState.hpp"
+#include "gaugeMath.hpp"
+
+// Deadlines of the dash gauges, 0 for signals without a gauge
+static constexpr std::array<int32_t, SIGNAL_COUNT> GAUGE_STALE_AFTER_MS{RPM_STALE_MS, SPEED_STALE_MS, FUEL_STALE_MS,
+                                                                        TEMP_STALE_MS, 0, 0};
+// How often the dash checks them, a gauge greys out at most this long after its deadline
+static constexpr uint32_t STALE_CHECK_MS = 50;
+
+// Which signals have not been received within their deadline. Kept apart from the gauges so the host tests can
+// replay a trace into it, DashboardUi greys out the gauges it reports.
+class StaleWatch {
+  private:
+    std::array<int32_t, SIGNAL_COUNT> deadline_ms;
+    uint32_t stale = 0;
+
+  public:
+    // Deadline per signal, 0 for signals that are not watched
+    explicit constexpr StaleWatch(const std::array<int32_t, SIGNAL_COUNT> &deadlines) : deadline_ms(deadlines) {}
+
+    // restored: bit per signal showing a value restored at restored_us, which is as old as that until a live one
+    // replaces it. Returns a bit per signal that went stale or came back.
+    auto Check(const vehicle_state_t &state, uint32_t restored, int64_t restored_us, int64_t now) -> uint32_t {
+        uint32_t flipped = 0;
+        for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+            if (!deadline_ms[i]) {
+                continue;
+            }
+            int64_t rx_us = state.rx_time_us[i];
+            int64_t since_us = rx_us ? rx_us : (restored & (1U << i)) ? restored_us : 0;
+            bool is_stale = !since_us || now - since_us > deadline_ms[i] * 1000LL;
+            if (is_stale != static_cast<bool>(stale & (1U << i))) {
+                stale ^= 1U << i;
+                flipped |= 1U << i;
+            }
+        }
+        return flipped;
+    }
+
+    // Bit per signal currently stale
+    [[nodiscard]] auto Stale() const -> uint32_t {
+        return stale;
+    }
+    [[nodiscard]] auto DeadlineMs(Signal signal) const -> int32_t {
+        return deadline_ms[static_cast<size_t>(signal)];
+    }
+};
+
+#endif
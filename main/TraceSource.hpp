@@ -0,0 +1,310 @@
+#pragma once
+#ifndef TRACESOURCE_HPP
+#define TRACESOURCE_HPP
+
+#include <array>
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CanFrame.hpp"
+#include "FlightLog.hpp"
+
+// Sequential source of recorded frames for ReplayBackend. Timestamps are the recorded ones, only their spacing
+// matters for pacing.
+class TraceSource {
+  public:
+    virtual ~TraceSource() = default;
+
+    // Next frame of the trace, false at the end
+    virtual auto Next(can_frame_t &frame) -> bool = 0;
+
+    // Back to the first frame, false if the source can not be read again
+    virtual auto Rewind() -> bool = 0;
+};
+
+// candump text logs, both the log format (candump -l)
+//   (1436509052.249713) can0 0AA#1122334455667788
+// and the screen format with or without a timestamp (candump -ta)
+//   (1436509052.249713)  can0  0AA   [8]  11 22 33 44 55 66 77 88
+// An 8 digit ID is an extended frame, "#R" is a remote frame, CAN FD lines ("##") are skipped.
+// Interfaces become buses in order of first appearance.
+class CandumpSource : public TraceSource {
+  private:
+    static constexpr size_t max_interfaces = 2;
+
+    FILE *file{};
+    char line[256]{};
+    std::array<std::array<char, 16>, max_interfaces> interfaces{};
+    size_t interface_count = 0;
+    int64_t last_timestamp_us = 0;
+    uint32_t skipped_lines = 0;
+
+    auto BusOf(const char *name, size_t len) -> int {
+        if (len >= interfaces[0].size()) {
+            return -1;
+        }
+        for (size_t i = 0; i < interface_count; i++) {
+            if (strncmp(interfaces[i].data(), name, len) == 0 && interfaces[i][len] == '\0') {
+                return static_cast<int>(i);
+            }
+        }
+        if (interface_count == max_interfaces) {
+            return -1;
+        }
+        memcpy(interfaces[interface_count].data(), name, len);
+        interfaces[interface_count][len] = '\0';
+        return static_cast<int>(interface_count++);
+    }
+
+    static auto SkipSpaces(const char *p) -> const char * {
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        return p;
+    }
+
+    static auto ParseHexBytes(const char *p, uint8_t *data, size_t max, bool spaced) -> int {
+        size_t count = 0;
+        while (count < max) {
+            if (spaced) {
+                p = SkipSpaces(p);
+            }
+            if (!isxdigit(static_cast<unsigned char>(p[0])) || !isxdigit(static_cast<unsigned char>(p[1]))) {
+                break;
+            }
+            char byte[3] = {p[0], p[1], '\0'};
+            data[count++] = static_cast<uint8_t>(strtoul(byte, nullptr, 16));
+            p += 2;
+        }
+        return static_cast<int>(count);
+    }
+
+    // The frame after the interface name, ID and data in either format
+    static auto ParseFrame(const char *p, can_frame_t &frame) -> bool {
+        const char *id_start = p;
+        char *after = nullptr;
+        frame.identifier = static_cast<uint32_t>(strtoul(id_start, &after, 16));
+        if (after == id_start) {
+            return false;
+        }
+        frame.extd = after - id_start > 3;
+
+        if (*after == '#') {
+            if (after[1] == '#') {
+                return false;
+            }
+            if (after[1] == 'R') {
+                frame.rtr = true;
+                frame.dlc = isdigit(static_cast<unsigned char>(after[2])) ? after[2] - '0' : 0;
+                return true;
+            }
+            frame.dlc = static_cast<uint8_t>(ParseHexBytes(after + 1, frame.data, 8, false));
+            return true;
+        }
+
+        p = SkipSpaces(after);
+        if (*p != '[') {
+            return false;
+        }
+        frame.dlc = static_cast<uint8_t>(strtoul(p + 1, &after, 10));
+        p = strchr(after, ']');
+        if (!p || frame.dlc > 8) {
+            return false;
+        }
+        p = SkipSpaces(p + 1);
+        if (strncmp(p, "remote request", 14) == 0) {
+            frame.rtr = true;
+            return true;
+        }
+        return ParseHexBytes(p, frame.data, frame.dlc, true) == frame.dlc;
+    }
+
+    auto ParseLine(const char *p, can_frame_t &frame) -> bool {
+        frame = {};
+        p = SkipSpaces(p);
+        frame.timestamp_us = last_timestamp_us;
+        if (*p == '(') {
+            char *after = nullptr;
+            long long seconds = strtoll(p + 1, &after, 10);
+            long long micros = 0;
+            if (*after == '.') {
+                const char *fraction = after + 1;
+                micros = strtoll(fraction, &after, 10);
+                for (ptrdiff_t digits = after - fraction; digits < 6; digits++) {
+                    micros *= 10;
+                }
+            }
+            frame.timestamp_us = seconds * 1000000 + micros;
+            p = strchr(after, ')');
+            if (!p) {
+                return false;
+            }
+            p = SkipSpaces(p + 1);
+        }
+
+        const char *name = p;
+        while (*p && !isspace(static_cast<unsigned char>(*p))) {
+            p++;
+        }
+        size_t name_len = p - name;
+        // The interface only takes a bus number once its line parsed, a malformed line does not use one up
+        if (name_len == 0 || !ParseFrame(SkipSpaces(p), frame)) {
+            return false;
+        }
+        int bus = BusOf(name, name_len);
+        if (bus < 0) {
+            return false;
+        }
+        frame.bus = static_cast<uint8_t>(bus);
+        return true;
+    }
+
+  public:
+    explicit CandumpSource(const char *path) : file(fopen(path, "r")) {}
+    ~CandumpSource() override {
+        if (file) {
+            fclose(file);
+        }
+    }
+    CandumpSource(const CandumpSource &) = delete;
+    auto operator=(const CandumpSource &) -> CandumpSource & = delete;
+
+    [[nodiscard]] auto IsOpen() const -> bool {
+        return file != nullptr;
+    }
+    [[nodiscard]] auto SkippedLines() const -> uint32_t {
+        return skipped_lines;
+    }
+
+    auto Next(can_frame_t &frame) -> bool override {
+        if (!file) {
+            return false;
+        }
+        while (fgets(line, sizeof(line), file)) {
+            if (ParseLine(line, frame)) {
+                last_timestamp_us = frame.timestamp_us;
+                return true;
+            }
+            if (line[0] != '\n' && line[0] != '#') {
+                skipped_lines++;
+            }
+        }
+        return false;
+    }
+
+    auto Rewind() -> bool override {
+        if (!file) {
+            return false;
+        }
+        rewind(file);
+        return true;
+    }
+};
+
+// Where FlightLogSource reads its blocks from, a copy of the storage partition on disk or the partition itself
+class FlightBlockStore {
+  public:
+    virtual ~FlightBlockStore() = default;
+    virtual auto BlockCount() -> uint32_t = 0;
+    // Reads the first len bytes of block index
+    virtual auto ReadBlock(uint32_t index, uint8_t *out, size_t len) -> bool = 0;
+};
+
+// Image of the storage partition, e.g. pulled with esptool.py read_flash
+class FlightLogFile : public FlightBlockStore {
+  private:
+    FILE *file{};
+    uint32_t block_count = 0;
+
+  public:
+    explicit FlightLogFile(const char *path) : file(fopen(path, "rb")) {
+        if (file && fseek(file, 0, SEEK_END) == 0) {
+            block_count = static_cast<uint32_t>(ftell(file) / static_cast<long>(flight_log::BLOCK_SIZE));
+        }
+    }
+    ~FlightLogFile() override {
+        if (file) {
+            fclose(file);
+        }
+    }
+    FlightLogFile(const FlightLogFile &) = delete;
+    auto operator=(const FlightLogFile &) -> FlightLogFile & = delete;
+
+    auto BlockCount() -> uint32_t override {
+        return block_count;
+    }
+    auto ReadBlock(uint32_t index, uint8_t *out, size_t len) -> bool override {
+        return file && fseek(file, static_cast<long>(index * flight_log::BLOCK_SIZE), SEEK_SET) == 0 &&
+               fread(out, 1, len, file) == len;
+    }
+};
+
+// Frames of a FlightRecorder log, oldest block first. The ring is walked once from the block after the newest.
+class FlightLogSource : public TraceSource {
+  private:
+    FlightBlockStore &store;
+    std::array<uint8_t, flight_log::BLOCK_SIZE> block{};
+    flight_log::BlockDecoder decoder;
+    uint32_t first_block = 0;
+    uint32_t blocks_read = 0;
+    uint32_t corrupt_blocks = 0;
+    bool in_block = false;
+
+    auto FindOldest() -> void {
+        uint32_t newest_sequence = 0;
+        bool found = false;
+        uint32_t count = store.BlockCount();
+        for (uint32_t i = 0; i < count; i++) {
+            flight_log::flight_block_header_t header;
+            if (!store.ReadBlock(i, block.data(), flight_log::HEADER_SIZE) ||
+                !flight_log::ReadHeader(block.data(), header)) {
+                continue;
+            }
+            if (!found || static_cast<int32_t>(header.sequence - newest_sequence) > 0) {
+                newest_sequence = header.sequence;
+                first_block = count ? (i + 1) % count : 0;
+                found = true;
+            }
+        }
+    }
+
+  public:
+    explicit FlightLogSource(FlightBlockStore &store) : store(store) {
+        FindOldest();
+    }
+
+    [[nodiscard]] auto CorruptBlocks() const -> uint32_t {
+        return corrupt_blocks;
+    }
+
+    auto Next(can_frame_t &frame) -> bool override {
+        uint32_t count = store.BlockCount();
+        while (true) {
+            if (in_block && decoder.Next(frame)) {
+                return true;
+            }
+            if (in_block && decoder.Corrupt()) {
+                corrupt_blocks++;
+            }
+            in_block = false;
+            if (blocks_read == count) {
+                return false;
+            }
+            uint32_t index = (first_block + blocks_read++) % count;
+            // Erased and torn sectors have no valid header and are skipped
+            in_block = store.ReadBlock(index, block.data(), block.size()) && decoder.Begin(block.data());
+        }
+    }
+
+    auto Rewind() -> bool override {
+        blocks_read = 0;
+        in_block = false;
+        return true;
+    }
+};
+
+#endif
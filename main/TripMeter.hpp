@@ -0,0 +1,131 @@
+#pragma once
+#ifndef TRIPMETER_HPP
+#define TRIPMETER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "CanSignals.hpp"
+#include "Crc32.hpp"
+#include "VehicleState.hpp"
+#include "gaugeMath.hpp"
+
+// Usable tank volume, FUEL is a percentage of it
+static constexpr uint32_t TANK_CAPACITY_ML = 63000;
+// A rise of the fuel level by more than this is a refuel, smaller ones are sloshing
+static constexpr int32_t REFUEL_PERCENT = 5;
+static constexpr uint64_t UM_PER_KM = 1000000000ULL;
+// The SPEED signal is in mph
+static constexpr uint64_t UM_PER_S_PER_MPH = 447040;
+
+// Persistent totals in fixed point, what goes to flash. 32 bytes without padding, crc covers everything before it.
+struct trip_record_t {
+    uint64_t odometer_um = 0;
+    uint64_t trip_um = 0;
+    uint32_t sequence = 0;
+    uint32_t fuel_used_ml = 0;
+    uint32_t trip_fuel_ml = 0;
+    uint32_t crc = 0;
+};
+static_assert(sizeof(trip_record_t) == 32, "trip_record_t is stored as is");
+
+inline auto TripRecordCrc(const trip_record_t &record) -> uint32_t {
+    return Crc32(&record, offsetof(trip_record_t, crc));
+}
+inline auto TripRecordValid(const trip_record_t &record) -> bool {
+    return record.crc == TripRecordCrc(record);
+}
+
+// Integrates distance from SPEED and fuel used from falls of the FUEL level, in RAM, from the receive timestamps of
+// the decoded values, so how often Update runs only changes the resolution. The car's ODO (whole km), once the
+// signal table decodes it, pins the odometer: the integrated value is kept inside the kilometre the car reports.
+// Fuel used counts drops below the lowest level seen since the last refuel, so sloshing up and down is not counted
+// twice. Single task.
+class TripMeter {
+  private:
+    trip_record_t totals{};
+    uint64_t distance_frac = 0; // um * 1e6 not yet in odometer_um, carried between updates
+    int64_t speed_rx_us = 0;
+    int32_t speed_mph = 0;
+    int32_t fuel_low_percent = -1;
+    uint32_t fuel_frac = 0; // ml * 100 not yet counted
+
+    auto AddDistance(int64_t dt_us) -> void {
+        if (dt_us <= 0 || speed_mph <= 0) {
+            return;
+        }
+        distance_frac += static_cast<uint64_t>(speed_mph) * UM_PER_S_PER_MPH * static_cast<uint64_t>(dt_us);
+        uint64_t um = distance_frac / 1000000;
+        distance_frac %= 1000000;
+        totals.odometer_um += um;
+        totals.trip_um += um;
+    }
+
+    auto AddFuelLevel(int32_t percent) -> void {
+        if (fuel_low_percent < 0 || percent > fuel_low_percent + REFUEL_PERCENT) {
+            fuel_low_percent = percent;
+            return;
+        }
+        if (percent >= fuel_low_percent) {
+            return;
+        }
+        fuel_frac += static_cast<uint32_t>(fuel_low_percent - percent) * TANK_CAPACITY_ML;
+        fuel_low_percent = percent;
+        totals.fuel_used_ml += fuel_frac / 100;
+        totals.trip_fuel_ml += fuel_frac / 100;
+        fuel_frac %= 100;
+    }
+
+    auto PinOdometer(int32_t odo_km) -> void {
+        if (odo_km <= 0) {
+            return;
+        }
+        uint64_t floor_um = static_cast<uint64_t>(odo_km) * UM_PER_KM;
+        if (totals.odometer_um < floor_um) {
+            totals.odometer_um = floor_um;
+        } else if (totals.odometer_um >= floor_um + UM_PER_KM) {
+            totals.odometer_um = floor_um + UM_PER_KM - 1;
+        }
+    }
+
+  public:
+    // Continues from a stored record
+    auto Restore(const trip_record_t &record) -> void {
+        totals = record;
+    }
+
+    // Feed the state of a SignalReader watching SPEED, FUEL and ODO after every Poll, changed tells which moved
+    auto Update(const vehicle_state_t &state, const vehicle_state_t &previous) -> void {
+        if (state.Changed(previous, Signal::SPEED)) {
+            int64_t rx_us = state.RxTime(Signal::SPEED);
+            // Piecewise constant: the previous speed held until this frame arrived. A gap longer than the gauge's
+            // stale deadline (ignition off, bus silent) is not driven at the last speed, integration restarts here.
+            if (speed_rx_us && rx_us - speed_rx_us <= SPEED_STALE_MS * 1000LL) {
+                AddDistance(rx_us - speed_rx_us);
+            }
+            speed_rx_us = rx_us;
+            speed_mph = state.Get(Signal::SPEED);
+        }
+        if (state.Changed(previous, Signal::FUEL)) {
+            AddFuelLevel(state.Get(Signal::FUEL));
+        }
+        if (state.Changed(previous, Signal::ODO)) {
+            PinOdometer(state.Get(Signal::ODO));
+        }
+    }
+
+    auto ResetTrip() -> void {
+        totals.trip_um = 0;
+        totals.trip_fuel_ml = 0;
+    }
+
+    // Receive time of the last speed value, 0 before the first
+    [[nodiscard]] auto LastSpeedUs() const -> int64_t {
+        return speed_rx_us;
+    }
+    [[nodiscard]] auto Totals() const -> const trip_record_t & {
+        return totals;
+    }
+};
+
+#endif
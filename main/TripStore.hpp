@@ -0,0 +1,204 @@
+#pragma once
+#ifndef TRIPSTORE_HPP
+#define TRIPSTORE_HPP
+
+#include <array>
+#include <atomic>
+#include <stdint.h>
+
+#include "esp_log.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#include "FrameCache.hpp"
+#include "Hal.hpp"
+#include "SeqLock.hpp"
+#include "TripMeter.hpp"
+#include "VehicleState.hpp"
+
+struct trip_store_stats_t {
+    uint32_t saves = 0;
+    uint32_t save_errors = 0;
+    uint64_t flash_bytes = 0; // NVS entries written, including the blob index and entry headers
+};
+
+// Write-behind persistence of the TripMeter totals in the nvs partition. A low priority task polls the frame cache,
+// integrates in RAM and saves a CRC-checked record only after SAVE_DISTANCE_UM driven, after SAVE_PERIOD_US with
+// anything unsaved, or when the speed frame stops (ignition off). Records alternate between two keys with a
+// sequence number, loading takes the newest one that passes its CRC, so a cut during a save costs at most that save.
+// NVS appends entries and erases a page only when it is full, a save is three 32 byte entries, so a 4 kB page
+// lasts about 40 km of driving. esp_restart() flushes through a shutdown handler. A brown-out gives no warning the
+// code can act on, it loses what was driven since the last save.
+class TripStore {
+  private:
+    static constexpr const char *NAMESPACE = "trip";
+    static constexpr std::array<const char *, 2> KEYS{"trip_a", "trip_b"};
+    static constexpr uint32_t POLL_MS = 200;
+    static constexpr uint64_t SAVE_DISTANCE_UM = UM_PER_KM;
+    static constexpr int64_t SAVE_PERIOD_US = 300000000;
+    static constexpr int64_t QUIET_US = 3000000;
+    static constexpr int64_t STATS_PERIOD_US = 600000000;
+    // Blob index entry + data entry header + one 32 byte span of payload
+    static constexpr uint32_t FLASH_BYTES_PER_SAVE = 3 * 32;
+
+    static inline TripStore *instance = nullptr;
+
+    SignalReader reader;
+    TripMeter meter;
+    vehicle_state_t previous{};
+    nvs_handle_t nvs{};
+    trip_record_t saved{};
+    int64_t saved_us = 0;
+    int64_t start_us = 0;
+    SeqLock<trip_record_t> published;
+    std::atomic<bool> reset_trip{false};
+    trip_store_stats_t stats{};
+
+    auto Load() -> bool {
+        bool found = false;
+        for (const char *key : KEYS) {
+            trip_record_t record;
+            size_t size = sizeof(record);
+            if (nvs_get_blob(nvs, key, &record, &size) != ESP_OK || size != sizeof(record) ||
+                !TripRecordValid(record)) {
+                continue;
+            }
+            if (!found || static_cast<int32_t>(record.sequence - saved.sequence) > 0) {
+                saved = record;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    auto Save(trip_record_t record) -> bool {
+        record.sequence = saved.sequence + 1;
+        record.crc = TripRecordCrc(record);
+        const char *key = KEYS[record.sequence % KEYS.size()];
+        esp_err_t err = nvs_set_blob(nvs, key, &record, sizeof(record));
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        if (err != ESP_OK) {
+            stats.save_errors++;
+            ESP_LOGE("TRIP", "Failed to save %s ERR: %s", key, esp_err_to_name(err));
+            return false;
+        }
+        saved = record;
+        stats.saves++;
+        stats.flash_bytes += FLASH_BYTES_PER_SAVE;
+        return true;
+    }
+
+    [[nodiscard]] auto Unsaved(const trip_record_t &totals) const -> bool {
+        return totals.odometer_um != saved.odometer_um || totals.trip_um != saved.trip_um ||
+               totals.fuel_used_ml != saved.fuel_used_ml || totals.trip_fuel_ml != saved.trip_fuel_ml;
+    }
+
+    [[nodiscard]] auto SaveDue(const trip_record_t &totals, int64_t now) const -> bool {
+        if (!Unsaved(totals)) {
+            return false;
+        }
+        if (totals.odometer_um - saved.odometer_um >= SAVE_DISTANCE_UM || now - saved_us >= SAVE_PERIOD_US) {
+            return true;
+        }
+        return meter.LastSpeedUs() && now - meter.LastSpeedUs() >= QUIET_US;
+    }
+
+    auto LogStats(int64_t now) const -> void {
+        const trip_record_t &totals = meter.Totals();
+        int64_t uptime_us = now - start_us;
+        uint64_t per_hour = uptime_us > 0 ? stats.flash_bytes * 3600000000ULL / uptime_us : 0;
+        ESP_LOGI("TRIP", "odometer: %llu m trip: %llu m fuel used: %lu ml trip fuel: %lu ml",
+                 totals.odometer_um / 1000000, totals.trip_um / 1000000, totals.fuel_used_ml, totals.trip_fuel_ml);
+        ESP_LOGI("TRIP", "saves: %lu errors: %lu flash bytes: %llu bytes/hour: %llu", stats.saves, stats.save_errors,
+                 stats.flash_bytes, per_hour);
+    }
+
+    static void storeTask(void *task_param) {
+        auto *self = static_cast<TripStore *>(task_param);
+        int64_t last_stats = hal::NowUs();
+        while (true) {
+            hal::SleepMs(POLL_MS);
+            if (self->reader.Poll()) {
+                self->meter.Update(self->reader.State(), self->previous);
+                self->previous = self->reader.State();
+            }
+            if (self->reset_trip.exchange(false)) {
+                self->meter.ResetTrip();
+            }
+            const trip_record_t &totals = self->meter.Totals();
+            self->published.Write([&](trip_record_t &record) { record = totals; });
+
+            int64_t now = hal::NowUs();
+            if (self->SaveDue(totals, now) && self->Save(totals)) {
+                self->saved_us = now;
+            }
+            if (now - last_stats >= STATS_PERIOD_US) {
+                last_stats = now;
+                self->LogStats(now);
+            }
+        }
+    }
+
+    // Runs in the task calling esp_restart(), with the store task still alive, so it saves the published copy
+    static void shutdownHandler() {
+        trip_record_t totals;
+        instance->published.Read(totals);
+        if (instance->Unsaved(totals)) {
+            instance->Save(totals);
+        }
+    }
+
+  public:
+    explicit TripStore(const FrameCache &cache)
+        : reader(cache, SignalBit(Signal::SPEED) | SignalBit(Signal::FUEL) | SignalBit(Signal::ODO)) {}
+
+    TripStore(const TripStore &) = delete;
+    auto operator=(const TripStore &) -> TripStore & = delete;
+
+    // Opens NVS, restores the newest valid record and starts the store task. One instance.
+    auto Start(UBaseType_t priority, BaseType_t core) -> bool {
+        esp_err_t err = nvs_flash_init();
+        if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+            ESP_LOGE("TRIP", "NVS partition unreadable (%s), erasing it", esp_err_to_name(err));
+            nvs_flash_erase();
+            err = nvs_flash_init();
+        }
+        if (err == ESP_OK) {
+            err = nvs_open(NAMESPACE, NVS_READWRITE, &nvs);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE("TRIP", "Failed to open NVS ERR: %s, trip totals will not persist", esp_err_to_name(err));
+            return false;
+        }
+        if (Load()) {
+            meter.Restore(saved);
+            ESP_LOGI("TRIP", "Restored record %lu, odometer %llu m", saved.sequence, saved.odometer_um / 1000000);
+        } else {
+            ESP_LOGI("TRIP", "No saved trip record, starting from zero");
+        }
+        start_us = hal::NowUs();
+        saved_us = start_us;
+        instance = this;
+        esp_register_shutdown_handler(shutdownHandler);
+        return xTaskCreatePinnedToCore(storeTask, "TRIP TASK", 3072, this, priority, nullptr, core) == pdPASS;
+    }
+
+    // Any task, applied at the store task's next poll
+    auto ResetTrip() -> void {
+        reset_trip = true;
+    }
+
+    // Latest totals, from any task
+    [[nodiscard]] auto Totals() const -> trip_record_t {
+        trip_record_t totals;
+        published.Read(totals);
+        return totals;
+    }
+};
+
+#endif
@@ -0,0 +1,227 @@
+#pragma once
+#ifndef TWAIBUS_HPP
+#define TWAIBUS_HPP
+
+#include <string.h>
+
+#include "driver/twai.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "CanBusConfig.hpp"
+#include "CanFilter.hpp"
+#include "CanFrame.hpp"
+#include "CanReceiver.hpp"
+#include "CanRecovery.hpp"
+#include "CanRxBackend.hpp"
+
+// Alerts every receive controller raises for CanRecovery, on top of TWAI_ALERT_RX_DATA
+static constexpr uint32_t TWAI_RECOVERY_ALERTS = TWAI_ALERT_BUS_OFF | TWAI_ALERT_BUS_RECOVERED | TWAI_ALERT_ERR_PASS |
+                                                 TWAI_ALERT_ABOVE_ERR_WARN | TWAI_ALERT_ERR_ACTIVE |
+                                                 TWAI_ALERT_RX_QUEUE_FULL | TWAI_ALERT_RX_FIFO_OVERRUN |
+                                                 TWAI_ALERT_ARB_LOST | TWAI_ALERT_BUS_ERROR;
+
+inline auto TwaiToFrame(const twai_message_t &message, uint8_t bus, can_frame_t &frame) -> void {
+    frame.timestamp_us = esp_timer_get_time();
+    frame.identifier = message.identifier;
+    frame.dlc = message.data_length_code > 8 ? 8 : message.data_length_code;
+    frame.bus = bus;
+    frame.extd = message.extd;
+    frame.rtr = message.rtr;
+    memcpy(frame.data, message.data, sizeof(frame.data));
+}
+
+inline auto TwaiFromFrame(const can_frame_t &frame) -> twai_message_t {
+    twai_message_t message{};
+    message.identifier = frame.identifier;
+    message.data_length_code = frame.dlc;
+    message.extd = frame.extd;
+    message.rtr = frame.rtr;
+    memcpy(message.data, frame.data, sizeof(message.data));
+    return message;
+}
+
+inline auto TwaiHealth(const twai_status_info_t &status) -> can_controller_health_t {
+    can_controller_health_t health;
+    switch (status.state) {
+    case TWAI_STATE_RUNNING:
+        health.state = CanStateFromCounters(status.tx_error_counter, status.rx_error_counter);
+        break;
+    case TWAI_STATE_BUS_OFF:
+        health.state = CanControllerState::BUS_OFF;
+        break;
+    case TWAI_STATE_RECOVERING:
+        health.state = CanControllerState::RECOVERING;
+        break;
+    default:
+        health.state = CanControllerState::STOPPED;
+        break;
+    }
+    health.tx_errors = status.tx_error_counter;
+    health.rx_errors = status.rx_error_counter;
+    health.bus_errors = status.bus_error_count;
+    health.rx_missed = status.rx_missed_count;
+    health.rx_overrun = status.rx_overrun_count;
+    health.arb_lost = status.arb_lost_count;
+    return health;
+}
+
+inline auto TwaiAlerts(uint32_t twai_alerts) -> uint32_t {
+    uint32_t alerts = 0;
+    alerts |= (twai_alerts & TWAI_ALERT_BUS_OFF) ? CAN_ALERT_BUS_OFF : 0;
+    alerts |= (twai_alerts & TWAI_ALERT_BUS_RECOVERED) ? CAN_ALERT_BUS_RECOVERED : 0;
+    alerts |= (twai_alerts & TWAI_ALERT_ERR_PASS) ? CAN_ALERT_ERROR_PASSIVE : 0;
+    alerts |= (twai_alerts & TWAI_ALERT_ABOVE_ERR_WARN) ? CAN_ALERT_ERROR_WARNING : 0;
+    alerts |= (twai_alerts & TWAI_ALERT_ERR_ACTIVE) ? CAN_ALERT_ERROR_ACTIVE : 0;
+    alerts |= (twai_alerts & TWAI_ALERT_RX_QUEUE_FULL) ? CAN_ALERT_RX_QUEUE_FULL : 0;
+    alerts |= (twai_alerts & TWAI_ALERT_RX_FIFO_OVERRUN) ? CAN_ALERT_RX_FIFO_OVERRUN : 0;
+    alerts |= (twai_alerts & TWAI_ALERT_ARB_LOST) ? CAN_ALERT_ARB_LOST : 0;
+    alerts |= (twai_alerts & TWAI_ALERT_BUS_ERROR) ? CAN_ALERT_BUS_ERROR : 0;
+    return alerts;
+}
+
+// CanController on a legacy TWAI driver handle, the handle is read at every call so it can be installed later
+class TwaiController : public CanController {
+  private:
+    const twai_handle_t &handle;
+
+  public:
+    explicit TwaiController(const twai_handle_t &handle) : handle(handle) {}
+
+    auto InitiateRecovery() -> bool override {
+        return twai_initiate_recovery_v2(handle) == ESP_OK;
+    }
+    auto Start() -> bool override {
+        return twai_start_v2(handle) == ESP_OK;
+    }
+    auto State() -> CanControllerState override {
+        twai_status_info_t status{};
+        if (twai_get_status_info_v2(handle, &status) != ESP_OK) {
+            return CanControllerState::STOPPED;
+        }
+        return TwaiHealth(status).state;
+    }
+};
+
+inline auto TwaiTiming(uint32_t bitrate) -> twai_timing_config_t {
+    switch (bitrate) {
+    case 125000:
+        return TWAI_TIMING_CONFIG_125KBITS();
+    case 250000:
+        return TWAI_TIMING_CONFIG_250KBITS();
+    case 1000000:
+        return TWAI_TIMING_CONFIG_1MBITS();
+    case 500000:
+        return TWAI_TIMING_CONFIG_500KBITS();
+    default:
+        ESP_LOGE("CAN FATAL", "Unsupported bitrate %lu, using 500 kbit/s", bitrate);
+        return TWAI_TIMING_CONFIG_500KBITS();
+    }
+}
+
+inline auto TwaiFilter(const can_filter_t &filter) -> twai_filter_config_t {
+    return {
+        .acceptance_code = filter.acceptance_code,
+        .acceptance_mask = filter.acceptance_mask,
+        .single_filter = filter.single_filter,
+    };
+}
+
+// Receive backend on the legacy TWAI driver for buses beyond the first. A small pump task drains the driver
+// queue into the ring so each bus has its own lock-free stream for CanMerger.
+class TwaiQueueBackend : public CanRxBackend {
+  private:
+    static constexpr uint32_t rx_queue_len = 64;
+
+    static constexpr uint32_t recovery_poll_ms = 20; // alert wait while a recovery is pending, see CanRecovery::Poll
+
+    twai_handle_t handle{};
+    uint8_t bus;
+    can_rx_ring_t ring;
+    TaskHandle_t consumer{};
+    TwaiController controller{handle};
+    CanRecovery recovery;
+
+    static void pumpTask(void *task_param) {
+        auto *self = static_cast<TwaiQueueBackend *>(task_param);
+        twai_message_t message{};
+        while (true) {
+            uint32_t alerts = 0;
+            TickType_t wait = self->recovery.Recovering() ? pdMS_TO_TICKS(recovery_poll_ms) : portMAX_DELAY;
+            bool alerted = twai_read_alerts_v2(self->handle, &alerts, wait) == ESP_OK;
+            self->recovery.HandleAlerts(alerted ? TwaiAlerts(alerts) : 0, esp_timer_get_time());
+            self->recovery.Poll(esp_timer_get_time());
+            if (!alerted) {
+                continue;
+            }
+            bool received = false;
+            while (twai_receive_v2(self->handle, &message, 0) == ESP_OK) {
+                if (can_frame_t *slot = self->ring.Reserve()) {
+                    TwaiToFrame(message, self->bus, *slot);
+                    self->ring.Commit();
+                    received = true;
+                }
+            }
+            if (received && self->consumer) {
+                xTaskNotifyGive(self->consumer);
+            }
+        }
+    }
+
+  public:
+    TwaiQueueBackend(uint8_t bus, const can_bus_config_t &config, bool accept_all, UBaseType_t priority,
+                     BaseType_t core)
+        : bus(bus), recovery(controller, bus == 0 ? "bus 0" : "bus 1") {
+        twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT(static_cast<gpio_num_t>(config.tx_pin),
+                                                                    static_cast<gpio_num_t>(config.rx_pin),
+                                                                    TWAI_MODE_NORMAL);
+        general.controller_id = config.controller;
+        general.rx_queue_len = rx_queue_len;
+        general.alerts_enabled = TWAI_ALERT_RX_DATA | TWAI_RECOVERY_ALERTS;
+        twai_timing_config_t timing = TwaiTiming(config.bitrate);
+        twai_filter_config_t filter =
+            accept_all ? twai_filter_config_t TWAI_FILTER_CONFIG_ACCEPT_ALL() : TwaiFilter(BusRxFilter(bus));
+
+        if (esp_err_t err = twai_driver_install_v2(&general, &timing, &filter, &handle); err != ESP_OK) {
+            ESP_LOGE("CAN FATAL", "Failed to install twai driver for bus %u ERR: %s", bus, esp_err_to_name(err));
+            return;
+        }
+        if (esp_err_t err = twai_start_v2(handle); err != ESP_OK) {
+            ESP_LOGE("CAN FATAL", "Failed to start twai driver for bus %u ERR: %s", bus, esp_err_to_name(err));
+            return;
+        }
+        xTaskCreatePinnedToCore(pumpTask, "CAN RX PUMP", 2048, this, priority, nullptr, core);
+    }
+
+    auto WaitForFrames(uint32_t timeout_ms) -> bool override {
+        if (!consumer) {
+            consumer = xTaskGetCurrentTaskHandle();
+        }
+        if (ring.Size()) {
+            return true;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+        return ring.Size() != 0;
+    }
+
+    auto Ring() -> can_rx_ring_t & override {
+        return ring;
+    }
+
+    auto ControllerHealth(can_controller_health_t &health) -> bool override {
+        twai_status_info_t status{};
+        if (twai_get_status_info_v2(handle, &status) != ESP_OK) {
+            return false;
+        }
+        health = TwaiHealth(status);
+        return true;
+    }
+
+    auto Recovery() -> CanRecovery * override {
+        return &recovery;
+    }
+};
+
+#endif
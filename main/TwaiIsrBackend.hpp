@@ -0,0 +1,149 @@
+#pragma once
+#ifndef TWAIISRBACKEND_HPP
+#define TWAIISRBACKEND_HPP
+
+// ISR level receive backend, needs the callback based TWAI driver (esp_driver_twai, ESP-IDF 5.5 and newer).
+// The legacy driver used by CanConnect copies every frame through its own FreeRTOS queue and has no RX hook.
+#if __has_include("esp_twai_onchip.h")
+#define CAN_HAS_ISR_BACKEND 1
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_twai.h"
+#include "esp_twai_onchip.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "CanBusConfig.hpp"
+#include "CanFilter.hpp"
+#include "CanReceiver.hpp"
+#include "CanRxBackend.hpp"
+
+// Frames go from the RX done interrupt straight into the ring. Their timestamps are esp_timer_get_time() read in
+// that ISR, not a controller timestamp (the TWAI controller has none): they include the interrupt latency, and frames
+// drained from the hardware FIFO in one burst get nearly the same time.
+class TwaiIsrBackend : public CanRxBackend {
+  private:
+    twai_node_handle_t node{};
+    can_rx_ring_t ring;
+    TaskHandle_t consumer{};
+    uint8_t bus;
+
+    // Runs in the TWAI ISR, the driver copies the payload straight into the reserved ring slot
+    static auto IRAM_ATTR OnRxDone(twai_node_handle_t handle, const twai_rx_done_event_data_t * /*edata*/,
+                                   void *user_ctx) -> bool {
+        auto *self = static_cast<TwaiIsrBackend *>(user_ctx);
+        can_frame_t *slot = self->ring.Reserve();
+        if (!slot) {
+            uint8_t discard[8];
+            twai_frame_t frame = {.buffer = discard, .buffer_len = sizeof(discard)};
+            twai_node_receive_from_isr(handle, &frame);
+            return false;
+        }
+
+        twai_frame_t frame = {.buffer = slot->data, .buffer_len = sizeof(slot->data)};
+        if (twai_node_receive_from_isr(handle, &frame) != ESP_OK) {
+            return false;
+        }
+        slot->timestamp_us = esp_timer_get_time();
+        slot->identifier = frame.header.id;
+        slot->dlc = frame.header.dlc;
+        slot->bus = self->bus;
+        slot->extd = frame.header.ide;
+        slot->rtr = frame.header.rtr;
+        self->ring.Commit();
+
+        BaseType_t woken = pdFALSE;
+        if (self->consumer) {
+            vTaskNotifyGiveFromISR(self->consumer, &woken);
+        }
+        return woken == pdTRUE;
+    }
+
+    // Mask filter 0 of the node, one filter half each in dual mode. It has no RTR bit, remote frames on a passed ID
+    // reach the ring and are dropped by the decoder.
+    auto ConfigureFilter(const can_filter_t &filter) -> void {
+        can_filter::id_match_t first = can_filter::IdMatch(filter);
+        twai_mask_filter_config_t mask_filter{};
+        if (filter.single_filter) {
+            mask_filter.id = first.id;
+            mask_filter.mask = first.compared;
+        } else {
+            can_filter::id_match_t second = can_filter::IdMatch(filter, true);
+            mask_filter = twai_make_dual_filter(first.id, first.compared, second.id, second.compared, false);
+        }
+        if (esp_err_t err = twai_node_config_mask_filter(node, 0, &mask_filter); err != ESP_OK) {
+            ESP_LOGE("CAN FATAL", "Failed to set TWAI RX filter for bus %u ERR: %s", bus, esp_err_to_name(err));
+        }
+    }
+
+  public:
+    // The onchip driver picks a free controller itself, config.controller is not used. Without accept_all the node
+    // only passes the IDs of BusRxFilter(bus), see TwaiQueueBackend.
+    TwaiIsrBackend(uint8_t bus, const can_bus_config_t &config, bool accept_all) : bus(bus) {
+        twai_onchip_node_config_t node_config = {};
+        node_config.io_cfg.tx = static_cast<gpio_num_t>(config.tx_pin);
+        node_config.io_cfg.rx = static_cast<gpio_num_t>(config.rx_pin);
+        node_config.io_cfg.quanta_clk_out = GPIO_NUM_NC;
+        node_config.io_cfg.bus_off_indicator = GPIO_NUM_NC;
+        node_config.bit_timing.bitrate = config.bitrate;
+        node_config.tx_queue_depth = 1;
+
+        if (esp_err_t err = twai_new_node_onchip(&node_config, &node); err != ESP_OK) {
+            ESP_LOGE("CAN FATAL", "Failed to create TWAI RX node for bus %u ERR: %s", bus, esp_err_to_name(err));
+            return;
+        }
+        if (!accept_all) {
+            ConfigureFilter(BusRxFilter(bus));
+        }
+        twai_event_callbacks_t callbacks = {};
+        callbacks.on_rx_done = OnRxDone;
+        twai_node_register_event_callbacks(node, &callbacks, this);
+        if (esp_err_t err = twai_node_enable(node); err != ESP_OK) {
+            ESP_LOGE("CAN FATAL", "Failed to enable TWAI RX node for bus %u ERR: %s", bus, esp_err_to_name(err));
+        }
+    }
+
+    auto WaitForFrames(uint32_t timeout_ms) -> bool override {
+        if (!consumer) {
+            consumer = xTaskGetCurrentTaskHandle();
+        }
+        if (ring.Size()) {
+            return true;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+        return ring.Size() != 0;
+    }
+
+    auto Ring() -> can_rx_ring_t & override {
+        return ring;
+    }
+
+    // The onchip driver has no miss or overrun counts, frames dropped on a full ring show up in CanMerger::Dropped
+    auto ControllerHealth(can_controller_health_t &health) -> bool override {
+        twai_node_status_t status{};
+        twai_node_record_t record{};
+        if (twai_node_get_info(node, &status, &record) != ESP_OK) {
+            return false;
+        }
+        switch (status.state) {
+        case TWAI_ERROR_BUS_OFF:
+            health.state = CanControllerState::BUS_OFF;
+            break;
+        default:
+            health.state = CanStateFromCounters(status.tx_error_count, status.rx_error_count);
+            break;
+        }
+        health.tx_errors = status.tx_error_count;
+        health.rx_errors = status.rx_error_count;
+        health.bus_errors = record.bus_err_num;
+        return true;
+    }
+};
+
+#else
+#define CAN_HAS_ISR_BACKEND 0
+#endif
+
+#endif
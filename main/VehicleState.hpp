@@ -0,0 +1,92 @@
+#pragma once
+#ifndef VEHICLESTATE_HPP
+#define VEHICLESTATE_HPP
+
+#include <array>
+#include <stdint.h>
+
+#include "CanSignals.hpp"
+#include "FrameCache.hpp"
+
+// Latest decoded value of every signal, with the time it was received and how many times it has been updated
+struct vehicle_state_t {
+    std::array<int32_t, SIGNAL_COUNT> value{};
+    std::array<int64_t, SIGNAL_COUNT> rx_time_us{};
+    std::array<uint32_t, SIGNAL_COUNT> generation{};
+
+    [[nodiscard]] auto Get(Signal signal) const -> int32_t {
+        return value[static_cast<size_t>(signal)];
+    }
+    [[nodiscard]] auto RxTime(Signal signal) const -> int64_t {
+        return rx_time_us[static_cast<size_t>(signal)];
+    }
+    [[nodiscard]] auto Generation(Signal signal) const -> uint32_t {
+        return generation[static_cast<size_t>(signal)];
+    }
+    [[nodiscard]] auto Changed(const vehicle_state_t &previous, Signal signal) const -> bool {
+        return Generation(signal) != previous.Generation(signal);
+    }
+};
+
+struct signal_reader_stats_t {
+    uint32_t frames_decoded = 0;
+    uint32_t frames_superseded = 0; // arrivals that were overwritten in the cache before this reader looked
+};
+
+// Lazy per-consumer view of the frame cache. Poll() decodes only frames that carry a signal in signal_mask and
+// whose cache slot moved since the last poll, a signal's generation is the arrival count of its frame.
+class SignalReader {
+  private:
+    const FrameCache &cache;
+    uint32_t signal_mask;
+    vehicle_state_t state{};
+    std::array<uint32_t, CanDecoder::frame_count> seen{};
+    signal_reader_stats_t stats{};
+
+  public:
+    explicit SignalReader(const FrameCache &cache, uint32_t signal_mask = ALL_SIGNALS)
+        : cache(cache), signal_mask(signal_mask) {}
+
+    // Returns true if any watched signal changed
+    auto Poll() -> bool {
+        bool changed = false;
+        for (size_t frame = 0; frame < CanDecoder::frame_count; frame++) {
+            if (!(CanDecoder::frame_signal_masks[frame] & signal_mask)) {
+                continue;
+            }
+            uint32_t key = CanDecoder::frame_keys[frame];
+            if (cache.Generation(key) == seen[frame]) {
+                continue;
+            }
+
+            can_slot_t slot;
+            uint32_t generation = cache.Read(key, slot);
+            stats.frames_superseded += generation - seen[frame] - 1;
+            seen[frame] = generation;
+
+            decoded_signals_t signals;
+            CanDecoder::Decode(CanKeyBus(key), CanKeyId(key), slot.data, slot.dlc, signals);
+            stats.frames_decoded++;
+            uint32_t watched = signals.updated & signal_mask;
+            for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+                if (watched & (1U << i)) {
+                    state.value[i] = signals.value[i];
+                    state.rx_time_us[i] = slot.rx_time_us;
+                    state.generation[i] = generation;
+                }
+            }
+            changed = changed || watched;
+        }
+        return changed;
+    }
+
+    [[nodiscard]] auto State() const -> const vehicle_state_t & {
+        return state;
+    }
+
+    [[nodiscard]] auto GetStats() const -> const signal_reader_stats_t & {
+        return stats;
+    }
+};
+
+#endif
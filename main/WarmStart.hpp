@@ -0,0 +1,99 @@
+#pragma once
+#ifndef WARMSTART_HPP
+#define WARMSTART_HPP
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_log.h"
+
+#include "CanSignals.hpp"
+#include "Crc32.hpp"
+#include "VehicleState.hpp"
+
+// Last values the dash showed, crc covers everything before it. Trivial, so a static one is never initialised.
+struct warm_snapshot_t {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t signals; // bit per Signal with a value
+    std::array<int32_t, SIGNAL_COUNT> value;
+    uint32_t crc;
+};
+
+// Two snapshots written alternately, a reset in the middle of a write leaves the other one intact. Lives in RAM the
+// startup code does not clear (__NOINIT_ATTR on the device), so it holds garbage after a power-on.
+struct warm_region_t {
+    std::array<warm_snapshot_t, 2> slots;
+};
+
+// Mirrors the displayed vehicle state into a warm_region_t and hands it back after a reset that kept RAM (watchdog,
+// panic, brown-out, esp_restart), so the dash can paint the last-known values on its first frame instead of
+// sweeping the gauges and waiting for frames. A snapshot only counts when its magic and CRC check out, anything
+// else is a cold boot. Mirror from the task that shows the values.
+class WarmStart {
+  private:
+    static constexpr uint32_t MAGIC = 0x57524D31; // "WRM1", changes with the layout
+
+    warm_region_t &region;
+    warm_snapshot_t current{};
+    bool warm = false;
+
+    static auto Crc(const warm_snapshot_t &snapshot) -> uint32_t {
+        return Crc32(&snapshot, offsetof(warm_snapshot_t, crc));
+    }
+    static auto Valid(const warm_snapshot_t &snapshot) -> bool {
+        return snapshot.magic == MAGIC && snapshot.crc == Crc(snapshot);
+    }
+
+  public:
+    // ram_kept: the reset left RAM powered, the caller knows the reset reason
+    WarmStart(warm_region_t &region, bool ram_kept) : region(region) {
+        const warm_snapshot_t *newest = nullptr;
+        for (const warm_snapshot_t &snapshot : region.slots) {
+            if (ram_kept && Valid(snapshot) &&
+                (!newest || static_cast<int32_t>(snapshot.sequence - newest->sequence) > 0)) {
+                newest = &snapshot;
+            }
+        }
+        if (newest && newest->signals) {
+            current = *newest;
+            warm = true;
+            ESP_LOGI("UI", "Warm boot, restored snapshot %lu", current.sequence);
+        } else {
+            current.magic = MAGIC;
+            current.signals = 0;
+            region.slots = {};
+        }
+    }
+
+    WarmStart(const WarmStart &) = delete;
+    auto operator=(const WarmStart &) -> WarmStart & = delete;
+
+    [[nodiscard]] auto Warm() const -> bool {
+        return warm;
+    }
+    // Signals the snapshot had a value for, 0 on a cold boot
+    [[nodiscard]] auto RestoredSignals() const -> uint32_t {
+        return warm ? current.signals : 0;
+    }
+    [[nodiscard]] auto Restored(Signal signal) const -> int32_t {
+        return current.value[static_cast<size_t>(signal)];
+    }
+
+    // Copies the received values among signals into the older slot, the restored ones stay until live data replaces
+    // them. Under 50 bytes and a CRC over them.
+    auto Mirror(const vehicle_state_t &state, uint32_t signals) -> void {
+        for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+            if ((signals & (1U << i)) && state.rx_time_us[i]) {
+                current.value[i] = state.value[i];
+                current.signals |= 1U << i;
+            }
+        }
+        current.sequence++;
+        current.crc = Crc(current);
+        region.slots[current.sequence % region.slots.size()] = current;
+    }
+};
+
+#endif
@@ -41,4 +41,10 @@ static constexpr int32_t FUEL_LABEL_OFFSET_Y = 210;
 static constexpr int32_t TEMP_LABEL_OFFSET_Y = 225;
 static constexpr int32_t LABEL_OFFSET_X = 0;
 
+// A gauge greys out when its source frame has been silent this long, a few missed periods of the frame
+static constexpr int32_t RPM_STALE_MS = 500;
+static constexpr int32_t SPEED_STALE_MS = 500;
+static constexpr int32_t FUEL_STALE_MS = 2000;
+static constexpr int32_t TEMP_STALE_MS = 2000;
+
 #endif
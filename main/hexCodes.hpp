@@ -6,5 +6,6 @@
 static constexpr uint32_t GAUGE_COLOR = 0xfeb822;
 static constexpr uint32_t LAZER_BLUE = 0x1D75AB;
 static constexpr uint32_t BG_COLOR = 0xa7a7a7;
+static constexpr uint8_t STALE_OPA = 77; // LV_OPA_30, gauges without a current value
 
 #endif
@@ -1,99 +1,206 @@
-#include "bsp/esp32_p4_wifi6_touch_lcd_xc.h"
-#include "freertos/idf_additions.h"
-#include "freertos/projdefs.h"
-#include "lvgl.h"
+#include "esp_attr.h"
+#include "esp_system.h"
 
-#include "MainDisplay.hpp"
+#include "AssetStore.hpp"
+#include "BootProfile.hpp"
+#include "BootSplash.hpp"
 #include "CanConnect.hpp"
+#include "CanGateway.hpp"
+#include "DashboardUi.hpp"
+#include "FlightRecorder.hpp"
+#include "FrameCache.hpp"
+#include "Hal.hpp"
+#include "LatencyConsole.hpp"
+#include "ReplayBackend.hpp"
+#include "TripStore.hpp"
+#include "TwaiIsrBackend.hpp"
+#include "WarmStart.hpp"
 
-static void lvglInit() {
-    bsp_display_cfg_t cfg = {.lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
-                             .buffer_size = BSP_LCD_DRAW_BUFF_SIZE,
-                             .double_buffer = BSP_LCD_DRAW_BUFF_DOUBLE,
-                             .flags = {
-                                 .buff_dma = true,
-                                 .buff_spiram = false,
-                                 .sw_rotate = false,
-                             }};
-    bsp_display_start_with_config(&cfg);
-    bsp_display_backlight_on();
-    bsp_display_brightness_set(100);
-    lv_obj_remove_flag(lv_screen_active(), LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_size(lv_screen_active(), 720, 720);
-    lv_obj_set_style_bg_color(lv_screen_active(), lv_color_hex(0x000000), 0);
+// Opt in to the ISR ring receive backend, needs the esp_driver_twai callback API (ESP-IDF 5.5+)
+#ifndef CAN_RX_ISR_BACKEND
+#define CAN_RX_ISR_BACKEND 0
+#endif
+#if CAN_RX_ISR_BACKEND && !CAN_HAS_ISR_BACKEND
+#error "CAN_RX_ISR_BACKEND needs esp_twai_onchip.h (ESP-IDF 5.5 or newer)"
+#endif
+
+// Forward the RX bus onto controller 1 through CanGateway
+#ifndef CAN_GATEWAY_ENABLE
+#define CAN_GATEWAY_ENABLE 0
+#endif
+
+// Demo mode without a car, loops the flight recorder log in the storage partition through the RX path
+#ifndef CAN_REPLAY_DEMO
+#define CAN_REPLAY_DEMO 0
+#endif
+
+// Record every received frame to the storage partition through FlightRecorder
+#ifndef CAN_RECORDER_ENABLE
+#define CAN_RECORDER_ENABLE !CAN_REPLAY_DEMO
+#endif
+#if CAN_REPLAY_DEMO && CAN_RECORDER_ENABLE
+#error "CAN_REPLAY_DEMO replays the partition CAN_RECORDER_ENABLE writes to"
+#endif
+
+static FrameCache frame_cache;
+static CanGateway gateway;
+static FlightRecorder recorder;
+static LatencyTable latency;
+static TripStore trip(frame_cache);
+// Survives the resets that keep RAM powered, WarmStart checks it before use
+static __NOINIT_ATTR warm_region_t warm_region;
+// esp_timer starts with the app, so the phases do not include the bootloader
+static BootProfile boot(0);
+static BootSplash splash("splash");
+static AssetStore assets;
+
+static constexpr int64_t STATS_PERIOD_US = 10000000;
+
+static void logRxStats(const can_rx_stats_t &stats) {
+    uint32_t avg_batch = stats.batches ? stats.frames / stats.batches : 0;
+    ESP_LOGI("CAN RX", "frames: %lu batches: %lu avg/batch: %lu max/batch: %lu queue hw: %lu full: %lu missed: %lu overrun: %lu sw rejected: %lu",
+             stats.frames, stats.batches, avg_batch, stats.max_batch, stats.queue_high_water,
+             stats.queue_full_events, stats.rx_missed, stats.rx_overrun, stats.sw_rejected);
+}
+
+static void logMergeStats(const can_merge_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++) {
+        ESP_LOGI("CAN RX", "bus %u frames: %lu", bus, stats->frames[bus]);
+    }
+    ESP_LOGI("CAN RX", "merged out of order: %lu", stats->out_of_order);
+}
+
+static void logControllerHealth(CanConnect &CAN) {
+    for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++) {
+        can_controller_health_t health;
+        if (!CAN.ControllerHealth(bus, health)) {
+            continue;
+        }
+        ESP_LOGI("CAN RX", "bus %u state: %s TEC: %lu REC: %lu bus errors: %lu missed: %lu overrun: %lu arb lost: %lu",
+                 bus, CAN_CONTROLLER_STATE_NAMES[static_cast<uint8_t>(health.state)], health.tx_errors,
+                 health.rx_errors, health.bus_errors, health.rx_missed, health.rx_overrun, health.arb_lost);
+    }
 }
 
-static QueueHandle_t can_queue;
-using can_data_t = struct {
-    uint16_t rpm_value;
-    uint8_t speed_value;
-    uint8_t fuel_value;
-    uint16_t temp_value;
-};
+// Resets after which RAM may still hold the snapshot, the CRC catches what a brown-out corrupted
+static bool ramKept(esp_reset_reason_t reason) {
+    switch (reason) {
+    case ESP_RST_SW:
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+    case ESP_RST_BROWNOUT:
+    case ESP_RST_PWR_GLITCH:
+        return true;
+    default:
+        return false;
+    }
+}
 
 extern "C" void can_task(void * /*task_param*/) {
-    CanConnect CAN;
-    static can_data_t can_data;
+#if CAN_REPLAY_DEMO
+    static FlightLogPartition replay_log("storage");
+    static FlightLogSource replay_trace(replay_log);
+    static ReplayBackend replay(replay_trace, 1.0f, true);
+    can_rx_backends_t backends{};
+    backends[0] = &replay;
+    CanConnect CAN(backends, CAN_GATEWAY_ENABLE);
+#elif CAN_RX_ISR_BACKEND
+    static std::array<std::unique_ptr<TwaiIsrBackend>, CAN_BUS_COUNT> rx_backends;
+    can_rx_backends_t backends{};
+    for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++) {
+        rx_backends[bus] = std::make_unique<TwaiIsrBackend>(bus, CAN_RX_BUSES[bus], CAN_GATEWAY_ENABLE);
+        backends[bus] = rx_backends[bus].get();
+    }
+    CanConnect CAN(backends, CAN_GATEWAY_ENABLE);
+#else
+    CanConnect CAN(CAN_GATEWAY_ENABLE);
+#endif
+    if (CAN_GATEWAY_ENABLE) {
+        gateway.Start(CAN, 4, 0);
+    }
+    if (CAN_RECORDER_ENABLE) {
+        recorder.Start("storage", 1, 0);
+    }
+    int64_t last_stats = hal::NowUs();
 
     while (true) {
-        if (!CAN.ReceiveFrame()) {
-            continue; // Cancel the rest
+        // Only the raw payload is cached here, consumers decode what they display when they look at it
+        CAN.ReceiveBatch([](const can_frame_t &frame) {
+            frame_cache.Store(frame);
+            latency.Record(LatencyStage::STORED, hal::NowUs() - frame.timestamp_us);
+            if (CAN_RECORDER_ENABLE) {
+                recorder.Record(frame);
+            }
+            if (CAN_GATEWAY_ENABLE) {
+                gateway.Submit(frame);
+            }
+        });
+        if (CAN_GATEWAY_ENABLE) {
+            gateway.Flush();
         }
 
-        if (auto val = CAN.HandleRPM()) {
-            can_data.rpm_value = val;
-        }
-        if (auto value = CAN.HandleSpeed()) {
-            can_data.speed_value = value;
-        }
-        if (auto value = CAN.HandleFuel()) {
-            can_data.fuel_value = value;
-        }
-        if (auto value = CAN.HandleTemp()) {
-            can_data.temp_value = value;
+        if (hal::NowUs() - last_stats >= STATS_PERIOD_US) {
+            last_stats = hal::NowUs();
+            logRxStats(CAN.GetRxStats());
+            logMergeStats(CAN.GetMergeStats());
+            logControllerHealth(CAN);
+            for (uint8_t bus = 0; bus < CAN_BUS_COUNT; bus++) {
+                if (CanRecovery *recovery = CAN.Recovery(bus)) {
+                    recovery->LogStats("CAN ALERT", last_stats);
+                }
+            }
+            if (CAN_GATEWAY_ENABLE) {
+                CAN.TxRecovery().LogStats("CAN ALERT", last_stats);
+            }
+            CAN.IdStats().LogStats("CAN ID", last_stats);
+            if (CAN_RECORDER_ENABLE) {
+                recorder.LogStats();
+            }
         }
-        xQueueOverwrite(can_queue, &can_data);
-
-        //Every x ms the queue is overwritten with new data
-        vTaskDelay(pdMS_TO_TICKS(5)); // x ms delay keeps scheduler happy
     }
 }
 
 extern "C" void ui_task(void * /*task_param*/) {
-    can_data_t can_data;
-
-    lvglInit();
-    bsp_display_lock(1);
-    MainDisplay dashboard;
-    dashboard.SetupRpmArc();
-    dashboard.SetupSpeedArc();
-    dashboard.SetupFuelArc();
-    dashboard.SetupTempArc();
-    dashboard.RunArcAnimation();
-    bsp_display_unlock();
+    WarmStart warm_start(warm_region, ramKept(esp_reset_reason()));
+    assets.Open("assets");
+    // The panel shows the dash before LVGL is up when an earlier boot of this build and skin left its background
+    const lv_image_dsc_t *background = splash.Open(BSP_LCD_H_RES, BSP_LCD_V_RES, assets.Id());
+    if (background && hal::PanelInit() && hal::PanelShow(background)) {
+        boot.Mark(BootPhase::SPLASH_SHOWN);
+    }
+    hal::DisplayInit(background);
+    boot.Mark(BootPhase::LVGL_UP);
+    DashboardUi ui(frame_cache, latency, warm_start, boot);
+    // The dash image is only decoded when there is no splash to stand in for it
+    ui.Setup(background ? nullptr : assets.Image("dash_bg"), background);
 
-    while (true) {
-        // dashboard.HideOnTouch();
-        if (xQueueReceive(can_queue, &can_data, pdMS_TO_TICKS(50)) == pdTRUE) {
-            bsp_display_lock(0);
-
-            dashboard.SetRPMValue(can_data.rpm_value);
-            dashboard.SetSpeedValue(can_data.speed_value);
-            dashboard.SetFuelValue(can_data.fuel_value);
-            dashboard.SetTempValue(can_data.temp_value);
-
-            bsp_display_unlock();
-        } else {
-            ESP_LOGE("UI FATAL", "Not receiving data from the Queue");
-            vTaskDelay(pdMS_TO_TICKS(10));
-            continue;
+    if (!background) {
+        // Rendered this boot, keep it for the next ones once the dash is up
+        while (!boot.Reached(BootPhase::FIRST_FRAME)) {
+            hal::SleepMs(100);
         }
-        vTaskDelay(pdMS_TO_TICKS(16));
+        hal::DisplayLock(0);
+        const lv_draw_buf_t *rendered = ui.Background();
+        hal::DisplayUnlock();
+        splash.Save(rendered);
+    }
+
+    // Updates run from the display refresh itself, this task is left with the stats
+    while (true) {
+        hal::SleepMs(STATS_PERIOD_US / 1000);
+        ui.LogStats();
     }
 }
 
 extern "C" void app_main(void) {
-    can_queue = xQueueCreate(1, sizeof(can_data_t));
-    xTaskCreatePinnedToCore(can_task, "CAN TASK", 4096, nullptr, 5, nullptr, 0);
-    xTaskCreatePinnedToCore(ui_task, "UI/LVGL TASK", 8192, nullptr, 4, nullptr, 1);
+    boot.Mark(BootPhase::APP_MAIN);
+    hal::TaskCreate(can_task, "CAN TASK", 4096, nullptr, 5, 0);
+    hal::TaskCreate(ui_task, "UI/LVGL TASK", 8192, nullptr, 4, 1);
+    trip.Start(1, 1);
+    LatencyConsole::Start(latency);
 }